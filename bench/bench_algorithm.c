@@ -0,0 +1,87 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "algorithm.h"
+#include "clock.h"
+
+/**
+ * Replaying one algorithm over a batch of states, move by move against its
+ * compiled form, for algorithms of growing length (a commutator repeated).
+ * The compiled cost should not grow with the length. Also times a lookup
+ * in the compiled-algorithm cache and prints each algorithm's cycles and
+ * order.
+ *
+ *   bench_algorithm [state-count]
+ */
+
+#define DEFAULT_STATE_COUNT 1000000
+#define COMMUTATOR "R U R' U' "
+#define LOOKUPS 10000000
+
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_STATE_COUNT;
+    if (count == 0) {
+        fprintf(stderr, "Usage: bench_algorithm [state-count]\n");
+        return 1;
+    }
+
+    CubeState* moved = malloc(sizeof(CubeState) * count);
+    CubeState* compiled = malloc(sizeof(CubeState) * count);
+    char* text = malloc(sizeof(COMMUTATOR) * 64);
+    if (!moved || !compiled || !text) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    printf("%6s %14s %14s %8s  %s\n", "moves", "per move", "compiled", "order", "cycles");
+    for (int repeats = 1; repeats <= 64; repeats *= 4) {
+        text[0] = '\0';
+        for (int r = 0; r < repeats; r++) strcat(text, COMMUTATOR);
+        // One extra turn so the longer ones are not just powers of the first
+        strcat(text, "F");
+
+        uint8_t moves[ALGORITHM_MAX_MOVES];
+        int moveCount = parseAlgorithm(text, moves, ALGORITHM_MAX_MOVES);
+        const CompiledAlgorithm* algorithm = compiledAlgorithmGet(text);
+        if (moveCount < 0 || !algorithm) {
+            fprintf(stderr, "Failed to compile %s\n", text);
+            return 1;
+        }
+
+        for (size_t i = 0; i < count; i++) cubeStateInit(&moved[i]);
+        memcpy(compiled, moved, sizeof(CubeState) * count);
+
+        double start = clockSeconds();
+        cubeStatesApplyMoves(moved, count, moves, moveCount);
+        double movedTime = clockSeconds() - start;
+
+        start = clockSeconds();
+        cubeStatesApplyCompiled(compiled, count, algorithm);
+        double compiledTime = clockSeconds() - start;
+
+        if (memcmp(moved, compiled, sizeof(CubeState) * count) != 0) {
+            fprintf(stderr, "Compiled algorithm disagrees with its moves\n");
+            return 1;
+        }
+
+        AlgorithmCycle cycles[ALGORITHM_MAX_CYCLES];
+        char cycleText[256];
+        formatCycles(cycles, compiledAlgorithmCycles(algorithm, cycles), cycleText, sizeof(cycleText));
+        printf("%6d %9.1f M/s %9.1f M/s %8d  %s\n", moveCount, count / movedTime * 1e-6,
+               count / compiledTime * 1e-6, compiledAlgorithmOrder(algorithm), cycleText);
+    }
+
+    // Every string above is cached by now; this is the cost of finding one again
+    const char* keys[] = {COMMUTATOR "F", text};
+    size_t found = 0;
+    double start = clockSeconds();
+    for (int i = 0; i < LOOKUPS; i++) found += compiledAlgorithmGet(keys[i & 1]) != NULL;
+    double lookupTime = clockSeconds() - start;
+    printf("cache lookup %.1f ns (%zu found)\n", lookupTime / LOOKUPS * 1e9, found);
+
+    compiledAlgorithmCacheClear();
+    free(text);
+    free(moved);
+    free(compiled);
+    return 0;
+}
@@ -0,0 +1,63 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "algorithm.h"
+#include "clock.h"
+
+/**
+ * Throughput of the non-animated sequence API: one long sequence on a single
+ * state (moves/sec), and one scramble over a large array of states
+ * (states/sec and moves/sec).
+ */
+
+#define SINGLE_MOVES 50000000
+#define STATE_COUNT 1000000
+
+int main(void) {
+    const char* scramble = "R U R' U' F2 D L' B2 U2 R D' F L2 B' U R2 D2 F' L U'";
+
+    uint8_t scrambleMoves[ALGORITHM_MAX_MOVES];
+    int scrambleLength = parseAlgorithm(scramble, scrambleMoves, ALGORITHM_MAX_MOVES);
+    if (scrambleLength < 0) {
+        fprintf(stderr, "Failed to parse scramble\n");
+        return 1;
+    }
+
+    uint8_t* moves = malloc(SINGLE_MOVES);
+    srand(7);
+    for (int i = 0; i < SINGLE_MOVES; i++) {
+        moves[i] = (uint8_t)(rand() % MOVE_COUNT);
+    }
+
+    CubeState state;
+    cubeStateInit(&state);
+    double start = clockSeconds();
+    cubeStateApplyMoves(&state, moves, SINGLE_MOVES);
+    double singleSeconds = clockSeconds() - start;
+
+    CubeState* states = malloc(sizeof(CubeState) * STATE_COUNT);
+    for (int i = 0; i < STATE_COUNT; i++) {
+        cubeStateInit(&states[i]);
+    }
+    start = clockSeconds();
+    cubeStatesApplyMoves(states, STATE_COUNT, scrambleMoves, scrambleLength);
+    double batchSeconds = clockSeconds() - start;
+
+    start = clockSeconds();
+    int parsed = 0;
+    for (int i = 0; i < 1000000; i++) {
+        parsed += parseAlgorithm(scramble, scrambleMoves, ALGORITHM_MAX_MOVES);
+    }
+    double parseSeconds = clockSeconds() - start;
+
+    printf("single state:  %d moves in %.3fs, %.1fM moves/sec\n",
+           SINGLE_MOVES, singleSeconds, SINGLE_MOVES / singleSeconds / 1e6);
+    printf("state array:   %d states x %d moves in %.3fs, %.1fM states/sec, %.1fM moves/sec\n",
+           STATE_COUNT, scrambleLength, batchSeconds,
+           STATE_COUNT / batchSeconds / 1e6, (double)STATE_COUNT * scrambleLength / batchSeconds / 1e6);
+    printf("parse:         %.1fM moves/sec of notation\n", parsed / parseSeconds / 1e6);
+    printf("(checksum %d)\n", state.cp[0] + states[STATE_COUNT - 1].ep[0]);
+
+    free(states);
+    free(moves);
+    return 0;
+}
@@ -0,0 +1,50 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "bigcube.h"
+#include "clock.h"
+
+/**
+ * Slice turns per second on N x N x N cubes. A turn walks only its slice's
+ * 4-cycles, so the cost grows with N^2 (one face plus a 4N ring) rather
+ * than with the 6N^2 stickers or N^3 cubies.
+ */
+
+#define MOVES 2000000
+
+int main(void) {
+    static const int sizes[] = {2, 3, 4, 5, 7, 10, 17, 33, 64};
+    LayerMove* moves = malloc(sizeof(LayerMove) * MOVES);
+
+    printf("%-6s %12s %14s %16s\n", "size", "init ms", "turns/sec", "stickers/turn");
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        int size = sizes[s];
+        BigCube cube;
+
+        double start = clockSeconds();
+        if (!bigCubeInit(&cube, size)) {
+            fprintf(stderr, "Failed to create a %dx%dx%d cube\n", size, size, size);
+            return 1;
+        }
+        double initSeconds = clockSeconds() - start;
+
+        srand(11);
+        for (int i = 0; i < MOVES; i++) {
+            moves[i].axis = (uint8_t)(rand() % 3);
+            moves[i].layer = (uint8_t)(rand() % size);
+            moves[i].turns = (uint8_t)(1 + rand() % 3);
+        }
+
+        start = clockSeconds();
+        for (int i = 0; i < MOVES; i++) {
+            bigCubeApplyMove(&cube, moves[i]);
+        }
+        double seconds = clockSeconds() - start;
+
+        printf("%-6d %12.2f %14.0f %16.1f (checksum %d)\n", size, initSeconds * 1e3, MOVES / seconds,
+               (double)cube.cycleOffset[3 * size] / (3 * size), cube.stickers[0]);
+        bigCubeFree(&cube);
+    }
+
+    free(moves);
+    return 0;
+}
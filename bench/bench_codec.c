@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "statecodec.h"
+#include "clock.h"
+
+/**
+ * State codec throughput over a fixed set of random states (same seed every
+ * run): batch rank and unrank in states/sec, and the Zobrist hash kept up
+ * to date per move against recomputing it from scratch.
+ *
+ *   bench_codec [state-count]
+ */
+
+#define DEFAULT_STATE_COUNT 1000000
+#define HASH_MOVES 10000000
+
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_STATE_COUNT;
+    if (count == 0) {
+        fprintf(stderr, "Usage: bench_codec [state-count]\n");
+        return 1;
+    }
+
+    CubeState* states = malloc(sizeof(CubeState) * count);
+    CubeState* decoded = malloc(sizeof(CubeState) * count);
+    CubeRank* ranks = malloc(sizeof(CubeRank) * count);
+    if (!states || !decoded || !ranks) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    srand(2024);
+    CubeState state;
+    cubeStateInit(&state);
+    for (size_t i = 0; i < count; i++) {
+        for (int j = 0; j < 3; j++) cubeStateApplyMove(&state, (Move)(rand() % MOVE_COUNT));
+        states[i] = state;
+    }
+
+    double start = clockSeconds();
+    cubeStatesRank(states, count, ranks);
+    double rankTime = clockSeconds() - start;
+
+    start = clockSeconds();
+    size_t decodedCount = cubeStatesUnrank(ranks, count, decoded);
+    double unrankTime = clockSeconds() - start;
+
+    for (size_t i = 0; i < count; i++) {
+        if (i >= decodedCount || !cubeStateEquals(&states[i], &decoded[i])) {
+            fprintf(stderr, "State %zu did not round-trip\n", i);
+            return 1;
+        }
+    }
+    printf("rank   %.1f M states/s\n", count / rankTime * 1e-6);
+    printf("unrank %.1f M states/s\n", count / unrankTime * 1e-6);
+
+    // Same moves both ways; the sums keep the work from being optimised out
+    uint8_t* moves = malloc(HASH_MOVES);
+    for (int i = 0; i < HASH_MOVES; i++) moves[i] = (uint8_t)(rand() % MOVE_COUNT);
+
+    cubeStateInit(&state);
+    uint64_t hash = cubeStateHash(&state), fullSum = 0, incrementalSum = 0;
+    start = clockSeconds();
+    for (int i = 0; i < HASH_MOVES; i++) {
+        hash = cubeStateApplyMoveHashed(&state, hash, (Move)moves[i]);
+        incrementalSum += hash;
+    }
+    double incrementalTime = clockSeconds() - start;
+
+    cubeStateInit(&state);
+    start = clockSeconds();
+    for (int i = 0; i < HASH_MOVES; i++) {
+        cubeStateApplyMove(&state, (Move)moves[i]);
+        fullSum += cubeStateHash(&state);
+    }
+    double fullTime = clockSeconds() - start;
+
+    if (fullSum != incrementalSum) {
+        fprintf(stderr, "Incremental hash diverged\n");
+        return 1;
+    }
+    printf("move + hash: incremental %.1f M moves/s, full %.1f M moves/s\n",
+           HASH_MOVES / incrementalTime * 1e-6, HASH_MOVES / fullTime * 1e-6);
+
+    free(moves);
+    free(states);
+    free(decoded);
+    free(ranks);
+    return 0;
+}
@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cubefarm.h"
+#include "clock.h"
+
+/**
+ * Cube farm update and culling throughput, the CPU side of the stress
+ * scene: a farm of FARM_CUBES cubes stepped at 60 Hz for FARM_SECONDS of
+ * simulated time on one thread, then split into one range per worker of
+ * the pool, then culled against a frustum seeing about half the grid.
+ * Scripts are reversed scrambles, so no solver tables are needed. Every
+ * resting cube must be solved at the end, or the bench fails.
+ */
+
+#define FARM_CUBES 100000
+#define FARM_SCRIPTS 64
+#define FARM_SECONDS 10
+#define FARM_RATE 60
+
+typedef struct {
+    CubeFarm* farm;
+    int first, last;
+} FarmRange;
+
+static void updateRange(void* arg, int worker) {
+    (void)worker;
+    FarmRange* range = arg;
+    cubeFarmUpdate(range->farm, range->first, range->last, 1.0f / FARM_RATE);
+}
+
+static int unsolvedResting(const CubeFarm* farm) {
+    FaceletCube solved;
+    faceletCubeInit(&solved);
+    int unsolved = 0;
+    for (int i = 0; i < farm->count; i++) {
+        const FarmCube* cube = &farm->cubes[i];
+        if (cube->step >= farm->scripts[cube->script].length && memcmp(&cube->facelets, &solved, sizeof(solved)) != 0) {
+            unsolved++;
+        }
+    }
+    return unsolved;
+}
+
+int main(void) {
+    CubeFarm farm;
+    if (!cubeFarmInit(&farm, FARM_CUBES, FARM_SCRIPTS, 0.15f)) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    cubeFarmBuildScripts(&farm, NULL, NULL, 2024);
+    cubeFarmStart(&farm, 2024);
+
+    int frames = FARM_SECONDS * FARM_RATE;
+    long landed = 0;
+    double start = clockSeconds();
+    for (int frame = 0; frame < frames; frame++) {
+        landed += cubeFarmUpdate(&farm, 0, farm.count, 1.0f / FARM_RATE);
+    }
+    double singleSeconds = clockSeconds() - start;
+
+    WorkPool pool;
+    if (!workPoolInit(&pool, 0)) return 1;
+    FarmRange* ranges = malloc(sizeof(FarmRange) * (size_t)pool.threads);
+    for (int i = 0; i < pool.threads; i++) {
+        ranges[i] = (FarmRange){&farm, (int)((long)farm.count * i / pool.threads), (int)((long)farm.count * (i + 1) / pool.threads)};
+    }
+    start = clockSeconds();
+    for (int frame = 0; frame < frames; frame++) {
+        for (int i = 0; i < pool.threads; i++) {
+            if (!workPoolSubmit(&pool, updateRange, &ranges[i])) updateRange(&ranges[i], -1);
+        }
+        workPoolWait(&pool);
+    }
+    double poolSeconds = clockSeconds() - start;
+
+    // Looking along +z from the grid's near edge: left, right, bottom, top, near, far
+    const float planes[6][4] = {
+        { 0.7071f, 0.0f, 0.7071f, 0.0f},
+        {-0.7071f, 0.0f, 0.7071f, 0.0f},
+        { 0.0f, 0.7071f, 0.7071f, 0.0f},
+        { 0.0f, -0.7071f, 0.7071f, 0.0f},
+        { 0.0f, 0.0f, 1.0f, 0.0f},
+        { 0.0f, 0.0f, -1.0f, 1000.0f},
+    };
+    int visible = 0;
+    start = clockSeconds();
+    for (int frame = 0; frame < FARM_RATE; frame++) {
+        for (int i = 0; i < farm.count; i++) visible += cubeFarmVisible(&farm.cubes[i], planes);
+    }
+    double cullSeconds = clockSeconds() - start;
+
+    double updates = (double)farm.count * frames;
+    printf("update, 1 thread:  %d cubes x %d frames in %.3fs, %.1fM cube updates/sec, %.1fM turns/sec\n",
+           farm.count, frames, singleSeconds, updates / singleSeconds / 1e6, landed / singleSeconds / 1e6);
+    printf("update, %d threads: %.3fs, %.1fM cube updates/sec, %.0f cubes per 60 FPS frame\n",
+           pool.threads, poolSeconds, updates / poolSeconds / 1e6, updates / poolSeconds / FARM_RATE);
+    printf("cull:              %.1fM cubes/sec, %d of %d visible\n",
+           (double)farm.count * FARM_RATE / cullSeconds / 1e6, visible / FARM_RATE, farm.count);
+
+    int unsolved = unsolvedResting(&farm);
+    if (unsolved > 0) printf("%d resting cubes are not solved\n", unsolved);
+
+    workPoolDestroy(&pool);
+    free(ranges);
+    cubeFarmFree(&farm);
+    return unsolved == 0 ? 0 : 1;
+}
@@ -0,0 +1,116 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "movelog.h"
+#include "clock.h"
+
+/**
+ * Move log round trip: random turns recorded through the buffered writer
+ * (time per append on the caller's thread, bytes per turn), then the file
+ * mapped and replayed headless at full speed and checked against the same
+ * turns applied directly.
+ *
+ *   bench_movelog [turns] [cube-size] [log-file]
+ *   bench_movelog --replay log-file
+ *
+ * The second form replays an existing log (a recorded session, say) and
+ * reports how many turns it holds, how long the session ran and whether it
+ * ends solved.
+ */
+
+#define DEFAULT_TURNS 10000000
+#define DEFAULT_SIZE 3
+#define DEFAULT_LOG_PATH "bench.movelog"
+
+static int replayOnly(const char* path) {
+    MoveLog log;
+    if (!moveLogOpen(&log, path)) return 1;
+
+    BigCube cube;
+    if (!bigCubeInit(&cube, log.cubeSize)) {
+        moveLogClose(&log);
+        return 1;
+    }
+
+    double start = clockSeconds();
+    size_t turns = moveLogReplay(&log, &cube);
+    double seconds = clockSeconds() - start;
+
+    MoveLogCursor cursor = {0, 0};
+    LayerMove move;
+    while (moveLogNext(&log, &cursor, &move)) {}
+    printf("%zu turns on a %d-cube over %.1f s of session, replayed in %.3f s (%.1f M turns/s), %s\n",
+           turns, log.cubeSize, cursor.time / 1000.0, seconds, turns / seconds * 1e-6,
+           bigCubeIsSolved(&cube) ? "solved" : "not solved");
+    if (cursor.offset != log.size) printf("%zu bytes at the end do not decode\n", log.size - cursor.offset);
+
+    bigCubeFree(&cube);
+    moveLogClose(&log);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 2 && strcmp(argv[1], "--replay") == 0) return replayOnly(argv[2]);
+
+    size_t turns = argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_TURNS;
+    int size = argc > 2 ? atoi(argv[2]) : DEFAULT_SIZE;
+    const char* path = argc > 3 ? argv[3] : DEFAULT_LOG_PATH;
+
+    BigCube expected, replayed;
+    if (turns == 0 || !bigCubeInit(&expected, size) || !bigCubeInit(&replayed, size)) {
+        fprintf(stderr, "Usage: bench_movelog [turns] [cube-size] [log-file] | --replay log-file\n");
+        return 1;
+    }
+
+    // Turns and think times up front, so only the appends are timed
+    LayerMove* moves = malloc(sizeof(LayerMove) * turns);
+    uint64_t* times = malloc(sizeof(uint64_t) * turns);
+    if (!moves || !times) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    srand(2024);
+    uint64_t time = 0;
+    for (size_t i = 0; i < turns; i++) {
+        moves[i].axis = (uint8_t)(rand() % 3);
+        moves[i].layer = (uint8_t)(rand() % size);
+        moves[i].turns = (uint8_t)(rand() % 3 + 1);
+        time += (uint64_t)(rand() % 400);
+        times[i] = time;
+    }
+
+    MoveLogWriter writer;
+    if (!moveLogWriterOpen(&writer, path, size, 0)) return 1;
+    double start = clockSeconds();
+    for (size_t i = 0; i < turns; i++) moveLogWriterAppend(&writer, moves[i], times[i]);
+    double appendTime = clockSeconds() - start;
+    bool written = moveLogWriterClose(&writer);
+    double closeTime = clockSeconds() - start - appendTime;
+    if (!written) {
+        fprintf(stderr, "Failed to write %s\n", path);
+        return 1;
+    }
+
+    for (size_t i = 0; i < turns; i++) bigCubeApplyMove(&expected, moves[i]);
+
+    MoveLog log;
+    if (!moveLogOpen(&log, path)) return 1;
+    start = clockSeconds();
+    size_t replayedTurns = moveLogReplay(&log, &replayed);
+    double replayTime = clockSeconds() - start;
+
+    bool match = replayedTurns == turns && memcmp(expected.stickers, replayed.stickers, (size_t)expected.stickerCount) == 0;
+    printf("record: %.1f ns per turn on the caller, %.2f bytes per turn, %.3f s to drain on close\n",
+           appendTime / turns * 1e9, (double)log.size / turns, closeTime);
+    printf("replay: %zu turns in %.3f s, %.1f M turns/s, %s\n",
+           replayedTurns, replayTime, replayedTurns / replayTime * 1e-6, match ? "final state matches" : "MISMATCH");
+
+    moveLogClose(&log);
+    unlink(path);
+    bigCubeFree(&expected);
+    bigCubeFree(&replayed);
+    free(moves);
+    free(times);
+    return match ? 0 : 1;
+}
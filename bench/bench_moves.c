@@ -0,0 +1,151 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cubestate.h"
+#include "facelets.h"
+#include "clock.h"
+
+/**
+ * Moves per second of the table-driven cubie and facelet paths against the
+ * float Cubelet path that updateCubelets used to finish every turn with
+ * (rotation matrix, roundf snapping and the rotateFaceColors if/else ladder).
+ * The legacy path is reproduced here with plain float math so the benchmark
+ * does not need cglm.
+ */
+
+#define MOVES 2000000
+
+typedef struct {
+    float position[3];
+    float face_colors[6][3];
+} LegacyCubelet;
+
+static void copy3(const float* src, float* dst) {
+    dst[0] = src[0]; dst[1] = src[1]; dst[2] = src[2];
+}
+
+static void legacyRotateFaceColors(LegacyCubelet* c, const float* axis, int clockwise) {
+    float old[6][3];
+    memcpy(old, c->face_colors, sizeof(old));
+
+    if (fabsf(axis[0]) > 0.5f) {
+        if ((axis[0] > 0) == (clockwise != 0)) {
+            copy3(old[0], c->face_colors[4]); copy3(old[4], c->face_colors[1]);
+            copy3(old[1], c->face_colors[5]); copy3(old[5], c->face_colors[0]);
+        } else {
+            copy3(old[4], c->face_colors[0]); copy3(old[0], c->face_colors[5]);
+            copy3(old[5], c->face_colors[1]); copy3(old[1], c->face_colors[4]);
+        }
+    } else if (fabsf(axis[1]) > 0.5f) {
+        if ((axis[1] > 0) == (clockwise != 0)) {
+            copy3(old[2], c->face_colors[0]); copy3(old[0], c->face_colors[3]);
+            copy3(old[3], c->face_colors[1]); copy3(old[1], c->face_colors[2]);
+        } else {
+            copy3(old[0], c->face_colors[2]); copy3(old[2], c->face_colors[1]);
+            copy3(old[1], c->face_colors[3]); copy3(old[3], c->face_colors[0]);
+        }
+    } else if (fabsf(axis[2]) > 0.5f) {
+        if ((axis[2] > 0) == (clockwise != 0)) {
+            copy3(old[4], c->face_colors[3]); copy3(old[3], c->face_colors[5]);
+            copy3(old[5], c->face_colors[2]); copy3(old[2], c->face_colors[4]);
+        } else {
+            copy3(old[3], c->face_colors[4]); copy3(old[4], c->face_colors[2]);
+            copy3(old[2], c->face_colors[5]); copy3(old[5], c->face_colors[3]);
+        }
+    }
+}
+
+static void legacyTurn(LegacyCubelet* cubelets, const float* axis, int clockwise) {
+    int axis_index = (axis[0] != 0.0f) ? 0 : (axis[1] != 0.0f) ? 1 : 2;
+    float face_coord = axis[axis_index] > 0 ? 1.0f : -1.0f;
+
+    // Rodrigues rotation matrix, as glm_rotate builds it
+    float angle = clockwise ? (float)M_PI_2 : -(float)M_PI_2;
+    float c = cosf(angle), s = sinf(angle), t = 1.0f - c;
+    float x = axis[0], y = axis[1], z = axis[2];
+    float m[3][3] = {
+        {t * x * x + c,     t * x * y - s * z, t * x * z + s * y},
+        {t * x * y + s * z, t * y * y + c,     t * y * z - s * x},
+        {t * x * z - s * y, t * y * z + s * x, t * z * z + c},
+    };
+
+    for (int i = 0; i < 27; i++) {
+        LegacyCubelet* cubelet = &cubelets[i];
+        if (fabsf(cubelet->position[axis_index] - face_coord) < 0.1f) {
+            float p[3];
+            for (int r = 0; r < 3; r++) {
+                p[r] = m[r][0] * cubelet->position[0] + m[r][1] * cubelet->position[1] + m[r][2] * cubelet->position[2];
+            }
+            for (int r = 0; r < 3; r++) cubelet->position[r] = roundf(p[r]);
+            legacyRotateFaceColors(cubelet, axis, clockwise);
+        }
+    }
+}
+
+int main(void) {
+    static const float axes[FACE_COUNT][3] = {
+        {0, 0, 1}, {0, 0, -1}, {-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0},
+    };
+
+    uint8_t* moves = malloc(MOVES);
+    srand(42);
+    for (int i = 0; i < MOVES; i++) {
+        // Quarter turns only, the legacy path cannot do anything else
+        moves[i] = (uint8_t)moveFromFace((FaceID)(rand() % FACE_COUNT), rand() % 2 ? 1 : 3);
+    }
+
+    LegacyCubelet cubelets[27];
+    int index = 0;
+    for (int x = -1; x <= 1; x++) {
+        for (int y = -1; y <= 1; y++) {
+            for (int z = -1; z <= 1; z++) {
+                cubelets[index].position[0] = (float)x;
+                cubelets[index].position[1] = (float)y;
+                cubelets[index].position[2] = (float)z;
+                for (int f = 0; f < 6; f++) {
+                    for (int k = 0; k < 3; k++) cubelets[index].face_colors[f][k] = (float)f;
+                }
+                index++;
+            }
+        }
+    }
+
+    double start = clockSeconds();
+    for (int i = 0; i < MOVES; i++) {
+        legacyTurn(cubelets, axes[moveFace(moves[i])], moveQuarterTurns(moves[i]) == 3);
+    }
+    double legacySeconds = clockSeconds() - start;
+
+    CubeState state;
+    cubeStateInit(&state);
+    start = clockSeconds();
+    for (int i = 0; i < MOVES; i++) {
+        cubeStateApplyMove(&state, (Move)moves[i]);
+    }
+    double cubieSeconds = clockSeconds() - start;
+
+    FaceletCube facelets;
+    faceletCubeInit(&facelets);
+    start = clockSeconds();
+    for (int i = 0; i < MOVES; i++) {
+        faceletCubeApplyMove(&facelets, (Move)moves[i]);
+    }
+    double faceletSeconds = clockSeconds() - start;
+
+    FaceletCube check;
+    cubeStateToFacelets(&state, &check);
+    if (memcmp(&check, &facelets, sizeof(check)) != 0) {
+        fprintf(stderr, "cubie and facelet paths disagree\n");
+        return 1;
+    }
+
+    printf("%-22s %14s %10s\n", "path", "moves/sec", "speedup");
+    printf("%-22s %14.0f %9.1fx\n", "legacy float cubelets", MOVES / legacySeconds, 1.0);
+    printf("%-22s %14.0f %9.1fx\n", "cubie table", MOVES / cubieSeconds, legacySeconds / cubieSeconds);
+    printf("%-22s %14.0f %9.1fx\n", "facelet table", MOVES / faceletSeconds, legacySeconds / faceletSeconds);
+    printf("(checksum %d)\n", (int)cubelets[0].position[0] + facelets.f[0]);
+
+    free(moves);
+    return 0;
+}
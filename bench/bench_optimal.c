@@ -0,0 +1,107 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "optimal.h"
+#include "clock.h"
+
+/**
+ * Optimal solver throughput: a fixed set of random-move scrambles (same seed
+ * every run) solved optimally at each thread count, reporting the solution
+ * lengths, nodes searched, nodes/sec and the speedup over the first count.
+ *
+ *   bench_optimal [scramble-length] [count] [threads,...] [htm|qtm] [table-file]
+ *
+ * Threads default to 1, 2, 4, ... up to the number of CPUs. The pattern
+ * databases are mapped from the table file, built and saved first if it is
+ * missing (a few minutes).
+ */
+
+#define DEFAULT_SCRAMBLE_LENGTH 12
+#define DEFAULT_COUNT 10
+#define DEFAULT_TABLE_PATH "rubik-optimal.tables"
+#define MAX_THREAD_COUNTS 16
+
+static int parseThreadCounts(const char* text, int* counts) {
+    int count = 0;
+    if (!text) {
+        for (int t = 1; t <= workPoolDefaultThreads() && count < MAX_THREAD_COUNTS; t *= 2) counts[count++] = t;
+        return count;
+    }
+    for (const char* p = text; *p && count < MAX_THREAD_COUNTS; ) {
+        int threads = atoi(p);
+        if (threads > 0) counts[count++] = threads;
+        p = strchr(p, ',');
+        if (!p) break;
+        p++;
+    }
+    return count;
+}
+
+int main(int argc, char* argv[]) {
+    int scrambleLength = argc > 1 ? atoi(argv[1]) : DEFAULT_SCRAMBLE_LENGTH;
+    int count = argc > 2 ? atoi(argv[2]) : DEFAULT_COUNT;
+    int threadCounts[MAX_THREAD_COUNTS];
+    int threadCountCount = parseThreadCounts(argc > 3 ? argv[3] : NULL, threadCounts);
+    Metric metric = argc > 4 && strcmp(argv[4], "qtm") == 0 ? METRIC_QTM : METRIC_HTM;
+    const char* tablePath = argc > 5 ? argv[5] : DEFAULT_TABLE_PATH;
+    if (count < 1 || threadCountCount == 0) {
+        fprintf(stderr, "Usage: bench_optimal [scramble-length] [count] [threads,...] [htm|qtm] [table-file]\n");
+        return 1;
+    }
+
+    PatternDatabase pdb;
+    double start = clockSeconds();
+    if (!patternDatabaseInitCached(&pdb, tablePath, 0)) {
+        fprintf(stderr, "Failed to set up pattern databases\n");
+        return 1;
+    }
+    printf("pattern databases %s in %.3f s\n", pdb.store.mapping ? "mapped" : "built", clockSeconds() - start);
+
+    CubeState* scrambles = malloc(sizeof(CubeState) * count);
+    srand(2024);
+    for (int i = 0; i < count; i++) {
+        cubeStateInit(&scrambles[i]);
+        for (int j = 0; j < scrambleLength; j++) {
+            cubeStateApplyMove(&scrambles[i], (Move)(rand() % MOVE_COUNT));
+        }
+    }
+
+    double baseRate = 0.0;
+    for (int t = 0; t < threadCountCount; t++) {
+        WorkPool pool;
+        if (!workPoolInit(&pool, threadCounts[t])) {
+            fprintf(stderr, "Failed to start %d threads\n", threadCounts[t]);
+            return 1;
+        }
+
+        uint64_t nodes = 0;
+        double seconds = 0.0;
+        long totalLength = 0;
+        for (int i = 0; i < count; i++) {
+            uint8_t moves[OPTIMAL_MAX_LENGTH];
+            OptimalStats stats;
+            int length = optimalSolve(&pdb, &scrambles[i], metric, OPTIMAL_MAX_LENGTH, &pool, moves, &stats);
+
+            CubeState check = scrambles[i];
+            if (length >= 0) cubeStateApplyMoves(&check, moves, length);
+            if (length < 0 || !cubeStateIsSolved(&check)) {
+                fprintf(stderr, "Scramble %d was not solved\n", i);
+                return 1;
+            }
+            nodes += stats.nodes;
+            seconds += stats.seconds;
+            totalLength += length;
+        }
+        workPoolDestroy(&pool);
+
+        double rate = nodes / seconds;
+        if (t == 0) baseRate = rate;
+        printf("%2d threads: %d scrambles, mean length %.2f %s, %.3f s, %llu nodes, %.2f Mnodes/s, speedup %.2f\n",
+               threadCounts[t], count, (double)totalLength / count, metric == METRIC_QTM ? "qtm" : "htm",
+               seconds, (unsigned long long)nodes, rate * 1e-6, rate / baseRate);
+    }
+
+    free(scrambles);
+    patternDatabaseFree(&pdb);
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "algorithm.h"
+#include "faceletbatch.h"
+#include "clock.h"
+
+/**
+ * One scramble applied to a large batch of facelet cubes, per kernel,
+ * against the per-cube facelet and cubie paths.
+ */
+
+#define CUBE_COUNT 1000000
+#define ROUNDS 5
+
+static void report(const char* name, double seconds, int moveCount) {
+    double states = (double)CUBE_COUNT * ROUNDS;
+    printf("%-16s %10.1fM states/sec %10.1fM moves/sec\n",
+           name, states / seconds / 1e6, states * moveCount / seconds / 1e6);
+}
+
+int main(void) {
+    uint8_t moves[ALGORITHM_MAX_MOVES];
+    int moveCount = parseAlgorithm("R U R' U' F2 D L' B2 U2 R D' F L2 B' U R2 D2 F' L U'",
+                                   moves, ALGORITHM_MAX_MOVES);
+
+    // Reference result for one cube
+    FaceletCube expected;
+    faceletCubeInit(&expected);
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < moveCount; i++) faceletCubeApplyMove(&expected, (Move)moves[i]);
+    }
+
+    FaceletCube* cubes = malloc(sizeof(FaceletCube) * CUBE_COUNT);
+    for (int i = 0; i < CUBE_COUNT; i++) faceletCubeInit(&cubes[i]);
+    double start = clockSeconds();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int c = 0; c < CUBE_COUNT; c++) {
+            for (int i = 0; i < moveCount; i++) faceletCubeApplyMove(&cubes[c], (Move)moves[i]);
+        }
+    }
+    report("facelet per-cube", clockSeconds() - start, moveCount);
+    free(cubes);
+
+    CubeState* states = malloc(sizeof(CubeState) * CUBE_COUNT);
+    for (int i = 0; i < CUBE_COUNT; i++) cubeStateInit(&states[i]);
+    start = clockSeconds();
+    for (int r = 0; r < ROUNDS; r++) {
+        cubeStatesApplyMoves(states, CUBE_COUNT, moves, moveCount);
+    }
+    report("cubie per-cube", clockSeconds() - start, moveCount);
+    free(states);
+
+    const FaceletKernel kernels[] = {FACELET_KERNEL_SCALAR, FACELET_KERNEL_SSE2, FACELET_KERNEL_AVX2};
+    for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+        if (!faceletKernelSupported(kernels[k])) {
+            printf("%-16s not supported on this CPU\n", faceletKernelName(kernels[k]));
+            continue;
+        }
+
+        FaceletBatch batch;
+        if (!faceletBatchInit(&batch, CUBE_COUNT)) {
+            fprintf(stderr, "Failed to allocate batch\n");
+            return 1;
+        }
+
+        start = clockSeconds();
+        for (int r = 0; r < ROUNDS; r++) {
+            faceletBatchApplyMovesWith(&batch, moves, moveCount, kernels[k]);
+        }
+        double seconds = clockSeconds() - start;
+
+        FaceletCube check;
+        faceletBatchGet(&batch, CUBE_COUNT - 1, &check);
+        if (memcmp(&check, &expected, sizeof(check)) != 0) {
+            fprintf(stderr, "%s kernel produced a wrong state\n", faceletKernelName(kernels[k]));
+            return 1;
+        }
+
+        char name[32];
+        snprintf(name, sizeof(name), "batch %s", faceletKernelName(kernels[k]));
+        report(name, seconds, moveCount);
+        faceletBatchFree(&batch);
+    }
+
+    return 0;
+}
@@ -0,0 +1,81 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "solver.h"
+#include "clock.h"
+
+/**
+ * Solve latency of the two-phase solver over a fixed set of random-move
+ * scrambles (same seed every run): table setup time once, then p50/p99/max
+ * solve time and the mean solution length.
+ *
+ *   bench_solver [target-length] [time-limit-seconds] [table-file]
+ *
+ * With a table file the tables are mapped from it (built and saved first if
+ * it is missing), so running twice shows the load time against the build.
+ */
+
+#define SCRAMBLE_COUNT 1000
+#define SCRAMBLE_LENGTH 40
+
+static int compareDouble(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double* sorted, int count, double p) {
+    int index = (int)(p * (count - 1) + 0.5);
+    return sorted[index];
+}
+
+int main(int argc, char* argv[]) {
+    int targetLength = argc > 1 ? atoi(argv[1]) : SOLVER_DEFAULT_TARGET_LENGTH;
+    double timeLimit = argc > 2 ? atof(argv[2]) : SOLVER_DEFAULT_TIME_LIMIT;
+
+    const char* tablePath = argc > 3 ? argv[3] : NULL;
+
+    Solver solver;
+    double start = clockSeconds();
+    bool ready = tablePath ? solverInitCached(&solver, tablePath, 0) : solverInit(&solver, 0);
+    if (!ready) {
+        fprintf(stderr, "Failed to set up solver tables\n");
+        return 1;
+    }
+    printf("tables %s in %.3f s\n", solver.store.mapping ? "mapped" : "built", clockSeconds() - start);
+
+    CubeState* scrambles = malloc(sizeof(CubeState) * SCRAMBLE_COUNT);
+    double* times = malloc(sizeof(double) * SCRAMBLE_COUNT);
+    srand(2024);
+    for (int i = 0; i < SCRAMBLE_COUNT; i++) {
+        cubeStateInit(&scrambles[i]);
+        for (int j = 0; j < SCRAMBLE_LENGTH; j++) {
+            cubeStateApplyMove(&scrambles[i], (Move)(rand() % MOVE_COUNT));
+        }
+    }
+
+    long totalLength = 0;
+    for (int i = 0; i < SCRAMBLE_COUNT; i++) {
+        uint8_t moves[SOLVER_MAX_LENGTH];
+        start = clockSeconds();
+        int length = solverSolve(&solver, &scrambles[i], targetLength, timeLimit, moves);
+        times[i] = clockSeconds() - start;
+
+        CubeState check = scrambles[i];
+        if (length >= 0) cubeStateApplyMoves(&check, moves, length);
+        if (length < 0 || !cubeStateIsSolved(&check)) {
+            fprintf(stderr, "Scramble %d was not solved\n", i);
+            return 1;
+        }
+        totalLength += length;
+    }
+
+    qsort(times, SCRAMBLE_COUNT, sizeof(double), compareDouble);
+    printf("%d scrambles, target %d moves, time limit %.0f ms\n", SCRAMBLE_COUNT, targetLength, timeLimit * 1e3);
+    printf("p50 %.2f ms  p99 %.2f ms  max %.2f ms  mean length %.2f\n",
+           percentile(times, SCRAMBLE_COUNT, 0.50) * 1e3, percentile(times, SCRAMBLE_COUNT, 0.99) * 1e3,
+           times[SCRAMBLE_COUNT - 1] * 1e3, (double)totalLength / SCRAMBLE_COUNT);
+
+    free(scrambles);
+    free(times);
+    solverFree(&solver);
+    return 0;
+}
@@ -0,0 +1,64 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "subgroup.h"
+
+/**
+ * Enumerate a subgroup breadth first and print how many positions lie at
+ * each distance from solved, with the time taken and positions/sec.
+ *
+ *   bench_subgroup [generators] [corners|edges|all] [threads]
+ *
+ * Generators are in standard notation, a quarter turn standing for every
+ * turn of its face: "R U F" with corners is the 2x2x2 (the default), "R U"
+ * with all is <R,U>, "U D F2 B2 L2 R2" is the domino group. Threads default
+ * to the number of CPUs.
+ */
+
+#define DEFAULT_GENERATORS "R U F"
+
+static SubgroupPieces parsePieces(const char* text) {
+    if (strcmp(text, "corners") == 0) return SUBGROUP_CORNERS;
+    if (strcmp(text, "edges") == 0) return SUBGROUP_EDGES;
+    if (strcmp(text, "all") == 0) return SUBGROUP_ALL;
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    const char* generators = argc > 1 ? argv[1] : DEFAULT_GENERATORS;
+    SubgroupPieces pieces = argc > 2 ? parsePieces(argv[2]) : SUBGROUP_CORNERS;
+    int threads = argc > 3 ? atoi(argv[3]) : 0;
+
+    Move moves[MOVE_COUNT];
+    int moveCount = subgroupParseGenerators(generators, moves);
+    Subgroup group;
+    if (moveCount < 0 || !pieces || !subgroupInit(&group, moves, moveCount, pieces)) {
+        fprintf(stderr, "Usage: bench_subgroup [generators] [corners|edges|all] [threads]\n");
+        return 1;
+    }
+
+    WorkPool pool;
+    if (!workPoolInit(&pool, threads)) {
+        subgroupFree(&group);
+        fprintf(stderr, "Failed to start the worker threads\n");
+        return 1;
+    }
+    printf("<%s> %s: %d moves, %d orbits, %llu ranks (%.1f MB visited set), %d threads\n",
+           generators, argc > 2 ? argv[2] : "corners", moveCount, group.orbitCount,
+           (unsigned long long)group.size, group.size / 4.0 / (1 << 20), pool.threads);
+
+    SubgroupStats stats;
+    bool complete = subgroupEnumerate(&group, &pool, &stats);
+    workPoolDestroy(&pool);
+    subgroupFree(&group);
+    if (!complete) {
+        fprintf(stderr, "Enumeration failed: out of memory or deeper than %d\n", SUBGROUP_MAX_DEPTH);
+        return 1;
+    }
+
+    printf("depth  positions\n");
+    for (int d = 0; d <= stats.depth; d++) printf("%5d  %llu\n", d, (unsigned long long)stats.counts[d]);
+    printf("total  %llu in %.3f s, %.1f M positions/s\n",
+           (unsigned long long)stats.total, stats.seconds, stats.total / stats.seconds * 1e-6);
+    return 0;
+}
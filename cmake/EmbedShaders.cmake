@@ -0,0 +1,38 @@
+# Writes every GLSL file in INPUTS into OUTPUT as a NUL-terminated char
+# array named after the file (shaders/vertex.glsl becomes vertexShaderSource),
+# plus embeddedShaders, a table of them by file name.
+# Run at build time through add_custom_command:
+#   cmake -DOUTPUT=shadersources.h "-DINPUTS=a.glsl;b.glsl" -P EmbedShaders.cmake
+
+# CMake regexes have no {n} repetition, so spell out one line of 16 bytes
+set(line "")
+foreach(i RANGE 15)
+    string(APPEND line "0x..,")
+endforeach()
+
+set(content "// Generated from the shaders/ directory by cmake/EmbedShaders.cmake, do not edit\n")
+string(APPEND content "#ifndef __SHADERSOURCES_H__\n#define __SHADERSOURCES_H__\n")
+
+set(table "")
+list(LENGTH INPUTS count)
+foreach(input ${INPUTS})
+    get_filename_component(file ${input} NAME)
+    get_filename_component(name ${input} NAME_WE)
+    string(APPEND table "    {\"${file}\", ${name}ShaderSource},\n")
+    file(READ ${input} bytes HEX)
+    string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," bytes "${bytes}")
+    string(REGEX REPLACE "(${line})" "\\1\n    " bytes "${bytes}")
+    string(APPEND content "\nstatic const char ${name}ShaderSource[] = {\n    ${bytes}0x00\n};\n")
+endforeach()
+
+string(APPEND content "\n#define EMBEDDED_SHADER_COUNT ${count}\n")
+string(APPEND content "\nstatic const struct {\n    const char* name;\n    const char* source;\n} embeddedShaders[EMBEDDED_SHADER_COUNT] = {\n${table}};\n")
+string(APPEND content "\n#endif  /** __SHADERSOURCES_H__ */\n")
+
+# Only touch the header when it changes, so an unrelated reconfigure rebuilds nothing
+if(EXISTS ${OUTPUT})
+    file(READ ${OUTPUT} previous)
+endif()
+if(NOT "${previous}" STREQUAL "${content}")
+    file(WRITE ${OUTPUT} "${content}")
+endif()
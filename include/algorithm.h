@@ -0,0 +1,60 @@
+#ifndef __ALGORITHM_H__
+#define __ALGORITHM_H__
+
+#include <stddef.h>
+#include "cubestate.h"
+#include "facelets.h"
+
+/**
+ * Move sequences in standard notation ("R U R' U' F2"). The binary form is
+ * one byte per move holding its Move value.
+ *
+ * A compiled algorithm is a whole sequence folded into one transform: the
+ * cubie state it leaves on a solved cube (one cubeStateMultiply applies it
+ * to any state) and the facelet gather it amounts to (one pass over 54
+ * stickers). Applying it costs the same however long the sequence was.
+ * compiledAlgorithmGet compiles each distinct string once and keeps it for
+ * the life of the process (or until compiledAlgorithmCacheClear); it is
+ * safe to call from several threads.
+ */
+
+#define ALGORITHM_MAX_MOVES 4096
+#define ALGORITHM_MAX_CYCLES (CORNER_COUNT + EDGE_COUNT)
+
+typedef struct {
+    CubeState transform;                    // The sequence applied to solved
+    uint8_t facelets[FACELET_COUNT];        // Facelet whose sticker lands on each facelet
+    int moveCount;                          // Moves folded in
+} CompiledAlgorithm;
+
+/**
+ * One cycle of the pieces an algorithm moves: the piece in slots[0] goes to
+ * slots[1] and so on round to slots[0], coming back twisted (flipped) by
+ * twist. A piece twisted in place is a cycle of length 1.
+ */
+typedef struct {
+    bool edges;
+    uint8_t length;
+    uint8_t twist;
+    uint8_t slots[EDGE_COUNT];
+} AlgorithmCycle;
+
+int parseAlgorithm(const char* text, uint8_t* moves, int maxMoves);
+int formatAlgorithm(const uint8_t* moves, int count, char* buffer, size_t size);
+bool cubeStateApplyAlgorithm(CubeState* state, const char* text);
+bool cubeStatesApplyAlgorithm(CubeState* states, size_t count, const char* text);
+
+void compileMoves(const uint8_t* moves, int count, CompiledAlgorithm* compiled);
+bool compileAlgorithm(const char* text, CompiledAlgorithm* compiled);
+const CompiledAlgorithm* compiledAlgorithmGet(const char* text);
+void compiledAlgorithmCacheClear(void);
+
+void cubeStateApplyCompiled(CubeState* state, const CompiledAlgorithm* compiled);
+void cubeStatesApplyCompiled(CubeState* states, size_t count, const CompiledAlgorithm* compiled);
+void faceletCubeApplyCompiled(FaceletCube* cube, const CompiledAlgorithm* compiled);
+
+int compiledAlgorithmCycles(const CompiledAlgorithm* compiled, AlgorithmCycle* cycles);
+int compiledAlgorithmOrder(const CompiledAlgorithm* compiled);
+int formatCycles(const AlgorithmCycle* cycles, int count, char* buffer, size_t size);
+
+#endif  /** __ALGORITHM_H__ */
@@ -0,0 +1,40 @@
+#ifndef __BATCHJOB_H__
+#define __BATCHJOB_H__
+
+#include "solver.h"
+
+/**
+ * One line in, one line out: the unit of work of the batch tools. An input
+ * line is an optional facelet string (see faceletCubeParse) followed by
+ * moves in standard notation, applied to it (or to the solved cube without
+ * one), so "R U R' U'", "UUUUUUUUURRR...BBB" and "<facelets> R2 D" all name
+ * a state. The command decides what comes back:
+ *   apply         the state as a facelet string
+ *   verify        "solved" or "unsolved"
+ *   solve         a solution, in notation (empty for a solved cube)
+ *   canonicalise  the facelet string of the smallest of the state's
+ *                 symmetry conjugates, the same for every equivalent state
+ * A line that names no state comes back as "error: " and the reason.
+ */
+
+#define BATCH_MAX_OUTPUT 256            // Longest result line, terminator included
+
+typedef enum {
+    BATCH_APPLY,
+    BATCH_VERIFY,
+    BATCH_SOLVE,
+    BATCH_CANONICALISE,
+} BatchCommand;
+
+typedef struct {
+    BatchCommand command;
+    const Solver* solver;               // Needed by BATCH_SOLVE only; shared, read-only
+    int targetLength;
+    double timeLimit;
+    bool antisymmetry;                  // Canonicalise over inverses too
+} BatchOptions;
+
+bool batchCommandFromName(const char* name, BatchCommand* command);
+bool batchProcessLine(const BatchOptions* options, const char* line, size_t length, char* out, size_t* outLength);
+
+#endif  /** __BATCHJOB_H__ */
@@ -0,0 +1,53 @@
+#ifndef __BIGCUBE_H__
+#define __BIGCUBE_H__
+
+#include "cubestate.h"
+
+/**
+ * Sticker-level N x N x N cube. Stickers are stored face by face in the same
+ * U, R, F, D, L, B order and reading direction as facelets.h, N * N per face,
+ * so a 3x3x3 BigCube holds exactly a FaceletCube. Each (axis, layer) slice
+ * keeps its own index lists, so a turn touches O(N^2) stickers instead of
+ * scanning the cube.
+ */
+
+#define BIGCUBE_MIN_SIZE 2
+#define BIGCUBE_MAX_SIZE 64
+
+/**
+ * A turn of one slice: axis 0/1/2 = X/Y/Z, layer 0..N-1 counted from the
+ * negative side, turns = quarter turns clockwise seen from the positive end
+ * of the axis (1..3).
+ */
+typedef struct {
+    uint8_t axis;
+    uint8_t layer;
+    uint8_t turns;
+} LayerMove;
+
+typedef struct {
+    int size;
+    int stickerCount;
+    uint8_t* stickers;          // FaceID colour of each sticker
+
+    // Per-slice index lists, slice = axis * size + layer
+    uint32_t* layerOffset;      // Start of each slice in layerStickers
+    uint32_t* layerStickers;    // Every sticker a slice carries
+    uint32_t* cycleOffset;      // Start of each slice in cycles
+    uint32_t* cycles;           // 4-cycles of one clockwise quarter turn
+} BigCube;
+
+bool bigCubeInit(BigCube* cube, int size);
+void bigCubeFree(BigCube* cube);
+void bigCubeReset(BigCube* cube);
+void bigCubeApplyMove(BigCube* cube, LayerMove move);
+bool bigCubeIsSolved(const BigCube* cube);
+const uint32_t* bigCubeLayerStickers(const BigCube* cube, int axis, int layer, int* count);
+
+LayerMove layerMoveFromFace(int size, FaceID face, int depth, int quarterTurns);
+LayerMove layerMoveFromMove(int size, Move move);
+
+FaceID stickerFace(int size, int sticker);
+void stickerPosition(int size, int sticker, int position[3]);
+
+#endif  /** __BIGCUBE_H__ */
@@ -0,0 +1,64 @@
+#ifndef __CAPTURE_H__
+#define __CAPTURE_H__
+
+#include <pthread.h>
+
+/**
+ * Frame capture (--capture path): every presented frame is read back and
+ * written out without the render loop waiting on the GPU or the disk.
+ *
+ * glReadPixels goes into the next of CAPTURE_PBOS pixel buffer objects and
+ * returns at once; a frame is only mapped when its buffer comes round
+ * again, CAPTURE_PBOS frames later, by which time its fence has long
+ * signalled. The mapped pixels are copied into one of CAPTURE_QUEUE_FRAMES
+ * buffers and a writer thread does the rest (flipping rows, dropping alpha,
+ * file I/O), so the loop only waits if the writer falls a whole queue
+ * behind. Waits of either kind are counted and reported.
+ *
+ * A path with a printf conversion for the frame number (frame%05d.ppm)
+ * gets one binary PPM per frame. Any other path, or - for stdout, gets a
+ * raw stream of top-down RGBA frames, e.g. for
+ *   ffmpeg -f rawvideo -pixel_format rgba -video_size 1000x800 -i - out.mp4
+ * Capturing to stdout moves the program's own output to stderr.
+ */
+
+#define CAPTURE_PBOS 3
+#define CAPTURE_QUEUE_FRAMES 8
+#define CAPTURE_STREAM_BUFFER (1 << 20)
+
+typedef enum {
+    CAPTURE_RAW,
+    CAPTURE_PPM,
+} CaptureFormat;
+
+typedef struct FrameCapture {
+    int width, height;
+    size_t frameBytes;                  // RGBA, as read back
+    CaptureFormat format;
+    char* pattern;                      // PPM file name pattern
+    FILE* stream;                       // Raw output
+    const char* name;                   // For messages
+
+    GLuint pbos[CAPTURE_PBOS];
+    GLsync fences[CAPTURE_PBOS];        // 0 when the buffer holds no frame
+    uint64_t issued;                    // Frames read back so far
+
+    // Guarded by lock: the writer takes frames from head, the loop adds after the last
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t filled, emptied;
+    uint8_t* queue[CAPTURE_QUEUE_FRAMES];
+    int head, count;
+    bool stopping, failed;
+    uint64_t written;
+
+    uint8_t* row;                       // Writer's RGB row for PPM
+    uint64_t fenceWaits, queueWaits;    // Times the loop had to wait
+    Uint64 start;
+} FrameCapture;
+
+bool startCapture(State* state, const char* path);
+void captureFrame(State* state);
+void stopCapture(State* state);
+
+#endif  /** __CAPTURE_H__ */
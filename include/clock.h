@@ -0,0 +1,7 @@
+#ifndef __CLOCK_H__
+#define __CLOCK_H__
+
+// Seconds on the monotonic clock, for timing and deadlines; only differences mean anything
+double clockSeconds(void);
+
+#endif  /** __CLOCK_H__ */
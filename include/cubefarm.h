@@ -0,0 +1,57 @@
+#ifndef __CUBEFARM_H__
+#define __CUBEFARM_H__
+
+#include "bigcube.h"
+#include "facelets.h"
+#include "solver.h"
+#include "workpool.h"
+
+/**
+ * Thousands of 3x3x3 cubes on a grid, each endlessly playing a script: a
+ * random scramble, then the solver's solution to it, then a short rest on
+ * the solved cube before the next script. Cubes only hold their facelets
+ * and where they are in their script, so updating one is a few bytes of
+ * arithmetic and a 54-byte permutation when a turn lands, and any range of
+ * cubes can be updated on its own thread. Scripts are shared: a farm has a
+ * few dozen and every cube starts at a random point of a random one.
+ *
+ * Nothing here draws; see the stress scene (src/stress.c) for that.
+ */
+
+#define CUBE_FARM_SCRAMBLE_LENGTH 20
+#define CUBE_FARM_MAX_SCRIPT (CUBE_FARM_SCRAMBLE_LENGTH + SOLVER_MAX_LENGTH)
+#define CUBE_FARM_REST_TURNS 4          // Turn durations spent solved between scripts
+#define CUBE_FARM_SPACING 4.0f          // Between neighbouring cube centres
+#define CUBE_FARM_RADIUS 2.6f           // Bounding sphere of a cube, mid-turn too: 1.5 * sqrt(3)
+
+typedef struct {
+    uint8_t moves[CUBE_FARM_MAX_SCRIPT];
+    int scrambleLength;
+    int length;                         // Scramble and solution: the script ends on the solved cube
+} FarmScript;
+
+typedef struct {
+    FaceletCube facelets;               // As of the last landed turn
+    float center[3];
+    float progress;                     // 0..1 through the turn (or rest) in flight
+    uint16_t script;
+    uint8_t step;                       // Script move in flight; length and beyond is resting
+} FarmCube;
+
+typedef struct {
+    int count;
+    FarmCube* cubes;
+    int scriptCount;
+    FarmScript* scripts;
+    float turnDuration;                 // Seconds per turn
+} CubeFarm;
+
+bool cubeFarmInit(CubeFarm* farm, int count, int scriptCount, float turnDuration);
+void cubeFarmFree(CubeFarm* farm);
+void cubeFarmBuildScripts(CubeFarm* farm, const Solver* solver, WorkPool* pool, uint32_t seed);
+void cubeFarmStart(CubeFarm* farm, uint32_t seed);
+int cubeFarmUpdate(CubeFarm* farm, int first, int last, float seconds);
+bool cubeFarmTurn(const CubeFarm* farm, const FarmCube* cube, LayerMove* move, float* angle);
+bool cubeFarmVisible(const FarmCube* cube, const float planes[6][4]);
+
+#endif  /** __CUBEFARM_H__ */
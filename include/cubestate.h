@@ -0,0 +1,85 @@
+#ifndef __CUBESTATE_H__
+#define __CUBESTATE_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Headless cube-state core.
+ *
+ * Nothing in here depends on SDL, GLEW, OpenGL or cglm, so it can be linked
+ * into scripts and tools that never open a window. The renderer mirrors this
+ * state; it never owns it.
+ */
+
+#define FACE_COUNT 6
+#define CORNER_COUNT 8
+#define EDGE_COUNT 12
+#define MOVE_COUNT 18
+
+typedef enum {
+    FACE_FRONT = 0,
+    FACE_BACK = 1,
+    FACE_LEFT = 2,
+    FACE_RIGHT = 3,
+    FACE_BOTTOM = 4,
+    FACE_TOP = 5,
+} FaceID;
+
+// Corner slots, named by the faces they touch (U/D face first)
+typedef enum {
+    CORNER_URF, CORNER_UFL, CORNER_ULB, CORNER_UBR,
+    CORNER_DFR, CORNER_DLF, CORNER_DBL, CORNER_DRB,
+} Corner;
+
+// Edge slots, named by the faces they touch (U/D or F/B face first)
+typedef enum {
+    EDGE_UR, EDGE_UF, EDGE_UL, EDGE_UB,
+    EDGE_DR, EDGE_DF, EDGE_DL, EDGE_DB,
+    EDGE_FR, EDGE_FL, EDGE_BL, EDGE_BR,
+} Edge;
+
+// Face turns in standard notation, three per face in FaceID order:
+// quarter turn clockwise (seen from outside the face), half turn, counter-clockwise
+typedef enum {
+    MOVE_F, MOVE_F2, MOVE_F_PRIME,
+    MOVE_B, MOVE_B2, MOVE_B_PRIME,
+    MOVE_L, MOVE_L2, MOVE_L_PRIME,
+    MOVE_R, MOVE_R2, MOVE_R_PRIME,
+    MOVE_D, MOVE_D2, MOVE_D_PRIME,
+    MOVE_U, MOVE_U2, MOVE_U_PRIME,
+} Move;
+
+/**
+ * Cubie-level state: slot i holds corner cp[i] twisted by co[i] (0..2) and
+ * edge ep[i] flipped by eo[i] (0..1). 40 bytes, no floats.
+ */
+typedef struct {
+    uint8_t cp[CORNER_COUNT];
+    uint8_t co[CORNER_COUNT];
+    uint8_t ep[EDGE_COUNT];
+    uint8_t eo[EDGE_COUNT];
+} CubeState;
+
+// moveTable[m] is move m applied to the solved cube
+extern const CubeState moveTable[MOVE_COUNT];
+
+void cubeStateInit(CubeState* state);
+void cubeStateMultiply(const CubeState* a, const CubeState* b, CubeState* result);
+void cubeStateInverse(const CubeState* state, CubeState* result);
+void cubeStateApplyMove(CubeState* state, Move move);
+void cubeStateApplyMoves(CubeState* state, const uint8_t* moves, int count);
+void cubeStatesApplyMoves(CubeState* states, size_t count, const uint8_t* moves, int moveCount);
+bool cubeStateEquals(const CubeState* a, const CubeState* b);
+bool cubeStateIsSolved(const CubeState* state);
+bool cubeStateIsValid(const CubeState* state);
+
+Move moveFromFace(FaceID face, int quarterTurns);
+FaceID moveFace(Move move);
+int moveQuarterTurns(Move move);
+Move moveInverse(Move move);
+bool moveIsRedundant(Move previous, Move move);
+const char* moveName(Move move);
+
+#endif  /** __CUBESTATE_H__ */
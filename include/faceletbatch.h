@@ -0,0 +1,39 @@
+#ifndef __FACELETBATCH_H__
+#define __FACELETBATCH_H__
+
+#include "facelets.h"
+
+/**
+ * Structure-of-arrays batch of facelet cubes: row i holds facelet i of every
+ * cube, so cube k's sticker i lives at data[i * stride + k]. Rows are 64-byte
+ * aligned and padded, which turns a move into whole-row copies that a vector
+ * register does 16 or 32 cubes at a time.
+ */
+
+#define FACELET_BATCH_ALIGN 64
+
+typedef enum {
+    FACELET_KERNEL_AUTO = 0,
+    FACELET_KERNEL_SCALAR,
+    FACELET_KERNEL_SSE2,
+    FACELET_KERNEL_AVX2,
+} FaceletKernel;
+
+typedef struct {
+    uint8_t* data;
+    size_t count;
+    size_t stride;
+} FaceletBatch;
+
+bool faceletBatchInit(FaceletBatch* batch, size_t count);
+void faceletBatchFree(FaceletBatch* batch);
+void faceletBatchSet(FaceletBatch* batch, size_t index, const FaceletCube* cube);
+void faceletBatchGet(const FaceletBatch* batch, size_t index, FaceletCube* cube);
+void faceletBatchApplyMove(FaceletBatch* batch, Move move);
+void faceletBatchApplyMoves(FaceletBatch* batch, const uint8_t* moves, int count);
+bool faceletBatchApplyMovesWith(FaceletBatch* batch, const uint8_t* moves, int count, FaceletKernel kernel);
+
+bool faceletKernelSupported(FaceletKernel kernel);
+const char* faceletKernelName(FaceletKernel kernel);
+
+#endif  /** __FACELETBATCH_H__ */
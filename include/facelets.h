@@ -0,0 +1,36 @@
+#ifndef __FACELETS_H__
+#define __FACELETS_H__
+
+#include "cubestate.h"
+
+/**
+ * Sticker-level view of a 3x3x3 state: one byte per facelet holding the
+ * FaceID of its colour. Facelets are laid out face by face in U, R, F, D, L, B
+ * order, each face read row by row as seen from outside (U with B on top,
+ * D with F on top, the side faces with U on top).
+ */
+
+#define FACELET_COUNT 54
+
+typedef struct {
+    uint8_t f[FACELET_COUNT];
+} FaceletCube;
+
+// faceletMoveTable[m][i] is the facelet whose sticker lands on facelet i after move m
+extern const uint8_t faceletMoveTable[MOVE_COUNT][FACELET_COUNT];
+
+// Facelets of each corner and edge slot, in orientation order
+extern const uint8_t cornerFacelet[CORNER_COUNT][3];
+extern const uint8_t edgeFacelet[EDGE_COUNT][2];
+
+void faceletCubeInit(FaceletCube* cube);
+void faceletCubeApplyMove(FaceletCube* cube, Move move);
+void cubeStateToFacelets(const CubeState* state, FaceletCube* cube);
+bool faceletsToCubeState(const FaceletCube* cube, CubeState* state);
+bool faceletCubeParse(const char* text, size_t length, FaceletCube* cube);
+void faceletCubeFormat(const FaceletCube* cube, char* out);
+
+FaceID faceletFace(int facelet);
+void faceletPosition(int facelet, int position[3]);
+
+#endif  /** __FACELETS_H__ */
@@ -0,0 +1,25 @@
+#ifndef __FRAMESTATS_H__
+#define __FRAMESTATS_H__
+
+#include <stdbool.h>
+
+/**
+ * The last FRAME_STATS_WINDOW samples of one timing, for percentiles over a
+ * rolling window: a fixed ring, so adding is O(1) and never allocates.
+ * Percentiles sort a copy, which at this size is cheap enough to do a few
+ * times a second.
+ */
+
+#define FRAME_STATS_WINDOW 512
+
+typedef struct {
+    float samples[FRAME_STATS_WINDOW];
+    int count;                  // Samples held, up to FRAME_STATS_WINDOW
+    int next;                   // Where the next sample goes
+} RollingSamples;
+
+void rollingSamplesInit(RollingSamples* window);
+void rollingSamplesAdd(RollingSamples* window, float sample);
+bool rollingSamplesPercentiles(const RollingSamples* window, const float* ranks, int count, float* out);
+
+#endif  /** __FRAMESTATS_H__ */
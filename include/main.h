@@ -6,36 +6,63 @@
 #include <SDL2/SDL.h>
 #include <GL/glew.h>
 #include <stdbool.h>
-#include "cube.h"
+#include <cglm/cglm.h>
+#include "bigcube.h"
+#include "movelog.h"
+#include "movequeue.h"
+#include "solver.h"
+#include "utils.h"
 
+#define WINDOW_TITLE "Rubik's Cube Simulation"
 #define WIDTH 1000
 #define HEIGHT 800
-#define CUBELET_COUNT 27
+#define DEFAULT_CUBE_SIZE 3
+#define DEFAULT_TURN_DURATION 0.15f  // Seconds per animated turn
+#define DEFAULT_SWAP_INTERVAL -1     // Adaptive vsync, see --vsync
+#define SOLVER_TABLE_PATH "rubik-solver.tables"  // Written on the first solve, mapped after that
 
-typedef enum {
-    FACE_FRONT = 0,
-    FACE_BACK = 1,
-    FACE_LEFT = 2,
-    FACE_RIGHT = 3,
-    FACE_BOTTOM = 4,
-    FACE_TOP = 5,
-} FaceID;
+struct StickerInstance;
+struct Simulation;
+struct Profiler;
+struct Offscreen;
+struct FrameCapture;
 
 typedef struct {
-    SDL_Window* window;
+    SDL_Window* window;                 // NULL when offscreen
     SDL_GLContext context;
-    GLuint shaderProgram;
+    struct Offscreen* offscreen;        // Headless EGL target, if any; see offscreen.h
+    ShaderProgram shader;
 } Scene;
 
+// Matches the std140 Camera uniform block in vertex.glsl; only uploaded when dirty
 typedef struct {
-    int cubeCount;
-    Cubelet cubelets[CUBELET_COUNT];
+    mat4 view;
+    mat4 projection;
+    bool dirty;
+} Camera;
+
+// Owned by the simulation thread while it runs, see simulation.h
+typedef struct {
+    int size;               // Cube is size x size x size
+    BigCube state;          // Authoritative sticker state, rendering only animates it
+    MoveQueue queue;        // Slice turns waiting to be animated
+    LayerMove rotating_move;
     bool isRotating;
-    bool rotating_clockwise;
-    vec3 rotating_axis;
-    float rotation_progress;
+    float rotating_target;  // Signed final angle about the +axis, in radians
+    float rotation_progress; // 0..1 through the current turn
+    _Atomic float turn_duration; // Seconds per turn; replay rescales it from the main thread
 } Cube;
 
+// When the main loop draws, see main.c
+typedef struct {
+    int maxFps;             // 0 = no cap beyond vsync
+    Uint64 nextFrame;       // SDL performance counter before which no frame is drawn
+    bool redraw;            // The window needs repainting though the cube did not change
+    bool visible;           // Nothing is drawn while the window is hidden or minimized
+    int frameLimit;         // --frames: stop after presenting this many, 0 = no limit
+    int framesPresented;
+} FrameScheduler;
+
 typedef struct {
     Scene *scene;
 
@@ -43,12 +70,36 @@ typedef struct {
 
     bool isActive;
     SDL_Event event;
-    GLuint VAO, VBO, faceIndexBuffer;
+    GLuint VAO, VBO, EBO, instanceBuffer;
+    struct StickerInstance* stickers;   // CPU copy of the instance buffer, see render.h
+    mat4* stickerRest;                  // Model matrix of each sticker with no turn applied
+    bool stickersDirty;                 // A turn landed since the last snapshot (simulation thread)
+    uint64_t stickersShown;             // Snapshot sticker version in the instance buffer (main thread)
+    struct Simulation* simulation;      // Runs the cube, see simulation.h
+    int layerDepth;                     // Slice depth typed before a face key, 0 = outer layer
+    Solver* solver;                     // Built on the first solve request
+    MoveLogWriter* recorder;            // Every queued turn is logged here, if recording
+    MoveLog* replay;                    // Log being played back, if any
+    MoveLogCursor replayCursor;
+    double replaySpeed;                 // 1 = as recorded, 2 = twice as fast...
+    Uint64 replayStart;                 // SDL performance counter when playback began
+    Camera camera;
+    GLuint cameraUBO;
+    FrameScheduler frames;
+    struct Profiler* profiler;          // Frame timing, if enabled; see profiler.h
+    struct FrameCapture* capture;       // Frames being written out, if any; see capture.h
 } State;
 
-void initCubelets(State* state);
+bool initCubelets(State* state, int size);
+void destroyCubelets(State* state);
+bool queueMove(State* state, Move move);
+bool queueLayerMove(State* state, LayerMove move);
 void startFaceRotation(State* state, int face_index, bool clockwise);
-void updateCubelets(State* state);
-void rotateFaceColors(Cubelet* c, vec3 axis, bool clockwise);
+void startLayerRotation(State* state, int face_index, int depth, bool clockwise);
+void solveCube(State* state);
+bool startRecording(State* state, const char* path);
+bool startReplay(State* state, const char* path, double speed);
+int updateReplay(State* state);
+void updateCubelets(State* state, float seconds);
 
 #endif  /** __MAIN_H__ */
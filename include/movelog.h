@@ -0,0 +1,76 @@
+#ifndef __MOVELOG_H__
+#define __MOVELOG_H__
+
+#include <pthread.h>
+#include <stdio.h>
+#include "bigcube.h"
+
+/**
+ * Binary log of a session's slice turns, for replaying it later. A file is
+ * a 16-byte header (magic, version, cube size) followed by one record per
+ * turn:
+ *   - one byte: turns in bits 0-1 (1..3), axis in bits 2-3, layer in bits
+ *     4-7, or 15 there with the layer in a second byte (cubes above 15),
+ *   - the milliseconds since the previous record (since the log was opened
+ *     for the first) as an unsigned LEB128 varint, one byte under 128 ms.
+ * A typical 3x3x3 session costs two or three bytes a turn. Files use no
+ * padding and are read back in order; a record cut short at the end (the
+ * program died mid-write) is ignored.
+ *
+ * The writer never touches the disk on the caller's thread: records are
+ * appended to a memory buffer under a briefly held lock, and a background
+ * thread swaps that buffer out and writes it, whenever enough has piled up,
+ * once a second, and on close. The reader maps the file read-only.
+ */
+
+#define MOVE_LOG_VERSION 1
+#define MOVE_LOG_HEADER_SIZE 16
+#define MOVE_LOG_MAX_RECORD 12          // Two move bytes and a 10-byte varint
+#define MOVE_LOG_FLUSH_SIZE 65536       // Wake the writer once this much is waiting
+
+typedef struct {
+    char magic[8];                      // "RUBIKLOG"
+    uint32_t version;
+    uint32_t cubeSize;
+} MoveLogHeader;
+
+typedef struct {
+    FILE* file;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+
+    uint8_t* pending;                   // Filled by the caller
+    size_t pendingSize, pendingCapacity;
+    uint64_t lastTime;                  // Milliseconds, caller's clock
+    bool closing;
+    bool failed;                        // A write failed; later records are dropped
+} MoveLogWriter;
+
+typedef struct {
+    void* mapping;
+    size_t mappingSize;
+    int cubeSize;
+    const uint8_t* records;
+    size_t size;                        // Bytes of records
+} MoveLog;
+
+// Position in a log while reading it
+typedef struct {
+    size_t offset;
+    uint64_t time;                      // Milliseconds since the log was opened, at the last record read
+} MoveLogCursor;
+
+int moveLogEncode(LayerMove move, uint64_t delta, uint8_t* out);
+int moveLogDecode(const uint8_t* data, size_t size, LayerMove* move, uint64_t* delta);
+
+bool moveLogWriterOpen(MoveLogWriter* writer, const char* path, int cubeSize, uint64_t time);
+bool moveLogWriterAppend(MoveLogWriter* writer, LayerMove move, uint64_t time);
+bool moveLogWriterClose(MoveLogWriter* writer);
+
+bool moveLogOpen(MoveLog* log, const char* path);
+void moveLogClose(MoveLog* log);
+bool moveLogNext(const MoveLog* log, MoveLogCursor* cursor, LayerMove* move);
+size_t moveLogReplay(const MoveLog* log, BigCube* cube);
+
+#endif  /** __MOVELOG_H__ */
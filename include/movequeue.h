@@ -0,0 +1,27 @@
+#ifndef __MOVEQUEUE_H__
+#define __MOVEQUEUE_H__
+
+#include <stdatomic.h>
+#include "bigcube.h"
+
+/**
+ * Lock-free single-producer/single-consumer ring of pending slice turns. The
+ * producer (input handling) only writes tail, the consumer (animation) only
+ * writes head, so neither ever waits on the other.
+ */
+
+#define MOVE_QUEUE_CAPACITY 256  // Must be a power of two
+
+typedef struct {
+    _Atomic size_t head;
+    _Atomic size_t tail;
+    uint16_t moves[MOVE_QUEUE_CAPACITY];  // LayerMoves packed by packLayerMove
+} MoveQueue;
+
+void moveQueueInit(MoveQueue* queue);
+bool moveQueuePush(MoveQueue* queue, LayerMove move);
+bool moveQueuePop(MoveQueue* queue, LayerMove* move);
+bool moveQueuePopCoalesced(MoveQueue* queue, LayerMove* move);
+size_t moveQueueSize(MoveQueue* queue);
+
+#endif  /** __MOVEQUEUE_H__ */
@@ -0,0 +1,23 @@
+#ifndef __OFFSCREEN_H__
+#define __OFFSCREEN_H__
+
+/**
+ * Headless rendering (--offscreen): no window and no display server. The
+ * context comes from EGL, on Mesa's surfaceless platform where it has one
+ * and on a small pbuffer of the default display otherwise, so it works on
+ * llvmpipe on a machine with no GPU. The scene draws into a framebuffer
+ * object with a depth buffer instead of a back buffer, and presenting a
+ * frame only hands it to the frame capture (capture.h), if any.
+ *
+ * Needs a build with EGL (RUBIK_OFFSCREEN); without it creating the
+ * context reports that and fails.
+ */
+
+typedef struct Offscreen Offscreen;
+
+Offscreen* createOffscreenContext(void);
+bool attachOffscreenFramebuffer(Offscreen* offscreen, int width, int height);
+void destroyOffscreen(Offscreen* offscreen);
+void presentFrame(State* state);
+
+#endif  /** __OFFSCREEN_H__ */
@@ -0,0 +1,70 @@
+#ifndef __OPTIMAL_H__
+#define __OPTIMAL_H__
+
+#include "cubestate.h"
+#include "symmetry.h"
+#include "tablestore.h"
+#include "workpool.h"
+
+/**
+ * Optimal solver (Korf): iterative-deepening A* over CubeState, bounded by
+ * pattern databases holding the exact distance to solved of
+ *  - the eight corners, stored per symmetry class: the corner permutation
+ *    is reduced to one of its 984 classes under the 48 symmetries and the
+ *    twist taken after the same conjugation (984 * 3^7 entries, not 8! * 3^7),
+ *  - six edges, UR UF UL UB FR FL (12!/6! * 2^6 entries),
+ *  - the other six, looked up in the same table through the x2 rotation,
+ *    which swaps the two halves.
+ * The largest of the three never overestimates, so the first solution an
+ * iteration finds is optimal.
+ *
+ * The databases take about 45 MB and under a minute of one core to build;
+ * patternDatabaseInitCached keeps them in a table file (see tablestore.h)
+ * so that only happens once.
+ *
+ * Each iteration runs on a WorkPool: the root is one task, and any node
+ * with enough depth left is split into one task per child whenever a worker
+ * is idle, so the tree spreads over every worker and a worker that runs out
+ * steals the oldest (largest) subtree left.
+ */
+
+#define OPTIMAL_MAX_LENGTH 26    // Every position is within 20 face turns, 26 quarter turns
+
+#define CORNER_CLASS_COUNT 984    // Corner permutations up to symmetry
+#define CORNER_PDB_SIZE 2152008   // CORNER_CLASS_COUNT * 3^7
+#define EDGE_PDB_SIZE 42577920    // 12!/6! * 2^6
+#define EDGE_PDB_EDGES 6
+#define EDGE_PDB_SYMMETRY 6       // x2: takes either half of the edges onto the other
+
+#define OPTIMAL_TABLE_COUNT 2
+#define OPTIMAL_TABLE_NAME "optimal"
+
+typedef enum {
+    METRIC_HTM,  // Face turn metric: half turns count as one move
+    METRIC_QTM,  // Quarter turn metric: half turns are two moves
+} Metric;
+
+typedef struct {
+    uint8_t* cornerPdb;                       // CORNER_PDB_SIZE
+    uint8_t* edgePdb;                         // EDGE_PDB_SIZE
+    SymmetryClasses cornerClasses;            // Corner permutation -> class, always built
+    const Symmetry* edgeViews[2];             // Identity, then EDGE_PDB_SYMMETRY
+    TableStoreMap store;
+} PatternDatabase;
+
+typedef struct {
+    int length;                               // -1 if none within maxLength
+    uint64_t nodes;                           // Nodes whose bound was checked, every iteration
+    double seconds;
+} OptimalStats;
+
+uint64_t patternDatabaseFingerprint(void);
+bool patternDatabaseInit(PatternDatabase* pdb, int threads);
+bool patternDatabaseInitCached(PatternDatabase* pdb, const char* path, int threads);
+void patternDatabaseFree(PatternDatabase* pdb);
+int patternDatabaseEstimate(const PatternDatabase* pdb, const CubeState* state);
+
+int optimalSolve(const PatternDatabase* pdb, const CubeState* state, Metric metric, int maxLength,
+                 WorkPool* pool, uint8_t* moves, OptimalStats* stats);
+
+#endif  /** __OPTIMAL_H__ */
@@ -0,0 +1,61 @@
+#ifndef __PROFILER_H__
+#define __PROFILER_H__
+
+#include "framestats.h"
+
+/**
+ * Where each drawn frame's time goes. CPU phases are timed on the main
+ * thread between marks; the simulation phase is the slowest tick its own
+ * thread ran since the previous frame; GPU time comes from GL_TIME_ELAPSED
+ * queries around each frame's commands. Queries alternate between two
+ * objects and a result is only read back two frames later, and only if the
+ * driver says it is ready, so timing never stalls the pipeline (a result
+ * still not ready is dropped and counted).
+ *
+ * Every phase keeps rolling p50/p95/p99 over the last FRAME_STATS_WINDOW
+ * frames, shown in the window title when the HUD is on and printed on exit,
+ * and every frame can be streamed as one CSV row.
+ */
+
+#define PROFILER_QUERIES 2
+#define PROFILER_HUD_INTERVAL 0.5       // Seconds between HUD refreshes
+
+typedef enum {
+    PHASE_EVENTS,                       // Input, replay, solving: everything between waits and the frame
+    PHASE_SIMULATION,                   // Slowest simulation tick since the previous frame
+    PHASE_UPLOAD,                       // Building and uploading camera and instance data
+    PHASE_DRAW,                         // Clear and draw submission
+    PHASE_SWAP,                         // SDL_GL_SwapWindow, vsync waits included
+    PHASE_CPU,                          // Events, upload, draw and swap together
+    PHASE_INTERVAL,                     // Since the previous frame's swap, idle time included
+    PHASE_GPU,                          // GL_TIME_ELAPSED of the frame's commands
+    PHASE_COUNT
+} ProfilePhase;
+
+typedef struct Profiler {
+    FILE* csv;
+    bool hud;
+    Uint64 mark;                        // Performance counter at the last mark
+    Uint64 lastSwap;
+    Uint64 lastReport;
+    uint64_t frame;
+    float phases[PHASE_COUNT];          // Milliseconds, frame being timed
+    RollingSamples windows[PHASE_COUNT];
+
+    GLuint queries[PROFILER_QUERIES];
+    bool queryPending[PROFILER_QUERIES];
+    uint64_t queryFrame[PROFILER_QUERIES];
+    float queryRows[PROFILER_QUERIES][PHASE_COUNT];     // CPU side of the frame waiting on each query
+    uint64_t dropped;                   // GPU results not ready in time
+} Profiler;
+
+bool startProfiler(State* state, const char* csvPath, bool hud);
+void stopProfiler(State* state);
+void toggleProfilerHud(State* state);
+void profileResume(State* state);
+void profileMark(State* state, ProfilePhase phase);
+void profileFrameBegin(State* state);
+void profileSubmitted(State* state);
+void profileFrameEnd(State* state);
+
+#endif  /** __PROFILER_H__ */
@@ -0,0 +1,24 @@
+#ifndef __PRUNETABLE_H__
+#define __PRUNETABLE_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Pruning tables: one byte per position of some coordinate space holding
+ * its exact distance to a goal position, filled by breadth-first search.
+ * Each depth layer is expanded by several threads at once, each scanning its
+ * own slice of the table; positions are claimed with an atomic
+ * compare-and-swap, so every one is counted exactly once.
+ */
+
+#define PRUNE_UNVISITED 0xff
+#define PRUNE_MAX_NEIGHBORS 32
+
+// Write the positions one move away from index into next[]; returns how many
+typedef int (*PruneExpand)(const void* context, size_t index, size_t* next);
+
+bool pruneTableBuild(uint8_t* table, size_t size, size_t goal, PruneExpand expand, const void* context, int threads);
+
+#endif  /** __PRUNETABLE_H__ */
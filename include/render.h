@@ -0,0 +1,29 @@
+#ifndef __RENDER_H__
+#define __RENDER_H__
+
+// Uniform buffer binding point of the Camera block
+#define CAMERA_BINDING 0
+
+// Stickers first, then up to four caps that close the gaps while a slice turns
+#define CAP_INSTANCE_COUNT 4
+#define STICKER_INSTANCE_COUNT(size) (FACE_COUNT * (size) * (size) + CAP_INSTANCE_COUNT)
+
+// Per-instance data for one sticker quad, matching the instanced attributes in vertex.glsl
+typedef struct StickerInstance {
+    mat4 model;
+    vec3 color;
+} StickerInstance;
+
+// stickerColors index of the caps, after one colour per face
+#define CAP_COLOR FACE_COUNT
+
+extern const vec3 stickerColors[FACE_COUNT + 1];
+
+void stickerRestMatrix(int size, int sticker, mat4 rest);
+int layerCaps(int size, int axis, int layer, mat4 still[2], mat4 turning[2]);
+void setCamera(State* state, vec3 eye, float fovy);
+void initRenderer(State* state);
+void renderCube(State* state);
+void destroyRenderer(State* state);
+
+#endif  /** __RENDER_H__ */
@@ -0,0 +1,48 @@
+#ifndef __SIMULATION_H__
+#define __SIMULATION_H__
+
+#include <pthread.h>
+#include "triplebuffer.h"
+
+/**
+ * The cube's state and turn animation advance on their own thread at a
+ * fixed rate, whatever the frame rate. It is the only thread that touches
+ * Cube::state and the turn in flight; input reaches it through the move
+ * queue, and everything the main thread draws or solves from comes out of
+ * it as a CubeSnapshot, handed over through a triple buffer. Neither side
+ * ever takes a lock or waits for the other: a slow frame just skips
+ * snapshots, a slow tick just shows the previous one again.
+ */
+
+#define SIMULATION_RATE 240             // Ticks per second
+#define SIMULATION_MAX_LAG 8            // Ticks to catch up on after a stall before the time is dropped
+
+// Everything the renderer needs from one tick; never written once published
+typedef struct {
+    uint8_t* stickers;                  // Cube::state.stickers as of this tick
+    uint64_t stickerVersion;            // Changes whenever a turn lands
+    size_t consumed;                    // Move queue head: every turn queued before it is in this snapshot
+    bool isRotating;
+    LayerMove rotatingMove;
+    float rotatingTarget;
+    float rotationProgress;
+} CubeSnapshot;
+
+typedef struct Simulation {
+    pthread_t thread;
+    _Atomic bool running;
+    TripleBuffer snapshots;
+    CubeSnapshot slots[3];
+    uint64_t stickerVersion;            // Simulation thread only
+    size_t consumed;                    // Head as of the last publish, simulation thread only
+    _Atomic uint32_t slowestTick;       // Nanoseconds, longest tick since the last takeSlowestTick
+} Simulation;
+
+bool startSimulation(State* state);
+void stopSimulation(State* state);
+const CubeSnapshot* latestSnapshot(State* state);
+bool snapshotPending(State* state);
+bool snapshotSettled(State* state, const CubeSnapshot* snapshot);
+float takeSlowestTick(State* state);
+
+#endif  /** __SIMULATION_H__ */
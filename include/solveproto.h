@@ -0,0 +1,64 @@
+#ifndef __SOLVEPROTO_H__
+#define __SOLVEPROTO_H__
+
+#include "solver.h"
+
+/**
+ * Wire format of the solver service (tools/daemon.c). Both directions are
+ * a stream of frames: a 12-byte header, then length bytes of payload. The
+ * socket never leaves the machine, so everything is in native byte order.
+ *
+ * A request's payload is a CubeState (40 bytes: cp, co, ep, eo) followed by
+ * up to SOLVE_PROTO_MAX_MOVES Move bytes applied to it. The response
+ * carries the request's id and op, a status, and:
+ *   SOLVE         the solution, one Move byte per turn
+ *   APPLY         the resulting CubeState
+ *   VERIFY        one byte, 1 if the result is solved
+ *   CANONICALISE  the smallest symmetry conjugate of the result
+ * param is the target length for SOLVE (0 for the server's default) and
+ * 1 for CANONICALISE to include inverses; other ops ignore it.
+ */
+
+#define SOLVE_PROTO_VERSION 1
+#define SOLVE_PROTO_STATE_SIZE ((int)sizeof(CubeState))
+#define SOLVE_PROTO_MAX_MOVES 1024
+#define SOLVE_PROTO_MAX_PAYLOAD (SOLVE_PROTO_STATE_SIZE + SOLVE_PROTO_MAX_MOVES)
+#define SOLVE_PROTO_MAX_RESPONSE ((int)sizeof(SolveFrameHeader) + SOLVE_PROTO_STATE_SIZE)
+
+typedef enum {
+    SOLVE_OP_SOLVE = 1,
+    SOLVE_OP_APPLY,
+    SOLVE_OP_VERIFY,
+    SOLVE_OP_CANONICALISE,
+} SolveOp;
+
+typedef enum {
+    SOLVE_STATUS_OK = 0,
+    SOLVE_STATUS_BAD_REQUEST,           // Unknown op or version, malformed payload
+    SOLVE_STATUS_INVALID_STATE,         // Not a reachable cube
+    SOLVE_STATUS_NO_SOLUTION,
+    SOLVE_STATUS_BUSY,                  // The server is shutting down
+} SolveStatus;
+
+typedef struct {
+    uint32_t length;                    // Payload bytes after the header
+    uint32_t id;                        // Chosen by the client, echoed back
+    uint8_t op;                         // SolveOp
+    uint8_t status;                     // SolveStatus, responses only
+    uint8_t version;                    // SOLVE_PROTO_VERSION
+    uint8_t param;
+} SolveFrameHeader;
+
+typedef struct {
+    const Solver* solver;               // Shared, read-only
+    int targetLength;                   // Used when a request asks for 0
+    double timeLimit;
+} SolveService;
+
+bool solveProtoRequestValid(const SolveFrameHeader* header);
+size_t solveProtoEncodeRequest(SolveOp op, uint32_t id, uint8_t param, const CubeState* state,
+                               const uint8_t* moves, int moveCount, uint8_t* out);
+size_t solveProtoExecute(const SolveService* service, const SolveFrameHeader* request, const uint8_t* payload,
+                         uint8_t* response);
+
+#endif  /** __SOLVEPROTO_H__ */
@@ -0,0 +1,63 @@
+#ifndef __SOLVER_H__
+#define __SOLVER_H__
+
+#include "cubestate.h"
+#include "tablestore.h"
+
+/**
+ * Two-phase solver (Kociemba). Phase 1 takes the cube into the subgroup
+ * <U, D, R2, L2, F2, B2>, where every corner and edge is oriented and the
+ * four E-slice edges sit in the E slice; phase 2 solves it inside that
+ * subgroup. Both phases search coordinates (small integers summarising the
+ * relevant part of the state) through precomputed move tables, pruned by
+ * distance tables, so no CubeState is touched inside the search.
+ *
+ * The tables take about 6 MB and a fraction of a second to build, or can be
+ * mapped from a table file (see tablestore.h). After init the Solver is
+ * read-only and may be shared between threads.
+ */
+
+#define SOLVER_MAX_LENGTH 30
+#define SOLVER_DEFAULT_TARGET_LENGTH 20
+#define SOLVER_DEFAULT_TIME_LIMIT 0.01  // Seconds spent shortening the first solution
+
+// Coordinate sizes
+#define TWIST_COUNT 2187         // 3^7 corner orientations
+#define FLIP_COUNT 2048          // 2^11 edge orientations
+#define SLICE_COUNT 495          // 12 choose 4 places for the E-slice edges
+#define CORNER_PERM_COUNT 40320  // 8! corner permutations
+#define EDGE8_PERM_COUNT 40320   // 8! permutations of the U and D layer edges
+#define SLICE_PERM_COUNT 24      // 4! permutations of the E-slice edges
+#define PHASE2_MOVE_COUNT 10
+
+#define SOLVER_TABLE_COUNT 10
+#define SOLVER_TABLE_NAME "two-phase"
+
+typedef struct {
+    // Move tables: coordinate * move count + move -> coordinate
+    uint16_t* twistMove;         // TWIST_COUNT x MOVE_COUNT
+    uint16_t* flipMove;          // FLIP_COUNT x MOVE_COUNT
+    uint16_t* sliceMove;         // SLICE_COUNT x MOVE_COUNT
+    uint16_t* cornerPermMove;    // CORNER_PERM_COUNT x PHASE2_MOVE_COUNT
+    uint16_t* edge8PermMove;     // EDGE8_PERM_COUNT x PHASE2_MOVE_COUNT
+    uint16_t* slicePermMove;     // SLICE_PERM_COUNT x PHASE2_MOVE_COUNT
+
+    // Pruning tables: exact distance to the phase goal in the projected coordinates
+    uint8_t* twistSlicePrune;    // TWIST_COUNT x SLICE_COUNT
+    uint8_t* flipSlicePrune;     // FLIP_COUNT x SLICE_COUNT
+    uint8_t* cornerSlicePrune;   // CORNER_PERM_COUNT x SLICE_PERM_COUNT
+    uint8_t* edgeSlicePrune;     // EDGE8_PERM_COUNT x SLICE_PERM_COUNT
+
+    TableStoreMap store;         // Backs every table above when they came from a file
+} Solver;
+
+// The phase 2 moves, indexing the phase 2 move tables
+extern const Move phase2Moves[PHASE2_MOVE_COUNT];
+
+uint64_t solverFingerprint(void);
+bool solverInit(Solver* solver, int threads);
+bool solverInitCached(Solver* solver, const char* path, int threads);
+void solverFree(Solver* solver);
+int solverSolve(const Solver* solver, const CubeState* state, int targetLength, double timeLimit, uint8_t* moves);
+
+#endif  /** __SOLVER_H__ */
@@ -0,0 +1,54 @@
+#ifndef __STATECODEC_H__
+#define __STATECODEC_H__
+
+#include "cubestate.h"
+
+/**
+ * Perfect ranking of cube states: every reachable state maps to a distinct
+ * integer below CUBE_STATE_COUNT and back. The rank is mixed radix,
+ *   ((corner permutation * 3^7 + twist) * 12!/2 + edge permutation / 2) * 2^11 + flip,
+ * with permutations as Lehmer codes and orientations as base 3 / base 2
+ * digits (the last corner's twist and last edge's flip follow from the
+ * rest, and the edge permutation's parity from the corners').
+ *
+ * The full group has about 4.3 * 10^19 positions, a little over 2^65, so a
+ * full rank needs a 128-bit integer (GCC/Clang). The corner half (under
+ * 2^27) and edge half (under 2^39) each fit comfortably in 64 bits, and so
+ * does a state's rank within any subgroup that fixes either half.
+ *
+ * Alongside the rank there is a Zobrist hash: the XOR of one random key per
+ * (slot, piece, orientation), which a move updates by touching only the
+ * eight slots it changes.
+ */
+
+#define CORNER_RANK_COUNT 88179840ull        // 8! * 3^7
+#define EDGE_RANK_COUNT 490497638400ull      // 12!/2 * 2^11, given the corner parity
+
+typedef unsigned __int128 CubeRank;
+
+// CORNER_RANK_COUNT * EDGE_RANK_COUNT
+#define CUBE_STATE_COUNT ((CubeRank)CORNER_RANK_COUNT * EDGE_RANK_COUNT)
+
+uint32_t permutationRank(const uint8_t* perm, int n);
+void permutationUnrank(uint32_t rank, int n, int base, uint8_t* perm);
+int permutationParity(const uint8_t* perm, int n);
+
+int twistRank(const CubeState* state);
+void twistUnrank(CubeState* state, int twist);
+int flipRank(const CubeState* state);
+void flipUnrank(CubeState* state, int flip);
+
+uint32_t cornerRank(const CubeState* state);
+void cornerUnrank(CubeState* state, uint32_t rank);
+uint64_t edgeRank(const CubeState* state);
+void edgeUnrank(CubeState* state, uint64_t rank);
+
+CubeRank cubeStateRank(const CubeState* state);
+bool cubeStateUnrank(CubeRank rank, CubeState* state);
+void cubeStatesRank(const CubeState* states, size_t count, CubeRank* ranks);
+size_t cubeStatesUnrank(const CubeRank* ranks, size_t count, CubeState* states);
+
+uint64_t cubeStateHash(const CubeState* state);
+uint64_t cubeStateApplyMoveHashed(CubeState* state, uint64_t hash, Move move);
+
+#endif  /** __STATECODEC_H__ */
@@ -0,0 +1,75 @@
+#ifndef __STRESS_H__
+#define __STRESS_H__
+
+#include "cubefarm.h"
+
+/**
+ * Stress scene (--stress n): n cubes of a CubeFarm on a grid, each
+ * scrambling and solving itself, under a camera slowly turning above the
+ * middle of the grid. Every frame the work pool updates the farm in
+ * ranges; each range also culls its cubes against the view frustum and
+ * packs the visible ones (centre, turn in flight and sticker colours, 88
+ * bytes a cube) into staging arrays. One draw call then covers every
+ * visible cube, STRESS_PIECES instances each, issued through
+ * glDrawElementsIndirect where the driver has it; the vertex shader places
+ * every piece from buffer textures, so no per-sticker matrix is ever built
+ * or uploaded.
+ *
+ * Runs without vsync so frame times measure the work. Every
+ * STRESS_REPORT_INTERVAL the window title and stdout get the frame rate,
+ * the share of cubes drawn and how many cubes the measured frame time would
+ * fit into a 60 FPS frame.
+ */
+
+#define STRESS_PIECES 56                // Per cube: 54 stickers, the still cap and the turning cap
+#define STRESS_SCRIPTS 64
+#define STRESS_RANGES_PER_THREAD 4
+#define STRESS_TURN_DURATION 0.3f
+#define STRESS_REPORT_INTERVAL 1.0      // Seconds
+#define STRESS_PIECES_BINDING 1         // Uniform buffer binding point of the Pieces block
+
+// Two RGBA32F texels of the cubes buffer texture, see stressVertex.glsl
+typedef struct {
+    float center[3];
+    float angle;
+    float axis, layer, turning, unused;
+} StressCube;
+
+// Matches the std140 Pieces uniform block in stressVertex.glsl
+typedef struct {
+    mat4 rest[FACELET_COUNT + 12];
+    vec4 palette[FACE_COUNT + 1];
+} StressPieces;
+
+typedef struct Stress Stress;
+
+typedef struct {
+    Stress* stress;
+    int first, last;                    // Cubes of the farm
+    int visible;                        // Packed from first on in the staging arrays
+    int landed;                         // Turns that landed this frame
+} StressRange;
+
+struct Stress {
+    CubeFarm farm;
+    WorkPool pool;
+    StressRange* ranges;
+    int rangeCount;
+    float seconds;                      // Step of the frame being built
+    vec4 planes[6];                     // View frustum of the frame being built
+
+    StressCube* cubes;                  // Staging, one per farm cube
+    uint8_t* stickers;                  // Staging, STRESS_PIECES per farm cube
+    ShaderProgram shader;
+    GLuint VAO, VBO, EBO, cubeBuffer, stickerBuffer, piecesUBO, indirectBuffer;
+    GLuint textures[2];                 // Buffer textures over cubeBuffer and stickerBuffer
+    bool indirect;
+
+    Uint64 reportStart;
+    int reportFrames;
+    uint64_t reportDrawn, reportTurns;
+};
+
+bool runStress(State* state, int count, const char* shaderDir, const char* shaderCache);
+
+#endif  /** __STRESS_H__ */
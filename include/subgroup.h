@@ -0,0 +1,86 @@
+#ifndef __SUBGROUP_H__
+#define __SUBGROUP_H__
+
+#include "cubestate.h"
+#include "workpool.h"
+
+/**
+ * Breadth-first enumeration of the positions a set of face turns can reach
+ * from solved: the 2x2x2 (the corners under <R,U,F>), <R,U>, <U,D,F2,B2,L2,R2>
+ * and so on, with the number of positions at each distance.
+ *
+ * Positions are ranked densely within the subgroup's slots: the generators
+ * split the corner and edge slots into orbits (pieces never leave their
+ * orbit), and a rank is the Lehmer code of each orbit plus its twists or
+ * flips, if any generator changes them. Slots no generator touches are not
+ * stored at all. One orientation digit and, when corners and edges are both
+ * tracked, one permutation parity are implied by the rest, as in
+ * statecodec.h. Each orbit's coordinates step through small move tables,
+ * so a neighbour's rank takes a few lookups rather than a Lehmer code.
+ *
+ * The visited set is two bits per ranked position (unseen, this layer, next
+ * layer, done), updated with atomic compare-and-swap on 64-bit words, so a
+ * layer is expanded by every worker of a WorkPool at once, each taking a
+ * chunk of the array. No hash set, no queue: memory is fixed up front at a
+ * quarter byte per ranked position (about 0.9 MB for the 2x2x2, 110 MB for
+ * <R,U>, 4.9 GB for <U,D,F2,B2,L2,R2>).
+ */
+
+#define SUBGROUP_MAX_DEPTH 64
+#define SUBGROUP_TABLE_PIECES 8     // Orbits up to this size get a permutation move table (8! entries a move)
+#define SUBGROUP_MAX_SLOTS (CORNER_COUNT + EDGE_COUNT)
+#define SUBGROUP_MAX_ORBITS (SUBGROUP_MAX_SLOTS / 2)
+
+typedef enum {
+    SUBGROUP_CORNERS = 1,
+    SUBGROUP_EDGES = 2,
+    SUBGROUP_ALL = SUBGROUP_CORNERS | SUBGROUP_EDGES,
+} SubgroupPieces;
+
+/**
+ * Slots a piece can travel between, in increasing order. Within an orbit a
+ * position is two coordinates: the Lehmer rank of its pieces and its twists
+ * (flips) as base 3 (base 2) digits, which the move tables step directly.
+ */
+typedef struct {
+    bool edges;
+    int size;
+    uint8_t slots[EDGE_COUNT];
+    bool oriented;              // Some generator twists or flips a piece here
+    bool implied;               // Its last orientation digit follows from all the others
+    bool halved;                // Its parity follows from the other orbits
+    uint64_t permutationCount;  // Ranked: size! or size!/2 if halved
+    uint64_t orientationCount;  // Ranked: 1, or base^size, or base^(size - 1) if implied
+
+    // Each generator as a map of the orbit: where each slot's piece comes from, and the twist or flip added
+    uint8_t source[MOVE_COUNT][EDGE_COUNT];
+    uint8_t change[MOVE_COUNT][EDGE_COUNT];
+    uint32_t* permutationMoves; // [size! * moveCount], or NULL above SUBGROUP_TABLE_PIECES
+    uint16_t* orientationMoves; // [base^size * moveCount] if oriented
+} SubgroupOrbit;
+
+typedef struct {
+    int moveCount;
+    Move moves[MOVE_COUNT];
+    SubgroupPieces pieces;
+    int orbitCount;
+    SubgroupOrbit orbits[SUBGROUP_MAX_ORBITS];
+    uint8_t orbitIndex[SUBGROUP_MAX_SLOTS]; // Slot -> index within its orbit (corners, then edges)
+    uint64_t size;              // Ranks run from 0 to size - 1
+} Subgroup;
+
+typedef struct {
+    int depth;                  // Largest distance from solved
+    uint64_t total;
+    uint64_t counts[SUBGROUP_MAX_DEPTH + 1];
+    double seconds;
+} SubgroupStats;
+
+int subgroupParseGenerators(const char* text, Move* moves);
+bool subgroupInit(Subgroup* group, const Move* moves, int moveCount, SubgroupPieces pieces);
+void subgroupFree(Subgroup* group);
+uint64_t subgroupRank(const Subgroup* group, const CubeState* state);
+void subgroupUnrank(const Subgroup* group, uint64_t rank, CubeState* state);
+bool subgroupEnumerate(const Subgroup* group, WorkPool* pool, SubgroupStats* stats);
+
+#endif  /** __SUBGROUP_H__ */
@@ -0,0 +1,65 @@
+#ifndef __SYMMETRY_H__
+#define __SYMMETRY_H__
+
+#include "cubestate.h"
+
+/**
+ * The 48 symmetries of the cube: 24 rotations, each with and without a
+ * mirror. Symmetry s is the signed axis permutation
+ *   axis (s / 8) of {xyz, xzy, yxz, yzx, zxy, zyx} with signs (s % 8),
+ * so symmetry 0 is the identity. Conjugating a state by s (seeing it
+ * through s, s X s^-1) gives a position exactly as far from solved, with
+ * faces relabelled and, for a mirror, every turn reversed. With inversion
+ * (X^-1 is as far from solved as X) that makes up to 96 equivalent
+ * positions per class.
+ *
+ * Conjugation works on cubies directly: s moves each slot to another slot
+ * and shifts its orientation by a per-slot offset, negated for corners
+ * under a mirror. All tables are built on first use and are read-only.
+ */
+
+#define SYMMETRY_COUNT 48
+#define SYMMETRY_IDENTITY 0
+
+typedef struct {
+    uint8_t face[FACE_COUNT];                 // Where each face goes
+    uint8_t cornerSlot[CORNER_COUNT];         // Where the corner in each slot goes
+    uint8_t cornerTwist[CORNER_COUNT];        // Twist added on the way
+    uint8_t edgeSlot[EDGE_COUNT];
+    uint8_t edgeFlip[EDGE_COUNT];
+    bool mirror;
+} Symmetry;
+
+/**
+ * Classes of a coordinate under the symmetries: the representative of each
+ * class is its smallest member, and symmetry[raw] conjugates raw onto the
+ * representative of its class. A representative left unchanged by more
+ * than the identity (stabilizer) can still be reached by several symmetries;
+ * anything indexed by class plus another coordinate has to pick one of
+ * those images to stay a function of the class.
+ */
+typedef struct {
+    uint32_t count;
+    uint32_t* classOf;                        // raw -> class
+    uint8_t* symmetry;                        // raw -> symmetry taking it to the representative
+    uint32_t* representative;                 // class -> raw
+    uint64_t* stabilizer;                     // class -> symmetries fixing the representative
+} SymmetryClasses;
+
+// Coordinate raw conjugated by symmetry sym
+typedef uint32_t (*SymmetryConjugate)(uint32_t raw, int sym, const void* context);
+
+const Symmetry* symmetryGet(int sym);
+int symmetryMultiply(int a, int b);
+int symmetryInverse(int sym);
+Move symmetryMove(int sym, Move move);
+
+void cubeStateConjugate(const CubeState* state, int sym, CubeState* result);
+void cubeStateConjugateCorners(const CubeState* state, int sym, CubeState* result);
+int cubeStateCanonical(const CubeState* state, bool antisymmetry, CubeState* canonical);
+uint64_t cubeStateSymmetries(const CubeState* state);
+
+bool symmetryClassesBuild(SymmetryClasses* classes, uint32_t rawCount, SymmetryConjugate conjugate, const void* context);
+void symmetryClassesFree(SymmetryClasses* classes);
+
+#endif  /** __SYMMETRY_H__ */
@@ -0,0 +1,57 @@
+#ifndef __TABLESTORE_H__
+#define __TABLESTORE_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Versioned on-disk store for precomputed tables. A file is one page-sized
+ * header followed by the payload: a list of sections, each starting on a
+ * 64-byte boundary. Files are read with mmap, so pages come in lazily and
+ * are shared by every process mapping the same file, and they are written
+ * to a temporary file that is renamed into place, so a reader never sees a
+ * half-written table.
+ *
+ * The header records what built the payload: a table name, a fingerprint of
+ * the move set and coordinate sizes (changing either invalidates the file)
+ * and a checksum of the payload. Files use the host byte order.
+ */
+
+#define TABLE_STORE_VERSION 1
+#define TABLE_STORE_NAME_LENGTH 32
+#define TABLE_STORE_HEADER_SIZE 4096
+#define TABLE_STORE_ALIGN 64
+
+// tableStoreOpen flags
+#define TABLE_STORE_VERIFY 1  // Checksum the payload (touches every page)
+
+typedef struct {
+    char magic[8];                          // "RUBIKTBL"
+    uint32_t version;
+    uint32_t headerSize;                    // Offset of the payload
+    char name[TABLE_STORE_NAME_LENGTH];
+    uint64_t fingerprint;
+    uint64_t payloadSize;
+    uint64_t checksum;
+} TableStoreHeader;
+
+typedef struct {
+    const void* data;
+    size_t size;
+} TableSection;
+
+typedef struct {
+    void* mapping;
+    size_t mappingSize;
+    const uint8_t* data;                    // Payload, TABLE_STORE_ALIGN aligned
+    size_t size;
+} TableStoreMap;
+
+uint64_t tableChecksum(uint64_t hash, const void* data, size_t size);
+size_t tableSectionOffset(const TableSection* sections, int index);
+bool tableStoreWrite(const char* path, const char* name, uint64_t fingerprint, const TableSection* sections, int count);
+bool tableStoreOpen(const char* path, const char* name, uint64_t fingerprint, size_t payloadSize, int flags, TableStoreMap* map);
+void tableStoreClose(TableStoreMap* map);
+
+#endif  /** __TABLESTORE_H__ */
@@ -0,0 +1,33 @@
+#ifndef __TRIPLEBUFFER_H__
+#define __TRIPLEBUFFER_H__
+
+#include <stdatomic.h>
+#include <stdbool.h>
+
+/**
+ * Lock-free hand-off of the latest value from one writer thread to one
+ * reader thread. Of three caller-owned slots the writer fills one (back),
+ * the reader looks at another (front), and the third sits in between
+ * holding the newest complete value. Publishing swaps back with the middle
+ * slot, reading swaps the middle slot with front if it is newer; both are
+ * a single atomic exchange, so neither side ever waits for the other and
+ * the reader never sees a slot being written. Values the reader was too
+ * slow to see are simply overwritten.
+ */
+
+#define TRIPLE_BUFFER_FRESH 4u  // Set on the middle index while it holds an unread publish
+
+typedef struct {
+    void* slots[3];
+    _Atomic unsigned middle;
+    unsigned back;              // Writer only
+    unsigned front;             // Reader only
+} TripleBuffer;
+
+void tripleBufferInit(TripleBuffer* buffer, void* first, void* second, void* third);
+void* tripleBufferBack(TripleBuffer* buffer);
+void tripleBufferPublish(TripleBuffer* buffer);
+void* tripleBufferLatest(TripleBuffer* buffer, bool* fresh);
+bool tripleBufferPending(TripleBuffer* buffer);
+
+#endif  /** __TRIPLEBUFFER_H__ */
@@ -1,8 +1,65 @@
 #ifndef __UTILS_H__
 #define __UTILS_H__
 
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SHADER_MAX_UNIFORMS 32
+#define SHADER_MAX_BLOCKS 8
+#define SHADER_NAME_LENGTH 64
+
+#define PROGRAM_CACHE_NAME "shader program"
+#define PROGRAM_CACHE_VERSION 1
+#define DEFAULT_PROGRAM_CACHE_PATH "rubik-shaders.cache"
+
+// First section of a program cache file (a tablestore.h file); the driver's binary is the second
+typedef struct {
+    uint32_t format;                    // As returned by glGetProgramBinary
+    uint32_t length;
+} ProgramBinaryHeader;
+
+// A plain (non-block) uniform as reflected at link time
+typedef struct {
+    char name[SHADER_NAME_LENGTH];
+    GLint location;
+    GLenum type;
+    GLint size;
+} ShaderUniform;
+
+typedef struct {
+    char name[SHADER_NAME_LENGTH];
+    GLuint index;
+    GLint dataSize;
+    GLuint binding;
+} ShaderBlock;
+
+/**
+ * A linked program plus everything looked up by name, resolved once so the
+ * frame loop never has to hash a uniform name again.
+ */
+typedef struct {
+    GLuint program;
+    int uniformCount;
+    ShaderUniform uniforms[SHADER_MAX_UNIFORMS];
+    int blockCount;
+    ShaderBlock blocks[SHADER_MAX_BLOCKS];
+} ShaderProgram;
+
 char * readFile(const char* filename);
-GLuint compileShader(const char* path, GLenum shaderType);
-GLuint createShaderProgram(const char* vertexPath, const char* fragmentPath);
+GLuint compileShader(const char* source, GLenum shaderType);
+GLuint createShaderProgram(const char* vertexSource, const char* fragmentSource);
+
+bool loadShaderProgram(const char* vertexSource, const char* fragmentSource, const char* cachePath, ShaderProgram* shader);
+bool loadShaderFiles(const char* shaderDir, const char* vertexName, const char* fragmentName, const char* cachePath,
+                     ShaderProgram* shader);
+bool reflectShaderProgram(GLuint program, ShaderProgram* shader);
+const ShaderUniform* findShaderUniform(const ShaderProgram* shader, const char* name);
+const ShaderBlock* findShaderBlock(const ShaderProgram* shader, const char* name);
+bool bindShaderBlock(ShaderProgram* shader, const char* name, GLuint binding);
+
+void setUniformInt(const ShaderUniform* uniform, int value);
+void setUniformFloat(const ShaderUniform* uniform, float value);
+void setUniformVec3(const ShaderUniform* uniform, const float* value);
+void setUniformMat4(const ShaderUniform* uniform, const float* value);
 
 #endif  /** __UTILS_H__ */
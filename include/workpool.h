@@ -0,0 +1,55 @@
+#ifndef __WORKPOOL_H__
+#define __WORKPOOL_H__
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Work-stealing thread pool. Every worker owns a deque: work submitted from
+ * inside a task goes on the submitting worker's own deque and is popped
+ * newest first (depth first, cache warm), while a worker that runs dry
+ * steals the oldest item (usually the biggest subtree) from another. Work
+ * submitted from outside the pool goes into a shared inbox taken oldest
+ * first, once a worker's own deque is empty, so a steady stream of outside
+ * work (the solver service's requests) is served in arrival order and
+ * nothing starves behind newer submissions.
+ */
+
+typedef void (*WorkFunction)(void* arg, int worker);
+
+typedef struct {
+    WorkFunction function;
+    void* arg;
+} WorkItem;
+
+typedef struct {
+    pthread_mutex_t lock;
+    WorkItem* items;            // Ring buffer, grown when full
+    size_t head, tail, capacity;
+} WorkDeque;
+
+typedef struct WorkPool {
+    int threads;
+    pthread_t* handles;
+    WorkDeque* deques;
+    WorkDeque inbox;            // Outside submissions, first in first out
+
+    pthread_mutex_t lock;       // Guards sleeping and waking only
+    pthread_cond_t workAvailable;
+    pthread_cond_t allDone;
+    _Atomic size_t queued;      // Items sitting in deques
+    _Atomic size_t pending;     // Items submitted and not yet finished
+    _Atomic int idle;           // Workers not running a task
+    bool stop;
+} WorkPool;
+
+int workPoolDefaultThreads(void);
+bool workPoolInit(WorkPool* pool, int threads);
+void workPoolDestroy(WorkPool* pool);
+bool workPoolSubmit(WorkPool* pool, WorkFunction function, void* arg);
+void workPoolWait(WorkPool* pool);
+bool workPoolHungry(WorkPool* pool);
+
+#endif  /** __WORKPOOL_H__ */
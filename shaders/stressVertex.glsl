@@ -0,0 +1,62 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+
+// Stress scene: every instance is one piece of one visible cube, see stress.h
+#define PIECES 56
+#define STICKERS 54
+#define CAP_COLOR 6
+
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+};
+
+// Rest transforms of a 3x3x3 centred on the origin: the stickers, then for
+// each outer layer (axis * 2 + side) the still cap and the turning cap
+layout (std140) uniform Pieces {
+    mat4 rest[STICKERS + 12];
+    vec4 palette[CAP_COLOR + 1];
+};
+
+uniform samplerBuffer cubes;        // Two texels per cube: centre and turn angle; axis, layer and turning
+uniform usamplerBuffer stickers;    // PIECES colour indices per cube
+
+flat out vec3 faceColor;
+
+mat4 turnMatrix(int axis, float angle) {
+    float c = cos(angle), s = sin(angle);
+    if (axis == 0) return mat4(1.0, 0.0, 0.0, 0.0,  0.0, c, s, 0.0,  0.0, -s, c, 0.0,  0.0, 0.0, 0.0, 1.0);
+    if (axis == 1) return mat4(c, 0.0, -s, 0.0,  0.0, 1.0, 0.0, 0.0,  s, 0.0, c, 0.0,  0.0, 0.0, 0.0, 1.0);
+    return mat4(c, s, 0.0, 0.0,  -s, c, 0.0, 0.0,  0.0, 0.0, 1.0, 0.0,  0.0, 0.0, 0.0, 1.0);
+}
+
+void main() {
+    int cube = gl_InstanceID / PIECES;
+    int piece = gl_InstanceID % PIECES;
+    vec4 placement = texelFetch(cubes, cube * 2);
+    vec4 turn = texelFetch(cubes, cube * 2 + 1);
+    int axis = int(turn.x);
+    int layer = int(turn.y);
+    bool turning = turn.z > 0.5;
+
+    mat4 model;
+    if (piece < STICKERS) {
+        model = rest[piece];
+        // A sticker's centre is within half a unit of its layer's centre along the axis
+        if (turning && abs(model[3][axis] - float(layer - 1)) < 0.75) model = turnMatrix(axis, placement.w) * model;
+        faceColor = palette[texelFetch(stickers, cube * PIECES + piece).r].rgb;
+    } else if (turning) {
+        int cap = STICKERS + (axis * 2 + (layer == 0 ? 0 : 1)) * 2 + (piece - STICKERS);
+        model = rest[cap];
+        if (piece == STICKERS + 1) model = turnMatrix(axis, placement.w) * model;
+        faceColor = palette[CAP_COLOR].rgb;
+    } else {
+        // No gap to close: collapse the cap to a point, which rasterizes nothing
+        gl_Position = vec4(0.0, 0.0, 0.0, 1.0);
+        faceColor = vec3(0.0);
+        return;
+    }
+
+    model[3].xyz += placement.xyz;
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+}
@@ -1,14 +1,18 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
-layout (location = 2) in int aFaceIndex;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// Per-instance (per-sticker) attributes, see StickerInstance
+layout (location = 3) in mat4 aModel;
+layout (location = 7) in vec3 aColor;
 
-flat out int faceIndex;
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+};
+
+flat out vec3 faceColor;
 
 void main() {
-    faceIndex = aFaceIndex;
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    faceColor = aColor;
+    gl_Position = projection * view * aModel * vec4(aPos, 1.0);
 }
@@ -0,0 +1,245 @@
+#include <errno.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "main.h"
+#include "capture.h"
+
+// One %d conversion (flags and width allowed) and no other
+static bool framePattern(const char* path) {
+    const char* conversion = strchr(path, '%');
+    if (!conversion || strchr(conversion + 1, '%')) return false;
+    conversion += 1 + strspn(conversion + 1, "0-+ ");
+    conversion += strspn(conversion, "0123456789");
+    return *conversion == 'd';
+}
+
+// Bottom-up RGBA as read back, written top-down
+static bool writeFrame(FrameCapture* capture, const uint8_t* pixels) {
+    size_t stride = (size_t)capture->width * 4;
+    if (capture->format == CAPTURE_RAW) {
+        for (int y = capture->height - 1; y >= 0; y--) {
+            if (fwrite(pixels + (size_t)y * stride, 1, stride, capture->stream) != stride) return false;
+        }
+        return true;
+    }
+
+    char path[1024];
+    snprintf(path, sizeof(path), capture->pattern, (int)capture->written);
+    FILE* file = fopen(path, "wb");
+    if (!file) return false;
+    bool ok = fprintf(file, "P6\n%d %d\n255\n", capture->width, capture->height) > 0;
+    for (int y = capture->height - 1; ok && y >= 0; y--) {
+        const uint8_t* source = pixels + (size_t)y * stride;
+        for (int x = 0; x < capture->width; x++) memcpy(capture->row + 3 * x, source + 4 * x, 3);
+        ok = fwrite(capture->row, 3, (size_t)capture->width, file) == (size_t)capture->width;
+    }
+    return fclose(file) == 0 && ok;
+}
+
+static void* writerMain(void* arg) {
+    FrameCapture* capture = arg;
+    pthread_mutex_lock(&capture->lock);
+    for (;;) {
+        while (capture->count == 0 && !capture->stopping) pthread_cond_wait(&capture->filled, &capture->lock);
+        if (capture->count == 0) break;
+        const uint8_t* pixels = capture->queue[capture->head];
+        pthread_mutex_unlock(&capture->lock);
+
+        bool ok = writeFrame(capture, pixels);
+
+        pthread_mutex_lock(&capture->lock);
+        if (!ok && !capture->failed) {
+            fprintf(stderr, "Could not write frame %llu to %s: %s\n", (unsigned long long)capture->written,
+                    capture->name, strerror(errno));
+            capture->failed = true;
+        }
+        capture->head = (capture->head + 1) % CAPTURE_QUEUE_FRAMES;
+        capture->count--;
+        if (ok) capture->written++;
+        pthread_cond_signal(&capture->emptied);
+    }
+    pthread_mutex_unlock(&capture->lock);
+    return NULL;
+}
+
+static void freeCapture(FrameCapture* capture) {
+    for (int i = 0; i < CAPTURE_QUEUE_FRAMES; i++) free(capture->queue[i]);
+    free(capture->row);
+    free(capture->pattern);
+    free(capture);
+}
+
+/**
+ * Capture every frame presented from now on, see capture.h. Frames are
+ * WIDTH x HEIGHT, read from whatever framebuffer the scene draws to. Needs
+ * the GL context.
+ */
+bool startCapture(State* state, const char* path) {
+    FrameCapture* capture = calloc(1, sizeof(FrameCapture));
+    if (!capture) {
+        fprintf(stderr, "Failed to allocate the frame capture\n");
+        return false;
+    }
+    capture->width = WIDTH;
+    capture->height = HEIGHT;
+    capture->frameBytes = (size_t)WIDTH * HEIGHT * 4;
+    capture->name = strcmp(path, "-") == 0 ? "stdout" : path;
+    capture->format = framePattern(path) ? CAPTURE_PPM : CAPTURE_RAW;
+
+    bool ok = true;
+    for (int i = 0; i < CAPTURE_QUEUE_FRAMES; i++) {
+        capture->queue[i] = malloc(capture->frameBytes);
+        ok = ok && capture->queue[i];
+    }
+    if (capture->format == CAPTURE_PPM) {
+        capture->pattern = strdup(path);
+        capture->row = malloc((size_t)WIDTH * 3);
+        ok = ok && capture->pattern && capture->row;
+    }
+    if (!ok) {
+        fprintf(stderr, "Failed to allocate the frame capture\n");
+        freeCapture(capture);
+        return false;
+    }
+
+    if (capture->format == CAPTURE_RAW) {
+        if (strcmp(path, "-") == 0) {
+            // Keep the real stdout for frames and send everything printed to stderr
+            fflush(stdout);
+            int fd = dup(STDOUT_FILENO);
+            capture->stream = fd >= 0 && dup2(STDERR_FILENO, STDOUT_FILENO) >= 0 ? fdopen(fd, "wb") : NULL;
+        } else {
+            capture->stream = fopen(path, "wb");
+        }
+        if (!capture->stream) {
+            fprintf(stderr, "Could not open %s for the captured frames\n", capture->name);
+            freeCapture(capture);
+            return false;
+        }
+        // A reader going away (ffmpeg quitting) is a write error, not a signal
+        signal(SIGPIPE, SIG_IGN);
+        setvbuf(capture->stream, NULL, _IOFBF, CAPTURE_STREAM_BUFFER);
+    }
+
+    pthread_mutex_init(&capture->lock, NULL);
+    pthread_cond_init(&capture->filled, NULL);
+    pthread_cond_init(&capture->emptied, NULL);
+    if (pthread_create(&capture->thread, NULL, writerMain, capture) != 0) {
+        fprintf(stderr, "Could not start the capture writer\n");
+        pthread_cond_destroy(&capture->emptied);
+        pthread_cond_destroy(&capture->filled);
+        pthread_mutex_destroy(&capture->lock);
+        if (capture->stream) fclose(capture->stream);
+        freeCapture(capture);
+        return false;
+    }
+
+    glGenBuffers(CAPTURE_PBOS, capture->pbos);
+    for (int i = 0; i < CAPTURE_PBOS; i++) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, capture->pbos[i]);
+        glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)capture->frameBytes, NULL, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+    capture->start = SDL_GetPerformanceCounter();
+    state->capture = capture;
+    return true;
+}
+
+/**
+ * Hand the frame in a buffer to the writer once the GPU is done with it.
+ * Waits only if the readback is somehow still running, or the writer's
+ * queue is full. Returns false once the writer has failed.
+ */
+static bool collectFrame(FrameCapture* capture, int slot) {
+    GLsync fence = capture->fences[slot];
+    capture->fences[slot] = 0;
+    if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+        capture->fenceWaits++;
+        while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED) {}
+    }
+    glDeleteSync(fence);
+
+    pthread_mutex_lock(&capture->lock);
+    if (capture->count == CAPTURE_QUEUE_FRAMES && !capture->failed) capture->queueWaits++;
+    while (capture->count == CAPTURE_QUEUE_FRAMES && !capture->failed) {
+        pthread_cond_wait(&capture->emptied, &capture->lock);
+    }
+    bool failed = capture->failed;
+    uint8_t* pixels = capture->queue[(capture->head + capture->count) % CAPTURE_QUEUE_FRAMES];
+    pthread_mutex_unlock(&capture->lock);
+    if (failed) return false;
+
+    // Only this thread touches slots past the writer's, so the copy needs no lock
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, capture->pbos[slot]);
+    const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)capture->frameBytes, GL_MAP_READ_BIT);
+    if (mapped) {
+        memcpy(pixels, mapped, capture->frameBytes);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    if (!mapped) return true;
+
+    pthread_mutex_lock(&capture->lock);
+    capture->count++;
+    pthread_cond_signal(&capture->filled);
+    pthread_mutex_unlock(&capture->lock);
+    return true;
+}
+
+// After the frame's last draw, before the swap; stops the loop if the frames can no longer be written
+void captureFrame(State* state) {
+    FrameCapture* capture = state->capture;
+    if (!capture) return;
+
+    int slot = (int)(capture->issued % CAPTURE_PBOS);
+    if (capture->fences[slot] && !collectFrame(capture, slot)) {
+        state->isActive = false;
+        return;
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, capture->pbos[slot]);
+    glReadPixels(0, 0, capture->width, capture->height, GL_RGBA, GL_UNSIGNED_BYTE, (void*)0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    capture->fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    capture->issued++;
+}
+
+// Frames still in flight are collected and written before this returns; needs the GL context
+void stopCapture(State* state) {
+    FrameCapture* capture = state->capture;
+    if (!capture) return;
+
+    for (uint64_t frame = capture->issued; frame < capture->issued + CAPTURE_PBOS; frame++) {
+        int slot = (int)(frame % CAPTURE_PBOS);
+        if (capture->fences[slot]) collectFrame(capture, slot);
+    }
+    glDeleteBuffers(CAPTURE_PBOS, capture->pbos);
+
+    pthread_mutex_lock(&capture->lock);
+    capture->stopping = true;
+    pthread_cond_signal(&capture->filled);
+    pthread_mutex_unlock(&capture->lock);
+    pthread_join(capture->thread, NULL);
+    pthread_cond_destroy(&capture->emptied);
+    pthread_cond_destroy(&capture->filled);
+    pthread_mutex_destroy(&capture->lock);
+    if (capture->stream && fclose(capture->stream) != 0 && !capture->failed) {
+        fprintf(stderr, "The frames written to %s are incomplete\n", capture->name);
+    }
+
+    double seconds = (double)(SDL_GetPerformanceCounter() - capture->start) / (double)SDL_GetPerformanceFrequency();
+    printf("%llu of %llu frames written to %s in %.2f s (%.1f FPS)\n",
+            (unsigned long long)capture->written, (unsigned long long)capture->issued, capture->name, seconds,
+            seconds > 0.0 ? (double)capture->written / seconds : 0.0);
+    if (capture->fenceWaits || capture->queueWaits) {
+        printf("The render loop waited %llu times for a readback and %llu times for the writer\n",
+                (unsigned long long)capture->fenceWaits, (unsigned long long)capture->queueWaits);
+    }
+
+    freeCapture(capture);
+    state->capture = NULL;
+}
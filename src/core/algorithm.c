@@ -0,0 +1,330 @@
+#include <ctype.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "algorithm.h"
+
+#define CACHE_INITIAL_CAPACITY 64
+
+typedef struct {
+    char* text;
+    uint64_t hash;
+    CompiledAlgorithm compiled;
+} CacheEntry;
+
+// Open addressing over a power-of-two table; entries never move, only the table does
+static pthread_rwlock_t cacheLock = PTHREAD_RWLOCK_INITIALIZER;
+static CacheEntry** cacheSlots;
+static size_t cacheCapacity, cacheCount;
+
+static const char* const cornerNames[CORNER_COUNT] = {"URF", "UFL", "ULB", "UBR", "DFR", "DLF", "DBL", "DRB"};
+static const char* const edgeNames[EDGE_COUNT] = {"UR", "UF", "UL", "UB", "DR", "DF", "DL", "DB", "FR", "FL", "BL", "BR"};
+
+static int faceFromLetter(char letter) {
+    switch (letter) {
+        case 'F': return FACE_FRONT;
+        case 'B': return FACE_BACK;
+        case 'L': return FACE_LEFT;
+        case 'R': return FACE_RIGHT;
+        case 'D': return FACE_BOTTOM;
+        case 'U': return FACE_TOP;
+        default: return -1;
+    }
+}
+
+/**
+ * Parse standard notation into a binary move array. Moves may be separated
+ * by whitespace or written back to back ("RUR'U'"); a turn count ("R2", "R3")
+ * and a prime ("R'", "R2'") may follow each face letter. Returns the number
+ * of moves written, or -1 on a syntax error or if maxMoves is exceeded.
+ */
+int parseAlgorithm(const char* text, uint8_t* moves, int maxMoves) {
+    int count = 0;
+    const char* p = text;
+
+    while (*p) {
+        if (isspace((unsigned char)*p)) {
+            p++;
+            continue;
+        }
+
+        int face = faceFromLetter(*p++);
+        if (face < 0) return -1;
+
+        int turns = 1;
+        if (isdigit((unsigned char)*p)) {
+            turns = 0;
+            while (isdigit((unsigned char)*p)) turns = (turns * 10 + (*p++ - '0')) % 4;
+        }
+        if (*p == '\'') {
+            turns = (4 - turns) % 4;
+            p++;
+        }
+        if (turns == 0) continue;  // R4, R0 and friends are no-ops
+
+        if (count >= maxMoves) return -1;
+        moves[count++] = (uint8_t)moveFromFace((FaceID)face, turns);
+    }
+
+    return count;
+}
+
+// Write moves as space-separated notation; returns the length, or -1 if it does not fit
+int formatAlgorithm(const uint8_t* moves, int count, char* buffer, size_t size) {
+    size_t length = 0;
+    if (size == 0) return -1;
+    buffer[0] = '\0';
+
+    for (int i = 0; i < count; i++) {
+        const char* name = moveName((Move)moves[i]);
+        size_t nameLength = strlen(name);
+        size_t needed = nameLength + (i > 0 ? 1 : 0);
+        if (length + needed + 1 > size) return -1;
+
+        if (i > 0) buffer[length++] = ' ';
+        memcpy(buffer + length, name, nameLength);
+        length += nameLength;
+        buffer[length] = '\0';
+    }
+
+    return (int)length;
+}
+
+bool cubeStateApplyAlgorithm(CubeState* state, const char* text) {
+    uint8_t moves[ALGORITHM_MAX_MOVES];
+    int count = parseAlgorithm(text, moves, ALGORITHM_MAX_MOVES);
+    if (count < 0) return false;
+
+    cubeStateApplyMoves(state, moves, count);
+    return true;
+}
+
+// Compile once, then one multiply per state
+bool cubeStatesApplyAlgorithm(CubeState* states, size_t count, const char* text) {
+    CompiledAlgorithm compiled;
+    if (!compileAlgorithm(text, &compiled)) return false;
+
+    cubeStatesApplyCompiled(states, count, &compiled);
+    return true;
+}
+
+void compileMoves(const uint8_t* moves, int count, CompiledAlgorithm* compiled) {
+    cubeStateInit(&compiled->transform);
+    cubeStateApplyMoves(&compiled->transform, moves, count);
+
+    // A move's gather composed after the ones before it: sticker i comes from facelets[table[i]]
+    uint8_t facelets[FACELET_COUNT];
+    for (int i = 0; i < FACELET_COUNT; i++) compiled->facelets[i] = (uint8_t)i;
+    for (int k = 0; k < count; k++) {
+        const uint8_t* table = faceletMoveTable[moves[k]];
+        for (int i = 0; i < FACELET_COUNT; i++) facelets[i] = compiled->facelets[table[i]];
+        memcpy(compiled->facelets, facelets, FACELET_COUNT);
+    }
+    compiled->moveCount = count;
+}
+
+bool compileAlgorithm(const char* text, CompiledAlgorithm* compiled) {
+    uint8_t moves[ALGORITHM_MAX_MOVES];
+    int count = parseAlgorithm(text, moves, ALGORITHM_MAX_MOVES);
+    if (count < 0) return false;
+
+    compileMoves(moves, count, compiled);
+    return true;
+}
+
+// FNV-1a
+static uint64_t hashText(const char* text) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (const unsigned char* p = (const unsigned char*)text; *p; p++) hash = (hash ^ *p) * 0x100000001b3ull;
+    return hash;
+}
+
+static CacheEntry* cacheFind(const char* text, uint64_t hash) {
+    if (cacheCapacity == 0) return NULL;
+    for (size_t i = hash & (cacheCapacity - 1); cacheSlots[i]; i = (i + 1) & (cacheCapacity - 1)) {
+        if (cacheSlots[i]->hash == hash && strcmp(cacheSlots[i]->text, text) == 0) return cacheSlots[i];
+    }
+    return NULL;
+}
+
+static bool cacheInsert(CacheEntry* entry) {
+    if ((cacheCount + 1) * 2 > cacheCapacity) {
+        size_t capacity = cacheCapacity ? cacheCapacity * 2 : CACHE_INITIAL_CAPACITY;
+        CacheEntry** slots = calloc(capacity, sizeof(CacheEntry*));
+        if (!slots) return false;
+        for (size_t i = 0; i < cacheCapacity; i++) {
+            if (!cacheSlots[i]) continue;
+            size_t j = cacheSlots[i]->hash & (capacity - 1);
+            while (slots[j]) j = (j + 1) & (capacity - 1);
+            slots[j] = cacheSlots[i];
+        }
+        free(cacheSlots);
+        cacheSlots = slots;
+        cacheCapacity = capacity;
+    }
+
+    size_t i = entry->hash & (cacheCapacity - 1);
+    while (cacheSlots[i]) i = (i + 1) & (cacheCapacity - 1);
+    cacheSlots[i] = entry;
+    cacheCount++;
+    return true;
+}
+
+/**
+ * The compiled form of text, compiled on the first request for that exact
+ * string and shared after that. Returns NULL on a syntax error or if out of
+ * memory. The result stays valid until compiledAlgorithmCacheClear.
+ */
+const CompiledAlgorithm* compiledAlgorithmGet(const char* text) {
+    uint64_t hash = hashText(text);
+    pthread_rwlock_rdlock(&cacheLock);
+    CacheEntry* entry = cacheFind(text, hash);
+    pthread_rwlock_unlock(&cacheLock);
+    if (entry) return &entry->compiled;
+
+    // Compile outside the lock; if another thread gets there first, its entry wins
+    CompiledAlgorithm compiled;
+    if (!compileAlgorithm(text, &compiled)) return NULL;
+
+    pthread_rwlock_wrlock(&cacheLock);
+    entry = cacheFind(text, hash);
+    if (!entry) {
+        entry = malloc(sizeof(CacheEntry));
+        char* copy = strdup(text);
+        if (!entry || !copy) {
+            free(entry);
+            free(copy);
+            entry = NULL;
+        } else {
+            entry->text = copy;
+            entry->hash = hash;
+            entry->compiled = compiled;
+            if (!cacheInsert(entry)) {
+                free(entry->text);
+                free(entry);
+                entry = NULL;
+            }
+        }
+    }
+    pthread_rwlock_unlock(&cacheLock);
+    return entry ? &entry->compiled : NULL;
+}
+
+// Free every cached algorithm; pointers from compiledAlgorithmGet are invalid afterwards
+void compiledAlgorithmCacheClear(void) {
+    pthread_rwlock_wrlock(&cacheLock);
+    for (size_t i = 0; i < cacheCapacity; i++) {
+        if (!cacheSlots[i]) continue;
+        free(cacheSlots[i]->text);
+        free(cacheSlots[i]);
+    }
+    free(cacheSlots);
+    cacheSlots = NULL;
+    cacheCapacity = cacheCount = 0;
+    pthread_rwlock_unlock(&cacheLock);
+}
+
+void cubeStateApplyCompiled(CubeState* state, const CompiledAlgorithm* compiled) {
+    cubeStateMultiply(state, &compiled->transform, state);
+}
+
+void cubeStatesApplyCompiled(CubeState* states, size_t count, const CompiledAlgorithm* compiled) {
+    for (size_t i = 0; i < count; i++) {
+        cubeStateMultiply(&states[i], &compiled->transform, &states[i]);
+    }
+}
+
+void faceletCubeApplyCompiled(FaceletCube* cube, const CompiledAlgorithm* compiled) {
+    FaceletCube out;
+    for (int i = 0; i < FACELET_COUNT; i++) {
+        out.f[i] = cube->f[compiled->facelets[i]];
+    }
+    *cube = out;
+}
+
+// Cycles of one kind of piece; slots left alone and untwisted are skipped
+static int findCycles(const uint8_t* perm, const uint8_t* orientation, int n, bool edges, AlgorithmCycle* cycles) {
+    uint8_t destination[EDGE_COUNT];
+    bool seen[EDGE_COUNT] = { false };
+    int base = edges ? 2 : 3, count = 0;
+    for (int i = 0; i < n; i++) destination[perm[i]] = (uint8_t)i;
+
+    for (int start = 0; start < n; start++) {
+        if (seen[start]) continue;
+        AlgorithmCycle cycle = { .edges = edges };
+        int twist = 0;
+        for (int slot = start; !seen[slot]; slot = destination[slot]) {
+            seen[slot] = true;
+            cycle.slots[cycle.length++] = (uint8_t)slot;
+            twist += orientation[slot];
+        }
+        cycle.twist = (uint8_t)(twist % base);
+        if (cycle.length > 1 || cycle.twist) cycles[count++] = cycle;
+    }
+    return count;
+}
+
+// Corner cycles, then edge cycles; cycles must hold ALGORITHM_MAX_CYCLES. Returns how many
+int compiledAlgorithmCycles(const CompiledAlgorithm* compiled, AlgorithmCycle* cycles) {
+    const CubeState* t = &compiled->transform;
+    int count = findCycles(t->cp, t->co, CORNER_COUNT, false, cycles);
+    return count + findCycles(t->ep, t->eo, EDGE_COUNT, true, cycles + count);
+}
+
+static int gcd(int a, int b) {
+    while (b) {
+        int r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+/**
+ * How many times the algorithm has to be repeated to get back to where it
+ * started: the least common multiple of its cycle lengths, a cycle that
+ * comes back twisted (flipped) counting three (two) times its length.
+ */
+int compiledAlgorithmOrder(const CompiledAlgorithm* compiled) {
+    AlgorithmCycle cycles[ALGORITHM_MAX_CYCLES];
+    int count = compiledAlgorithmCycles(compiled, cycles);
+    int order = 1;
+    for (int i = 0; i < count; i++) {
+        int period = cycles[i].length * (cycles[i].twist ? (cycles[i].edges ? 2 : 3) : 1);
+        order = order / gcd(order, period) * period;
+    }
+    return order;
+}
+
+/**
+ * Write cycles in Singmaster's notation, "(URF UBR UFL) (UF UR)+": a cycle
+ * that comes back twisted clockwise or flipped ends in +, anticlockwise in
+ * -. Returns the length, or -1 if it does not fit.
+ */
+int formatCycles(const AlgorithmCycle* cycles, int count, char* buffer, size_t size) {
+    size_t length = 0;
+    if (size == 0) return -1;
+    buffer[0] = '\0';
+
+    for (int i = 0; i < count; i++) {
+        char text[64];
+        size_t textLength = 0;
+        if (i > 0) text[textLength++] = ' ';
+        text[textLength++] = '(';
+        for (int k = 0; k < cycles[i].length; k++) {
+            const char* name = cycles[i].edges ? edgeNames[cycles[i].slots[k]] : cornerNames[cycles[i].slots[k]];
+            if (k > 0) text[textLength++] = ' ';
+            memcpy(text + textLength, name, strlen(name));
+            textLength += strlen(name);
+        }
+        text[textLength++] = ')';
+        if (cycles[i].twist) text[textLength++] = cycles[i].twist == 2 ? '-' : '+';
+
+        if (length + textLength + 1 > size) return -1;
+        memcpy(buffer + length, text, textLength);
+        length += textLength;
+        buffer[length] = '\0';
+    }
+
+    return (int)length;
+}
@@ -0,0 +1,101 @@
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+#include "algorithm.h"
+#include "batchjob.h"
+#include "symmetry.h"
+
+static const char* const commandNames[] = {"apply", "verify", "solve", "canonicalise"};
+
+bool batchCommandFromName(const char* name, BatchCommand* command) {
+    for (int i = 0; i < (int)(sizeof(commandNames) / sizeof(commandNames[0])); i++) {
+        if (strcmp(name, commandNames[i]) == 0) {
+            *command = (BatchCommand)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool fail(const char* reason, char* out, size_t* outLength) {
+    *outLength = (size_t)snprintf(out, BATCH_MAX_OUTPUT, "error: %s", reason);
+    return false;
+}
+
+// Read the state a line names; returns NULL, or why it names none
+static const char* lineState(const char* line, size_t length, CubeState* state) {
+    while (length > 0 && isspace((unsigned char)line[length - 1])) length--;
+    while (length > 0 && isspace((unsigned char)*line)) {
+        line++;
+        length--;
+    }
+
+    size_t token = 0;
+    while (token < length && !isspace((unsigned char)line[token])) token++;
+
+    FaceletCube facelets;
+    size_t rest = 0;
+    if (faceletCubeParse(line, token, &facelets)) {
+        if (!faceletsToCubeState(&facelets, state)) return "not a solvable cube";
+        rest = token;
+    } else {
+        cubeStateInit(state);
+    }
+
+    char text[ALGORITHM_MAX_MOVES * 4];
+    uint8_t moves[ALGORITHM_MAX_MOVES];
+    if (length - rest >= sizeof(text)) return "too many moves";
+    memcpy(text, line + rest, length - rest);
+    text[length - rest] = '\0';
+    int count = parseAlgorithm(text, moves, ALGORITHM_MAX_MOVES);
+    if (count < 0) return "not a facelet string or moves";
+    cubeStateApplyMoves(state, moves, count);
+    return NULL;
+}
+
+/**
+ * Run the command on one line (without its newline) and write the result
+ * line to out, BATCH_MAX_OUTPUT bytes, unterminated, its length in
+ * outLength. Returns false if the result is an error line. Safe to call
+ * from any number of threads at once.
+ */
+bool batchProcessLine(const BatchOptions* options, const char* line, size_t length, char* out, size_t* outLength) {
+    CubeState state;
+    const char* error = lineState(line, length, &state);
+    if (error) return fail(error, out, outLength);
+
+    FaceletCube facelets;
+    switch (options->command) {
+        case BATCH_APPLY:
+            cubeStateToFacelets(&state, &facelets);
+            faceletCubeFormat(&facelets, out);
+            *outLength = FACELET_COUNT;
+            return true;
+        case BATCH_VERIFY: {
+            const char* verdict = cubeStateIsSolved(&state) ? "solved" : "unsolved";
+            *outLength = strlen(verdict);
+            memcpy(out, verdict, *outLength);
+            return true;
+        }
+        case BATCH_SOLVE: {
+            uint8_t moves[SOLVER_MAX_LENGTH];
+            int count = solverSolve(options->solver, &state, options->targetLength, options->timeLimit, moves);
+            if (count < 0) return fail("no solution found", out, outLength);
+            char text[BATCH_MAX_OUTPUT];
+            int written = formatAlgorithm(moves, count, text, sizeof(text));
+            if (written < 0) return fail("solution too long", out, outLength);
+            memcpy(out, text, (size_t)written);
+            *outLength = (size_t)written;
+            return true;
+        }
+        case BATCH_CANONICALISE: {
+            CubeState canonical;
+            cubeStateCanonical(&state, options->antisymmetry, &canonical);
+            cubeStateToFacelets(&canonical, &facelets);
+            faceletCubeFormat(&facelets, out);
+            *outLength = FACELET_COUNT;
+            return true;
+        }
+    }
+    return fail("unknown command", out, outLength);
+}
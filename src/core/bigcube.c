@@ -0,0 +1,232 @@
+#include <stdlib.h>
+#include <string.h>
+#include "bigcube.h"
+
+// Where each sticker block sits in space: its face, the corner of its first
+// sticker (-1 = low end of the axis, 1 = high end) and the grid steps along
+// a row and down to the next row
+static const struct {
+    FaceID face;
+    int8_t origin[3];
+    int8_t colStep[3];
+    int8_t rowStep[3];
+} stickerLayout[FACE_COUNT] = {
+    {FACE_TOP,    {-1,  1, -1}, { 1, 0,  0}, {0,  0,  1}},
+    {FACE_RIGHT,  { 1,  1,  1}, { 0, 0, -1}, {0, -1,  0}},
+    {FACE_FRONT,  {-1,  1,  1}, { 1, 0,  0}, {0, -1,  0}},
+    {FACE_BOTTOM, {-1, -1,  1}, { 1, 0,  0}, {0,  0, -1}},
+    {FACE_LEFT,   {-1,  1, -1}, { 0, 0,  1}, {0, -1,  0}},
+    {FACE_BACK,   { 1,  1, -1}, {-1, 0,  0}, {0, -1,  0}},
+};
+
+// Outward normal of each FaceID
+static const int8_t faceNormal[FACE_COUNT][3] = {
+    {0, 0, 1}, {0, 0, -1}, {-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0},
+};
+
+FaceID stickerFace(int size, int sticker) {
+    return stickerLayout[sticker / (size * size)].face;
+}
+
+// Grid coordinates (0..size-1 per axis) of the cubie carrying this sticker
+void stickerPosition(int size, int sticker, int position[3]) {
+    int block = sticker / (size * size);
+    int row = sticker % (size * size) / size;
+    int col = sticker % size;
+    for (int axis = 0; axis < 3; axis++) {
+        int origin = stickerLayout[block].origin[axis] < 0 ? 0 : size - 1;
+        position[axis] = origin
+            + col * stickerLayout[block].colStep[axis]
+            + row * stickerLayout[block].rowStep[axis];
+    }
+}
+
+static int stickerIndex(int size, FaceID face, const int position[3]) {
+    int block = 0;
+    while (stickerLayout[block].face != face) block++;
+
+    int row = 0, col = 0;
+    for (int axis = 0; axis < 3; axis++) {
+        int origin = stickerLayout[block].origin[axis] < 0 ? 0 : size - 1;
+        col += (position[axis] - origin) * stickerLayout[block].colStep[axis];
+        row += (position[axis] - origin) * stickerLayout[block].rowStep[axis];
+    }
+    return block * size * size + row * size + col;
+}
+
+static FaceID faceFromNormal(const int normal[3]) {
+    for (int face = 0; face < FACE_COUNT; face++) {
+        if (faceNormal[face][0] == normal[0] && faceNormal[face][1] == normal[1] && faceNormal[face][2] == normal[2]) {
+            return (FaceID)face;
+        }
+    }
+    return FACE_FRONT;
+}
+
+// Rotate v a quarter turn clockwise seen from the positive end of the axis
+static void quarterTurn(int axis, int v[3]) {
+    int x = v[0], y = v[1], z = v[2];
+    switch (axis) {
+        case 0: v[1] = z;  v[2] = -y; break;
+        case 1: v[0] = -z; v[2] = x;  break;
+        default: v[0] = y; v[1] = -x; break;
+    }
+}
+
+// Where a clockwise quarter turn about the axis carries a sticker
+static int turnedSticker(int size, int axis, int sticker) {
+    int position[3], normal[3];
+    stickerPosition(size, sticker, position);
+    FaceID face = stickerFace(size, sticker);
+
+    // Doubled coordinates keep the centre of even cubes on the integer grid
+    for (int i = 0; i < 3; i++) {
+        position[i] = 2 * position[i] - (size - 1);
+        normal[i] = faceNormal[face][i];
+    }
+    quarterTurn(axis, position);
+    quarterTurn(axis, normal);
+    for (int i = 0; i < 3; i++) position[i] = (position[i] + size - 1) / 2;
+
+    return stickerIndex(size, faceFromNormal(normal), position);
+}
+
+/**
+ * Build the index lists of every slice once: the stickers it carries (for
+ * the renderer, bucketed by grid coordinate in one pass per axis) and the
+ * 4-cycles one quarter turn makes of them (for bigCubeApplyMove). A face
+ * centre of an odd cube maps onto itself and is carried but never cycled.
+ */
+static void buildLayers(BigCube* cube) {
+    int size = cube->size;
+    uint32_t* fill = calloc((size_t)(3 * size + 1), sizeof(uint32_t));
+    uint8_t* seen = calloc((size_t)cube->stickerCount, 1);
+
+    for (int s = 0; s < cube->stickerCount; s++) {
+        int position[3];
+        stickerPosition(size, s, position);
+        for (int axis = 0; axis < 3; axis++) fill[axis * size + position[axis] + 1]++;
+    }
+    for (int slice = 0; slice < 3 * size; slice++) fill[slice + 1] += fill[slice];
+    memcpy(cube->layerOffset, fill, sizeof(uint32_t) * (3 * size + 1));
+
+    for (int s = 0; s < cube->stickerCount; s++) {
+        int position[3];
+        stickerPosition(size, s, position);
+        for (int axis = 0; axis < 3; axis++) cube->layerStickers[fill[axis * size + position[axis]]++] = (uint32_t)s;
+    }
+
+    uint32_t cycleCount = 0;
+    for (int slice = 0; slice < 3 * size; slice++) {
+        int axis = slice / size;
+        cube->cycleOffset[slice] = cycleCount;
+
+        for (uint32_t i = cube->layerOffset[slice]; i < cube->layerOffset[slice + 1]; i++) {
+            int s = (int)cube->layerStickers[i];
+            if (seen[s] || turnedSticker(size, axis, s) == s) continue;
+            for (int k = 0, current = s; k < 4; k++) {
+                seen[current] = 1;
+                cube->cycles[cycleCount++] = (uint32_t)current;
+                current = turnedSticker(size, axis, current);
+            }
+        }
+        for (uint32_t i = cube->layerOffset[slice]; i < cube->layerOffset[slice + 1]; i++) {
+            seen[cube->layerStickers[i]] = 0;
+        }
+    }
+    cube->cycleOffset[3 * size] = cycleCount;
+    free(seen);
+    free(fill);
+}
+
+bool bigCubeInit(BigCube* cube, int size) {
+    memset(cube, 0, sizeof(*cube));
+    if (size < BIGCUBE_MIN_SIZE || size > BIGCUBE_MAX_SIZE) return false;
+
+    // Every slice carries a 4 * size ring, the two outer ones a face too
+    size_t listSize = (size_t)18 * size * size;
+    cube->size = size;
+    cube->stickerCount = FACE_COUNT * size * size;
+    cube->stickers = malloc((size_t)cube->stickerCount);
+    cube->layerOffset = malloc(sizeof(uint32_t) * (3 * size + 1));
+    cube->layerStickers = malloc(sizeof(uint32_t) * listSize);
+    cube->cycleOffset = malloc(sizeof(uint32_t) * (3 * size + 1));
+    cube->cycles = malloc(sizeof(uint32_t) * listSize);
+    if (!cube->stickers || !cube->layerOffset || !cube->layerStickers || !cube->cycleOffset || !cube->cycles) {
+        bigCubeFree(cube);
+        return false;
+    }
+
+    buildLayers(cube);
+    bigCubeReset(cube);
+    return true;
+}
+
+void bigCubeFree(BigCube* cube) {
+    free(cube->stickers);
+    free(cube->layerOffset);
+    free(cube->layerStickers);
+    free(cube->cycleOffset);
+    free(cube->cycles);
+    memset(cube, 0, sizeof(*cube));
+}
+
+void bigCubeReset(BigCube* cube) {
+    int perFace = cube->size * cube->size;
+    for (int block = 0; block < FACE_COUNT; block++) {
+        memset(cube->stickers + block * perFace, stickerLayout[block].face, (size_t)perFace);
+    }
+}
+
+// Rotate each 4-cycle of the slice by the turn count: O(size^2) stickers touched
+void bigCubeApplyMove(BigCube* cube, LayerMove move) {
+    int slice = move.axis * cube->size + move.layer;
+    int turns = move.turns & 3;
+    uint8_t* s = cube->stickers;
+
+    for (uint32_t i = cube->cycleOffset[slice]; i < cube->cycleOffset[slice + 1]; i += 4) {
+        const uint32_t* c = &cube->cycles[i];
+        uint8_t v[4] = {s[c[0]], s[c[1]], s[c[2]], s[c[3]]};
+        for (int k = 0; k < 4; k++) {
+            s[c[(k + turns) & 3]] = v[k];
+        }
+    }
+}
+
+bool bigCubeIsSolved(const BigCube* cube) {
+    int perFace = cube->size * cube->size;
+    for (int block = 0; block < FACE_COUNT; block++) {
+        const uint8_t* face = cube->stickers + block * perFace;
+        for (int i = 1; i < perFace; i++) {
+            if (face[i] != face[0]) return false;
+        }
+    }
+    return true;
+}
+
+const uint32_t* bigCubeLayerStickers(const BigCube* cube, int axis, int layer, int* count) {
+    int slice = axis * cube->size + layer;
+    *count = (int)(cube->layerOffset[slice + 1] - cube->layerOffset[slice]);
+    return &cube->layerStickers[cube->layerOffset[slice]];
+}
+
+/**
+ * The slice turned by a face move: depth 1 is the face itself, 2 the slice
+ * behind it and so on. quarterTurns counts clockwise as seen from that face,
+ * so faces on the negative side of their axis flip the direction.
+ */
+LayerMove layerMoveFromFace(int size, FaceID face, int depth, int quarterTurns) {
+    LayerMove move;
+    int axis = 0;
+    while (faceNormal[face][axis] == 0) axis++;
+
+    bool positive = faceNormal[face][axis] > 0;
+    move.axis = (uint8_t)axis;
+    move.layer = (uint8_t)(positive ? size - depth : depth - 1);
+    move.turns = (uint8_t)(positive ? quarterTurns & 3 : (4 - quarterTurns) & 3);
+    return move;
+}
+
+LayerMove layerMoveFromMove(int size, Move move) {
+    return layerMoveFromFace(size, moveFace(move), 1, moveQuarterTurns(move));
+}
@@ -0,0 +1,178 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cubefarm.h"
+
+typedef struct {
+    CubeFarm* farm;
+    const Solver* solver;
+    int script;
+    uint32_t seed;
+} ScriptTask;
+
+static uint32_t nextRandom(uint32_t* state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+bool cubeFarmInit(CubeFarm* farm, int count, int scriptCount, float turnDuration) {
+    memset(farm, 0, sizeof(*farm));
+    if (count <= 0 || scriptCount <= 0 || scriptCount > UINT16_MAX) return false;
+
+    farm->cubes = calloc((size_t)count, sizeof(FarmCube));
+    farm->scripts = calloc((size_t)scriptCount, sizeof(FarmScript));
+    if (!farm->cubes || !farm->scripts) {
+        cubeFarmFree(farm);
+        return false;
+    }
+    farm->count = count;
+    farm->scriptCount = scriptCount;
+    farm->turnDuration = turnDuration;
+    return true;
+}
+
+void cubeFarmFree(CubeFarm* farm) {
+    free(farm->cubes);
+    free(farm->scripts);
+    memset(farm, 0, sizeof(*farm));
+}
+
+/**
+ * A random scramble with no move undoing or merging into the one before,
+ * then a way back: the solver's solution, or without a solver (or if it
+ * fails) the scramble reversed.
+ */
+static void buildScript(void* arg, int worker) {
+    (void)worker;
+    ScriptTask* task = arg;
+    FarmScript* script = &task->farm->scripts[task->script];
+    uint32_t random = task->seed ? task->seed : 1;
+
+    for (int i = 0; i < CUBE_FARM_SCRAMBLE_LENGTH; i++) {
+        Move move;
+        do {
+            move = (Move)(nextRandom(&random) % MOVE_COUNT);
+        } while (i > 0 && moveIsRedundant((Move)script->moves[i - 1], move));
+        script->moves[i] = (uint8_t)move;
+    }
+    script->scrambleLength = CUBE_FARM_SCRAMBLE_LENGTH;
+
+    int solutionLength = -1;
+    if (task->solver) {
+        CubeState state;
+        cubeStateInit(&state);
+        cubeStateApplyMoves(&state, script->moves, CUBE_FARM_SCRAMBLE_LENGTH);
+        solutionLength = solverSolve(task->solver, &state, SOLVER_DEFAULT_TARGET_LENGTH, SOLVER_DEFAULT_TIME_LIMIT,
+                                     script->moves + CUBE_FARM_SCRAMBLE_LENGTH);
+    }
+    if (solutionLength < 0) {
+        for (int i = 0; i < CUBE_FARM_SCRAMBLE_LENGTH; i++) {
+            script->moves[CUBE_FARM_SCRAMBLE_LENGTH + i] = (uint8_t)moveInverse((Move)script->moves[CUBE_FARM_SCRAMBLE_LENGTH - 1 - i]);
+        }
+        solutionLength = CUBE_FARM_SCRAMBLE_LENGTH;
+    }
+    script->length = CUBE_FARM_SCRAMBLE_LENGTH + solutionLength;
+}
+
+// Fill every script, one work item each; solver may be NULL
+void cubeFarmBuildScripts(CubeFarm* farm, const Solver* solver, WorkPool* pool, uint32_t seed) {
+    ScriptTask* tasks = malloc(sizeof(ScriptTask) * (size_t)farm->scriptCount);
+    for (int i = 0; i < farm->scriptCount; i++) {
+        ScriptTask local = {farm, solver, i, seed + (uint32_t)i * 2654435761u};
+        if (!tasks || !pool) {
+            buildScript(&local, 0);
+            continue;
+        }
+        tasks[i] = local;
+        if (!workPoolSubmit(pool, buildScript, &tasks[i])) buildScript(&tasks[i], -1);
+    }
+    if (tasks && pool) workPoolWait(pool);
+    free(tasks);
+}
+
+/**
+ * Lay the cubes out on a square grid in the y = 0 plane, centred on the
+ * origin, and start each at a random point of a random script.
+ */
+void cubeFarmStart(CubeFarm* farm, uint32_t seed) {
+    int side = (int)ceil(sqrt((double)farm->count));
+    float half = 0.5f * (float)(side - 1) * CUBE_FARM_SPACING;
+    uint32_t random = seed ? seed : 1;
+
+    for (int i = 0; i < farm->count; i++) {
+        FarmCube* cube = &farm->cubes[i];
+        cube->center[0] = (float)(i % side) * CUBE_FARM_SPACING - half;
+        cube->center[1] = 0.0f;
+        cube->center[2] = (float)(i / side) * CUBE_FARM_SPACING - half;
+
+        cube->script = (uint16_t)(nextRandom(&random) % (uint32_t)farm->scriptCount);
+        const FarmScript* script = &farm->scripts[cube->script];
+        cube->step = (uint8_t)(nextRandom(&random) % (uint32_t)(script->length + CUBE_FARM_REST_TURNS));
+        cube->progress = (float)(nextRandom(&random) % 1024) / 1024.0f;
+        faceletCubeInit(&cube->facelets);
+        for (int step = 0; step < cube->step && step < script->length; step++) {
+            faceletCubeApplyMove(&cube->facelets, (Move)script->moves[step]);
+        }
+    }
+}
+
+/**
+ * Advance cubes [first, last) by seconds. Each range can be updated from a
+ * different thread. Returns the number of turns that landed.
+ */
+int cubeFarmUpdate(CubeFarm* farm, int first, int last, float seconds) {
+    float advance = farm->turnDuration > 0.0f ? seconds / farm->turnDuration : 1.0f;
+    int landed = 0;
+
+    for (int i = first; i < last; i++) {
+        FarmCube* cube = &farm->cubes[i];
+        cube->progress += advance;
+
+        // A long frame can land several turns; a stall is not worth replaying turn by turn
+        for (int turns = 0; cube->progress >= 1.0f && turns < CUBE_FARM_MAX_SCRIPT; turns++) {
+            const FarmScript* script = &farm->scripts[cube->script];
+            cube->progress -= 1.0f;
+            if (cube->step < script->length) {
+                faceletCubeApplyMove(&cube->facelets, (Move)script->moves[cube->step]);
+                landed++;
+            }
+            if (++cube->step >= script->length + CUBE_FARM_REST_TURNS) {
+                cube->script = (uint16_t)((cube->script + 1) % farm->scriptCount);
+                cube->step = 0;
+            }
+        }
+        if (cube->progress >= 1.0f) cube->progress = 0.0f;
+    }
+    return landed;
+}
+
+/**
+ * The layer a cube is turning and its angle about the layer's +axis so far,
+ * with the same conventions as the single cube; false while it rests.
+ */
+bool cubeFarmTurn(const CubeFarm* farm, const FarmCube* cube, LayerMove* move, float* angle) {
+    const FarmScript* script = &farm->scripts[cube->script];
+    if (cube->step >= script->length) return false;
+
+    *move = layerMoveFromMove(3, (Move)script->moves[cube->step]);
+    const float quarter = 1.57079632679f;
+    float target = move->turns == 3 ? quarter : -quarter * (float)move->turns;
+    *angle = target * cube->progress;
+    return true;
+}
+
+/**
+ * Whether the cube's bounding sphere is at least partly inside the frustum
+ * given as six planes (a, b, c, d) with unit normals pointing inwards.
+ */
+bool cubeFarmVisible(const FarmCube* cube, const float planes[6][4]) {
+    for (int i = 0; i < 6; i++) {
+        const float* plane = planes[i];
+        float distance = plane[0] * cube->center[0] + plane[1] * cube->center[1] + plane[2] * cube->center[2] + plane[3];
+        if (distance < -CUBE_FARM_RADIUS) return false;
+    }
+    return true;
+}
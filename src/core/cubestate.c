@@ -0,0 +1,130 @@
+#include <string.h>
+#include "cubestate.h"
+#include "statecodec.h"
+
+// (a + b) % 3 for orientation sums, without a division
+static const uint8_t mod3[6] = {0, 1, 2, 0, 1, 2};
+
+static const char* moveNames[MOVE_COUNT] = {
+    "F", "F2", "F'", "B", "B2", "B'", "L", "L2", "L'",
+    "R", "R2", "R'", "D", "D2", "D'", "U", "U2", "U'",
+};
+
+void cubeStateInit(CubeState* state) {
+    for (int i = 0; i < CORNER_COUNT; i++) {
+        state->cp[i] = (uint8_t)i;
+        state->co[i] = 0;
+    }
+    for (int i = 0; i < EDGE_COUNT; i++) {
+        state->ep[i] = (uint8_t)i;
+        state->eo[i] = 0;
+    }
+}
+
+// result = a followed by b; result may alias a or b
+void cubeStateMultiply(const CubeState* a, const CubeState* b, CubeState* result) {
+    CubeState out;
+    for (int i = 0; i < CORNER_COUNT; i++) {
+        out.cp[i] = a->cp[b->cp[i]];
+        out.co[i] = mod3[a->co[b->cp[i]] + b->co[i]];
+    }
+    for (int i = 0; i < EDGE_COUNT; i++) {
+        out.ep[i] = a->ep[b->ep[i]];
+        out.eo[i] = a->eo[b->ep[i]] ^ b->eo[i];
+    }
+    *result = out;
+}
+
+void cubeStateInverse(const CubeState* state, CubeState* result) {
+    CubeState out;
+    for (int i = 0; i < CORNER_COUNT; i++) {
+        out.cp[state->cp[i]] = (uint8_t)i;
+        out.co[state->cp[i]] = (uint8_t)((3 - state->co[i]) % 3);
+    }
+    for (int i = 0; i < EDGE_COUNT; i++) {
+        out.ep[state->ep[i]] = (uint8_t)i;
+        out.eo[state->ep[i]] = state->eo[i];
+    }
+    *result = out;
+}
+
+// One gather per piece through the precomputed move, no per-move branching
+void cubeStateApplyMove(CubeState* state, Move move) {
+    cubeStateMultiply(state, &moveTable[move], state);
+}
+
+// Apply a binary move sequence, keeping the state in locals between moves
+void cubeStateApplyMoves(CubeState* state, const uint8_t* moves, int count) {
+    CubeState current = *state;
+    for (int i = 0; i < count; i++) {
+        cubeStateMultiply(&current, &moveTable[moves[i]], &current);
+    }
+    *state = current;
+}
+
+// Run the same sequence over every state; each state stays hot for the whole sequence
+void cubeStatesApplyMoves(CubeState* states, size_t count, const uint8_t* moves, int moveCount) {
+    for (size_t i = 0; i < count; i++) {
+        cubeStateApplyMoves(&states[i], moves, moveCount);
+    }
+}
+
+bool cubeStateEquals(const CubeState* a, const CubeState* b) {
+    return memcmp(a, b, sizeof(CubeState)) == 0;
+}
+
+bool cubeStateIsSolved(const CubeState* state) {
+    CubeState solved;
+    cubeStateInit(&solved);
+    return cubeStateEquals(state, &solved);
+}
+
+// True if the state is reachable from solved by face turns
+bool cubeStateIsValid(const CubeState* state) {
+    int seenCorners = 0, seenEdges = 0, twist = 0, flip = 0;
+    for (int i = 0; i < CORNER_COUNT; i++) {
+        if (state->cp[i] >= CORNER_COUNT || state->co[i] > 2) return false;
+        seenCorners |= 1 << state->cp[i];
+        twist += state->co[i];
+    }
+    for (int i = 0; i < EDGE_COUNT; i++) {
+        if (state->ep[i] >= EDGE_COUNT || state->eo[i] > 1) return false;
+        seenEdges |= 1 << state->ep[i];
+        flip += state->eo[i];
+    }
+    if (seenCorners != (1 << CORNER_COUNT) - 1 || seenEdges != (1 << EDGE_COUNT) - 1) return false;
+    if (twist % 3 != 0 || flip % 2 != 0) return false;
+    return permutationParity(state->cp, CORNER_COUNT) == permutationParity(state->ep, EDGE_COUNT);
+}
+
+// quarterTurns: 1 = clockwise, 2 = half turn, 3 = counter-clockwise
+Move moveFromFace(FaceID face, int quarterTurns) {
+    return (Move)(face * 3 + (quarterTurns - 1));
+}
+
+FaceID moveFace(Move move) {
+    return (FaceID)(move / 3);
+}
+
+int moveQuarterTurns(Move move) {
+    return move % 3 + 1;
+}
+
+Move moveInverse(Move move) {
+    return moveFromFace(moveFace(move), 4 - moveQuarterTurns(move));
+}
+
+/**
+ * True if move never needs to follow previous in a shortest sequence: two
+ * turns of the same face merge into one, and turns of opposite faces
+ * commute, so only one order of each such pair (the lower FaceID first) is
+ * kept. This rules out R L R, R R' and friends.
+ */
+bool moveIsRedundant(Move previous, Move move) {
+    FaceID last = moveFace(previous), face = moveFace(move);
+    return face == last || (face == (last ^ 1) && face < last);
+}
+
+const char* moveName(Move move) {
+    return (unsigned)move < MOVE_COUNT ? moveNames[move] : "?";
+}
@@ -0,0 +1,180 @@
+#include <stdlib.h>
+#include <string.h>
+#include "faceletbatch.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FACELET_BATCH_X86 1
+#endif
+
+// Cubes handled per block; every kernel walks the rows in blocks this wide
+#define BLOCK_WIDTH 32
+
+// The rows a move actually changes: a face turn moves 20 of the 54 stickers
+typedef struct {
+    int count;
+    uint8_t dst[FACELET_COUNT];
+    uint8_t src[FACELET_COUNT];
+} RowMoves;
+
+static void buildRowMoves(RowMoves rowMoves[MOVE_COUNT]) {
+    for (int m = 0; m < MOVE_COUNT; m++) {
+        RowMoves* r = &rowMoves[m];
+        r->count = 0;
+        for (int i = 0; i < FACELET_COUNT; i++) {
+            if (faceletMoveTable[m][i] != i) {
+                r->dst[r->count] = (uint8_t)i;
+                r->src[r->count] = faceletMoveTable[m][i];
+                r->count++;
+            }
+        }
+    }
+}
+
+bool faceletBatchInit(FaceletBatch* batch, size_t count) {
+    size_t stride = (count + FACELET_BATCH_ALIGN - 1) / FACELET_BATCH_ALIGN * FACELET_BATCH_ALIGN;
+    if (stride == 0) stride = FACELET_BATCH_ALIGN;
+
+    batch->data = aligned_alloc(FACELET_BATCH_ALIGN, stride * FACELET_COUNT);
+    if (!batch->data) return false;
+
+    batch->count = count;
+    batch->stride = stride;
+    for (int i = 0; i < FACELET_COUNT; i++) {
+        memset(batch->data + i * stride, faceletFace(i), stride);
+    }
+    return true;
+}
+
+void faceletBatchFree(FaceletBatch* batch) {
+    free(batch->data);
+    batch->data = NULL;
+    batch->count = 0;
+    batch->stride = 0;
+}
+
+void faceletBatchSet(FaceletBatch* batch, size_t index, const FaceletCube* cube) {
+    for (int i = 0; i < FACELET_COUNT; i++) {
+        batch->data[i * batch->stride + index] = cube->f[i];
+    }
+}
+
+void faceletBatchGet(const FaceletBatch* batch, size_t index, FaceletCube* cube) {
+    for (int i = 0; i < FACELET_COUNT; i++) {
+        cube->f[i] = batch->data[i * batch->stride + index];
+    }
+}
+
+static void applyScalar(FaceletBatch* batch, const RowMoves* rowMoves, const uint8_t* moves, int count) {
+    uint64_t tmp[FACELET_COUNT][BLOCK_WIDTH / 8];
+    for (size_t offset = 0; offset < batch->stride; offset += BLOCK_WIDTH) {
+        uint8_t* block = batch->data + offset;
+        for (int m = 0; m < count; m++) {
+            const RowMoves* r = &rowMoves[moves[m]];
+            for (int k = 0; k < r->count; k++) {
+                memcpy(tmp[k], block + r->src[k] * batch->stride, BLOCK_WIDTH);
+            }
+            for (int k = 0; k < r->count; k++) {
+                memcpy(block + r->dst[k] * batch->stride, tmp[k], BLOCK_WIDTH);
+            }
+        }
+    }
+}
+
+#ifdef FACELET_BATCH_X86
+__attribute__((target("sse2")))
+static void applySse2(FaceletBatch* batch, const RowMoves* rowMoves, const uint8_t* moves, int count) {
+    __m128i tmp[FACELET_COUNT];
+    for (size_t offset = 0; offset < batch->stride; offset += 16) {
+        uint8_t* block = batch->data + offset;
+        for (int m = 0; m < count; m++) {
+            const RowMoves* r = &rowMoves[moves[m]];
+            for (int k = 0; k < r->count; k++) {
+                tmp[k] = _mm_load_si128((const __m128i*)(block + r->src[k] * batch->stride));
+            }
+            for (int k = 0; k < r->count; k++) {
+                _mm_store_si128((__m128i*)(block + r->dst[k] * batch->stride), tmp[k]);
+            }
+        }
+    }
+}
+
+__attribute__((target("avx2")))
+static void applyAvx2(FaceletBatch* batch, const RowMoves* rowMoves, const uint8_t* moves, int count) {
+    __m256i tmp[FACELET_COUNT];
+    for (size_t offset = 0; offset < batch->stride; offset += 32) {
+        uint8_t* block = batch->data + offset;
+        for (int m = 0; m < count; m++) {
+            const RowMoves* r = &rowMoves[moves[m]];
+            for (int k = 0; k < r->count; k++) {
+                tmp[k] = _mm256_load_si256((const __m256i*)(block + r->src[k] * batch->stride));
+            }
+            for (int k = 0; k < r->count; k++) {
+                _mm256_store_si256((__m256i*)(block + r->dst[k] * batch->stride), tmp[k]);
+            }
+        }
+    }
+}
+#endif
+
+bool faceletKernelSupported(FaceletKernel kernel) {
+    switch (kernel) {
+        case FACELET_KERNEL_AUTO:
+        case FACELET_KERNEL_SCALAR:
+            return true;
+#ifdef FACELET_BATCH_X86
+        case FACELET_KERNEL_SSE2:
+            return __builtin_cpu_supports("sse2");
+        case FACELET_KERNEL_AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+const char* faceletKernelName(FaceletKernel kernel) {
+    switch (kernel) {
+        case FACELET_KERNEL_AUTO: return "auto";
+        case FACELET_KERNEL_SCALAR: return "scalar";
+        case FACELET_KERNEL_SSE2: return "sse2";
+        case FACELET_KERNEL_AVX2: return "avx2";
+        default: return "?";
+    }
+}
+
+/**
+ * Apply a sequence with a specific kernel. The whole sequence runs over one
+ * block of cubes before moving on, so each block stays in L1 (54 rows of at
+ * most 32 bytes). Returns false if the CPU lacks the requested kernel.
+ */
+bool faceletBatchApplyMovesWith(FaceletBatch* batch, const uint8_t* moves, int count, FaceletKernel kernel) {
+    if (!faceletKernelSupported(kernel)) return false;
+
+    if (kernel == FACELET_KERNEL_AUTO) {
+        kernel = faceletKernelSupported(FACELET_KERNEL_AVX2) ? FACELET_KERNEL_AVX2
+               : faceletKernelSupported(FACELET_KERNEL_SSE2) ? FACELET_KERNEL_SSE2
+               : FACELET_KERNEL_SCALAR;
+    }
+
+    RowMoves rowMoves[MOVE_COUNT];
+    buildRowMoves(rowMoves);
+
+    switch (kernel) {
+#ifdef FACELET_BATCH_X86
+        case FACELET_KERNEL_AVX2: applyAvx2(batch, rowMoves, moves, count); break;
+        case FACELET_KERNEL_SSE2: applySse2(batch, rowMoves, moves, count); break;
+#endif
+        default: applyScalar(batch, rowMoves, moves, count); break;
+    }
+    return true;
+}
+
+void faceletBatchApplyMoves(FaceletBatch* batch, const uint8_t* moves, int count) {
+    faceletBatchApplyMovesWith(batch, moves, count, FACELET_KERNEL_AUTO);
+}
+
+void faceletBatchApplyMove(FaceletBatch* batch, Move move) {
+    uint8_t m = (uint8_t)move;
+    faceletBatchApplyMovesWith(batch, &m, 1, FACELET_KERNEL_AUTO);
+}
@@ -0,0 +1,132 @@
+#include <string.h>
+#include "bigcube.h"
+#include "facelets.h"
+
+// Letter of each FaceID in facelet strings
+static const char faceLetters[FACE_COUNT] = {'F', 'B', 'L', 'R', 'D', 'U'};
+
+// Facelets touched by each corner and edge slot, in orientation order
+const uint8_t cornerFacelet[CORNER_COUNT][3] = {
+    {8, 9, 20}, {6, 18, 38}, {0, 36, 47}, {2, 45, 11},
+    {29, 26, 15}, {27, 44, 24}, {33, 53, 42}, {35, 17, 51},
+};
+
+const uint8_t edgeFacelet[EDGE_COUNT][2] = {
+    {5, 10}, {7, 19}, {3, 37}, {1, 46}, {32, 16}, {28, 25},
+    {30, 43}, {34, 52}, {23, 12}, {21, 41}, {50, 39}, {48, 14},
+};
+
+void faceletCubeInit(FaceletCube* cube) {
+    for (int i = 0; i < FACELET_COUNT; i++) {
+        cube->f[i] = (uint8_t)faceletFace(i);
+    }
+}
+
+void faceletCubeApplyMove(FaceletCube* cube, Move move) {
+    const uint8_t* src = faceletMoveTable[move];
+    FaceletCube out;
+    for (int i = 0; i < FACELET_COUNT; i++) {
+        out.f[i] = cube->f[src[i]];
+    }
+    *cube = out;
+}
+
+void cubeStateToFacelets(const CubeState* state, FaceletCube* cube) {
+    faceletCubeInit(cube);
+    for (int i = 0; i < CORNER_COUNT; i++) {
+        for (int j = 0; j < 3; j++) {
+            int facelet = cornerFacelet[i][(j + state->co[i]) % 3];
+            cube->f[facelet] = (uint8_t)faceletFace(cornerFacelet[state->cp[i]][j]);
+        }
+    }
+    for (int i = 0; i < EDGE_COUNT; i++) {
+        for (int j = 0; j < 2; j++) {
+            int facelet = edgeFacelet[i][(j + state->eo[i]) & 1];
+            cube->f[facelet] = (uint8_t)faceletFace(edgeFacelet[state->ep[i]][j]);
+        }
+    }
+}
+
+/**
+ * Recover the cubie state behind a sticker pattern: each corner is found by
+ * where its U/D sticker points and the two colours after it, each edge by
+ * its colour pair in either order. Returns false if a piece matches nothing
+ * or the result is not a reachable state.
+ */
+bool faceletsToCubeState(const FaceletCube* cube, CubeState* state) {
+    for (int i = 0; i < CORNER_COUNT; i++) {
+        int ori = 0;
+        while (ori < 3) {
+            uint8_t color = cube->f[cornerFacelet[i][ori]];
+            if (color == FACE_TOP || color == FACE_BOTTOM) break;
+            ori++;
+        }
+        if (ori == 3) return false;
+
+        uint8_t color1 = cube->f[cornerFacelet[i][(ori + 1) % 3]];
+        uint8_t color2 = cube->f[cornerFacelet[i][(ori + 2) % 3]];
+        int j = 0;
+        while (j < CORNER_COUNT && (color1 != faceletFace(cornerFacelet[j][1]) || color2 != faceletFace(cornerFacelet[j][2]))) j++;
+        if (j == CORNER_COUNT) return false;
+        state->cp[i] = (uint8_t)j;
+        state->co[i] = (uint8_t)ori;
+    }
+
+    for (int i = 0; i < EDGE_COUNT; i++) {
+        uint8_t color0 = cube->f[edgeFacelet[i][0]];
+        uint8_t color1 = cube->f[edgeFacelet[i][1]];
+        int j = 0;
+        for (; j < EDGE_COUNT; j++) {
+            FaceID home0 = faceletFace(edgeFacelet[j][0]);
+            FaceID home1 = faceletFace(edgeFacelet[j][1]);
+            if (color0 == home0 && color1 == home1) {
+                state->eo[i] = 0;
+                break;
+            }
+            if (color0 == home1 && color1 == home0) {
+                state->eo[i] = 1;
+                break;
+            }
+        }
+        if (j == EDGE_COUNT) return false;
+        state->ep[i] = (uint8_t)j;
+    }
+
+    return cubeStateIsValid(state);
+}
+
+FaceID faceletFace(int facelet) {
+    return stickerFace(3, facelet);
+}
+
+// Grid coordinates (-1..1 per axis) of the cubelet carrying this facelet
+void faceletPosition(int facelet, int position[3]) {
+    stickerPosition(3, facelet, position);
+    for (int axis = 0; axis < 3; axis++) position[axis] -= 1;
+}
+
+/**
+ * Read a facelet string: 54 letters U R F D L B in facelet order, each the
+ * face whose colour the sticker has (the solved cube is nine U, nine R...).
+ * Only checks the letters and that the centres are where they belong;
+ * faceletsToCubeState checks the rest.
+ */
+bool faceletCubeParse(const char* text, size_t length, FaceletCube* cube) {
+    if (length != FACELET_COUNT) return false;
+
+    for (int i = 0; i < FACELET_COUNT; i++) {
+        const char* letter = memchr(faceLetters, text[i], FACE_COUNT);
+        if (!letter || text[i] == '\0') return false;
+        cube->f[i] = (uint8_t)(letter - faceLetters);
+    }
+    for (int face = 0; face < FACE_COUNT; face++) {
+        int centre = face * 9 + 4;
+        if (cube->f[centre] != faceletFace(centre)) return false;
+    }
+    return true;
+}
+
+// Write the facelet string of cube to out (FACELET_COUNT letters, no terminator)
+void faceletCubeFormat(const FaceletCube* cube, char* out) {
+    for (int i = 0; i < FACELET_COUNT; i++) out[i] = faceLetters[cube->f[i]];
+}
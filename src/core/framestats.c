@@ -0,0 +1,39 @@
+#include <string.h>
+#include <stdlib.h>
+#include "framestats.h"
+
+void rollingSamplesInit(RollingSamples* window) {
+    window->count = 0;
+    window->next = 0;
+}
+
+// Add a sample, dropping the oldest once the window is full
+void rollingSamplesAdd(RollingSamples* window, float sample) {
+    window->samples[window->next] = sample;
+    window->next = (window->next + 1) % FRAME_STATS_WINDOW;
+    if (window->count < FRAME_STATS_WINDOW) window->count++;
+}
+
+static int compareFloats(const void* a, const void* b) {
+    float x = *(const float*)a, y = *(const float*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * Nearest-rank percentiles of the window: out[i] for ranks[i] in 0..100.
+ * False, with out untouched, if the window is empty.
+ */
+bool rollingSamplesPercentiles(const RollingSamples* window, const float* ranks, int count, float* out) {
+    if (window->count == 0) return false;
+
+    float sorted[FRAME_STATS_WINDOW];
+    memcpy(sorted, window->samples, sizeof(float) * (size_t)window->count);
+    qsort(sorted, (size_t)window->count, sizeof(float), compareFloats);
+    for (int i = 0; i < count; i++) {
+        float exact = ranks[i] / 100.0f * (float)window->count;
+        int rank = (int)exact + ((float)(int)exact < exact);
+        rank = rank < 1 ? 1 : rank > window->count ? window->count : rank;
+        out[i] = sorted[rank - 1];
+    }
+    return true;
+}
@@ -0,0 +1,257 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "movelog.h"
+
+#define LONG_LAYER 15                   // Layer nibble saying the layer follows in its own byte
+#define MAX_VARINT 10
+#define FLUSH_INTERVAL 1                // Seconds
+
+static const char logMagic[8] = {'R', 'U', 'B', 'I', 'K', 'L', 'O', 'G'};
+
+// Write one record to out (MOVE_LOG_MAX_RECORD bytes); returns its length
+int moveLogEncode(LayerMove move, uint64_t delta, uint8_t* out) {
+    int length = 0;
+    uint8_t head = (uint8_t)((move.turns & 3) | (move.axis & 3) << 2);
+    if (move.layer < LONG_LAYER) {
+        out[length++] = (uint8_t)(head | move.layer << 4);
+    } else {
+        out[length++] = (uint8_t)(head | LONG_LAYER << 4);
+        out[length++] = move.layer;
+    }
+
+    do {
+        uint8_t byte = delta & 0x7f;
+        delta >>= 7;
+        out[length++] = (uint8_t)(byte | (delta ? 0x80 : 0));
+    } while (delta);
+    return length;
+}
+
+// Read one record; returns its length, or 0 if it is cut short or malformed
+int moveLogDecode(const uint8_t* data, size_t size, LayerMove* move, uint64_t* delta) {
+    size_t length = 0;
+    if (size == 0) return 0;
+    uint8_t head = data[length++];
+    move->turns = head & 3;
+    move->axis = (head >> 2) & 3;
+    move->layer = head >> 4;
+    if (move->turns == 0 || move->axis > 2) return 0;
+    if (move->layer == LONG_LAYER) {
+        if (length >= size) return 0;
+        move->layer = data[length++];
+    }
+
+    *delta = 0;
+    for (int shift = 0; shift < 7 * MAX_VARINT; shift += 7) {
+        if (length >= size) return 0;
+        uint8_t byte = data[length++];
+        *delta |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return (int)length;
+    }
+    return 0;
+}
+
+/**
+ * Background writer: sleeps until MOVE_LOG_FLUSH_SIZE bytes are waiting, a
+ * second has passed with anything waiting, or the log is closing, then
+ * takes the whole pending buffer (handing back its own, emptied) and writes
+ * it with the lock released.
+ */
+static void* writerThread(void* arg) {
+    MoveLogWriter* writer = arg;
+    uint8_t* buffer = NULL;
+    size_t capacity = 0;
+
+    pthread_mutex_lock(&writer->lock);
+    for (;;) {
+        while (!writer->closing && writer->pendingSize < MOVE_LOG_FLUSH_SIZE) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_sec += FLUSH_INTERVAL;
+            if (pthread_cond_timedwait(&writer->wake, &writer->lock, &deadline) == ETIMEDOUT) break;
+        }
+        if (writer->pendingSize == 0) {
+            if (writer->closing) break;
+            continue;
+        }
+
+        uint8_t* full = writer->pending;
+        size_t size = writer->pendingSize;
+        size_t fullCapacity = writer->pendingCapacity;
+        writer->pending = buffer;
+        writer->pendingCapacity = capacity;
+        writer->pendingSize = 0;
+        buffer = full;
+        capacity = fullCapacity;
+
+        pthread_mutex_unlock(&writer->lock);
+        bool ok = fwrite(buffer, 1, size, writer->file) == size && fflush(writer->file) == 0;
+        pthread_mutex_lock(&writer->lock);
+        if (!ok) writer->failed = true;
+    }
+    pthread_mutex_unlock(&writer->lock);
+    free(buffer);
+    return NULL;
+}
+
+/**
+ * Create the log at path for a cube of cubeSize and start its writer
+ * thread. time is the caller's clock in milliseconds; the first record's
+ * delta counts from it.
+ */
+bool moveLogWriterOpen(MoveLogWriter* writer, const char* path, int cubeSize, uint64_t time) {
+    memset(writer, 0, sizeof(*writer));
+    writer->file = fopen(path, "wb");
+    if (!writer->file) {
+        fprintf(stderr, "Could not create move log %s\n", path);
+        return false;
+    }
+
+    MoveLogHeader header;
+    memcpy(header.magic, logMagic, sizeof(logMagic));
+    header.version = MOVE_LOG_VERSION;
+    header.cubeSize = (uint32_t)cubeSize;
+    writer->lastTime = time;
+    if (fwrite(&header, sizeof(header), 1, writer->file) != 1 || fflush(writer->file) != 0) {
+        fprintf(stderr, "Could not write move log %s\n", path);
+        fclose(writer->file);
+        return false;
+    }
+
+    pthread_mutex_init(&writer->lock, NULL);
+    pthread_cond_init(&writer->wake, NULL);
+    if (pthread_create(&writer->thread, NULL, writerThread, writer) != 0) {
+        pthread_mutex_destroy(&writer->lock);
+        pthread_cond_destroy(&writer->wake);
+        fclose(writer->file);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Record a turn made at time (same clock as moveLogWriterOpen). Never waits
+ * on the disk. Returns false if the record could not be buffered or an
+ * earlier write failed.
+ */
+bool moveLogWriterAppend(MoveLogWriter* writer, LayerMove move, uint64_t time) {
+    pthread_mutex_lock(&writer->lock);
+    bool ok = !writer->failed;
+    if (ok && writer->pendingSize + MOVE_LOG_MAX_RECORD > writer->pendingCapacity) {
+        size_t capacity = writer->pendingCapacity ? writer->pendingCapacity * 2 : MOVE_LOG_FLUSH_SIZE * 2;
+        uint8_t* grown = realloc(writer->pending, capacity);
+        if (grown) {
+            writer->pending = grown;
+            writer->pendingCapacity = capacity;
+        } else {
+            ok = false;
+        }
+    }
+    if (ok) {
+        uint64_t delta = time > writer->lastTime ? time - writer->lastTime : 0;
+        writer->lastTime = time > writer->lastTime ? time : writer->lastTime;
+        writer->pendingSize += (size_t)moveLogEncode(move, delta, writer->pending + writer->pendingSize);
+        if (writer->pendingSize >= MOVE_LOG_FLUSH_SIZE) pthread_cond_signal(&writer->wake);
+    }
+    pthread_mutex_unlock(&writer->lock);
+    return ok;
+}
+
+// Write out everything still buffered and close the file; false if anything was lost
+bool moveLogWriterClose(MoveLogWriter* writer) {
+    pthread_mutex_lock(&writer->lock);
+    writer->closing = true;
+    pthread_cond_signal(&writer->wake);
+    pthread_mutex_unlock(&writer->lock);
+    pthread_join(writer->thread, NULL);
+
+    bool ok = !writer->failed;
+    ok = fclose(writer->file) == 0 && ok;
+    pthread_mutex_destroy(&writer->lock);
+    pthread_cond_destroy(&writer->wake);
+    free(writer->pending);
+    writer->pending = NULL;
+    writer->file = NULL;
+    return ok;
+}
+
+// Map a log read-only; false (with a message) if it is missing or not a move log
+bool moveLogOpen(MoveLog* log, const char* path) {
+    memset(log, 0, sizeof(*log));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Could not open move log %s\n", path);
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < MOVE_LOG_HEADER_SIZE) {
+        fprintf(stderr, "Move log %s is too short\n", path);
+        close(fd);
+        return false;
+    }
+
+    void* mapping = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) return false;
+
+    // The log is read front to back, once
+    madvise(mapping, (size_t)info.st_size, MADV_SEQUENTIAL);
+
+    MoveLogHeader header;
+    memcpy(&header, mapping, sizeof(header));
+    if (memcmp(header.magic, logMagic, sizeof(logMagic)) != 0 || header.version != MOVE_LOG_VERSION ||
+        header.cubeSize < BIGCUBE_MIN_SIZE || header.cubeSize > BIGCUBE_MAX_SIZE) {
+        fprintf(stderr, "%s is not a move log this version can read\n", path);
+        munmap(mapping, (size_t)info.st_size);
+        return false;
+    }
+
+    log->mapping = mapping;
+    log->mappingSize = (size_t)info.st_size;
+    log->cubeSize = (int)header.cubeSize;
+    log->records = (const uint8_t*)mapping + MOVE_LOG_HEADER_SIZE;
+    log->size = log->mappingSize - MOVE_LOG_HEADER_SIZE;
+    return true;
+}
+
+void moveLogClose(MoveLog* log) {
+    if (log->mapping) munmap(log->mapping, log->mappingSize);
+    memset(log, 0, sizeof(*log));
+}
+
+// Read the record at the cursor and step past it; false at the end of the log
+bool moveLogNext(const MoveLog* log, MoveLogCursor* cursor, LayerMove* move) {
+    uint64_t delta;
+    int length = moveLogDecode(log->records + cursor->offset, log->size - cursor->offset, move, &delta);
+    if (length == 0 || move->layer >= log->cubeSize) return false;
+
+    cursor->offset += (size_t)length;
+    cursor->time += delta;
+    return true;
+}
+
+/**
+ * Apply every turn in the log to cube, as fast as they decode, and return
+ * how many there were. The cube must be the log's size (nothing is applied
+ * otherwise).
+ */
+size_t moveLogReplay(const MoveLog* log, BigCube* cube) {
+    if (cube->size != log->cubeSize) return 0;
+
+    MoveLogCursor cursor = {0, 0};
+    LayerMove move;
+    size_t count = 0;
+    while (moveLogNext(log, &cursor, &move)) {
+        bigCubeApplyMove(cube, move);
+        count++;
+    }
+    return count;
+}
@@ -0,0 +1,77 @@
+#include "movequeue.h"
+
+// axis in bits 10-11, layer in bits 2-9, turns in bits 0-1
+static uint16_t packLayerMove(LayerMove move) {
+    return (uint16_t)((move.axis << 10) | (move.layer << 2) | (move.turns & 3));
+}
+
+static LayerMove unpackLayerMove(uint16_t packed) {
+    LayerMove move = {(uint8_t)(packed >> 10), (uint8_t)((packed >> 2) & 0xff), (uint8_t)(packed & 3)};
+    return move;
+}
+
+void moveQueueInit(MoveQueue* queue) {
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+}
+
+// Producer side; false when the ring is full
+bool moveQueuePush(MoveQueue* queue, LayerMove move) {
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&queue->head, memory_order_acquire);
+    if (tail - head >= MOVE_QUEUE_CAPACITY) return false;
+
+    queue->moves[tail & (MOVE_QUEUE_CAPACITY - 1)] = packLayerMove(move);
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+// Consumer side; false when the ring is empty
+bool moveQueuePop(MoveQueue* queue, LayerMove* move) {
+    size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+    if (head == tail) return false;
+
+    *move = unpackLayerMove(queue->moves[head & (MOVE_QUEUE_CAPACITY - 1)]);
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+    return true;
+}
+
+/**
+ * Pop the next move folded together with any turns of the same slice queued
+ * right behind it: R R becomes R2, R R' vanishes and the next move is tried.
+ * Only moves already in the ring are merged, so a lone move is never held
+ * back.
+ */
+bool moveQueuePopCoalesced(MoveQueue* queue, LayerMove* move) {
+    size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+
+    while (head != tail) {
+        LayerMove first = unpackLayerMove(queue->moves[head & (MOVE_QUEUE_CAPACITY - 1)]);
+        int turns = first.turns;
+        head++;
+
+        while (head != tail) {
+            LayerMove next = unpackLayerMove(queue->moves[head & (MOVE_QUEUE_CAPACITY - 1)]);
+            if (next.axis != first.axis || next.layer != first.layer) break;
+            turns += next.turns;
+            head++;
+        }
+
+        atomic_store_explicit(&queue->head, head, memory_order_release);
+        if (turns % 4 != 0) {
+            *move = first;
+            move->turns = (uint8_t)(turns % 4);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+size_t moveQueueSize(MoveQueue* queue) {
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+    size_t head = atomic_load_explicit(&queue->head, memory_order_acquire);
+    return tail - head;
+}
@@ -0,0 +1,214 @@
+#include "cubestate.h"
+#include "facelets.h"
+
+/**
+ * The 18 face turns, precomputed. moveTable[m] is the cubie state reached by
+ * applying m to the solved cube, so applying m to any state is one
+ * cubeStateMultiply-style gather. faceletMoveTable is the same turn expressed
+ * on the 54 stickers. Both were generated from the standard cubie
+ * definitions of the six clockwise quarter turns.
+ */
+
+const CubeState moveTable[MOVE_COUNT] = {
+    { // F
+        {1, 5, 2, 3, 0, 4, 6, 7},
+        {1, 2, 0, 0, 2, 1, 0, 0},
+        {0, 9, 2, 3, 4, 8, 6, 7, 1, 5, 10, 11},
+        {0, 1, 0, 0, 0, 1, 0, 0, 1, 1, 0, 0}
+    },
+    { // F2
+        {5, 4, 2, 3, 1, 0, 6, 7},
+        {0, 0, 0, 0, 0, 0, 0, 0},
+        {0, 5, 2, 3, 4, 1, 6, 7, 9, 8, 10, 11},
+        {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
+    },
+    { // F'
+        {4, 0, 2, 3, 5, 1, 6, 7},
+        {1, 2, 0, 0, 2, 1, 0, 0},
+        {0, 8, 2, 3, 4, 9, 6, 7, 5, 1, 10, 11},
+        {0, 1, 0, 0, 0, 1, 0, 0, 1, 1, 0, 0}
+    },
+    { // B
+        {0, 1, 3, 7, 4, 5, 2, 6},
+        {0, 0, 1, 2, 0, 0, 2, 1},
+        {0, 1, 2, 11, 4, 5, 6, 10, 8, 9, 3, 7},
+        {0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 1, 1}
+    },
+    { // B2
+        {0, 1, 7, 6, 4, 5, 3, 2},
+        {0, 0, 0, 0, 0, 0, 0, 0},
+        {0, 1, 2, 7, 4, 5, 6, 3, 8, 9, 11, 10},
+        {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
+    },
+    { // B'
+        {0, 1, 6, 2, 4, 5, 7, 3},
+        {0, 0, 1, 2, 0, 0, 2, 1},
+        {0, 1, 2, 10, 4, 5, 6, 11, 8, 9, 7, 3},
+        {0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 1, 1}
+    },
+    { // L
+        {0, 2, 6, 3, 4, 1, 5, 7},
+        {0, 1, 2, 0, 0, 2, 1, 0},
+        {0, 1, 10, 3, 4, 5, 9, 7, 8, 2, 6, 11},
+        {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
+    },
+    { // L2
+        {0, 6, 5, 3, 4, 2, 1, 7},
+        {0, 0, 0, 0, 0, 0, 0, 0},
+        {0, 1, 6, 3, 4, 5, 2, 7, 8, 10, 9, 11},
+        {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
+    },
+    { // L'
+        {0, 5, 1, 3, 4, 6, 2, 7},
+        {0, 1, 2, 0, 0, 2, 1, 0},
+        {0, 1, 9, 3, 4, 5, 10, 7, 8, 6, 2, 11},
+        {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
+    },
+    { // R
+        {4, 1, 2, 0, 7, 5, 6, 3},
+        {2, 0, 0, 1, 1, 0, 0, 2},
+        {8, 1, 2, 3, 11, 5, 6, 7, 4, 9, 10, 0},
+        {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
+    },
+    { // R2
+        {7, 1, 2, 4, 3, 5, 6, 0},
+        {0, 0, 0, 0, 0, 0, 0, 0},
+        {4, 1, 2, 3, 0, 5, 6, 7, 11, 9, 10, 8},
+        {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
+    },
+    { // R'
+        {3, 1, 2, 7, 0, 5, 6, 4},
+        {2, 0, 0, 1, 1, 0, 0, 2},
+        {11, 1, 2, 3, 8, 5, 6, 7, 0, 9, 10, 4},
+        {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
+    },
+    { // D
+        {0, 1, 2, 3, 5, 6, 7, 4},
+        {0, 0, 0, 0, 0, 0, 0, 0},
+        {0, 1, 2, 3, 5, 6, 7, 4, 8, 9, 10, 11},
+        {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
+    },
+    { // D2
+        {0, 1, 2, 3, 6, 7, 4, 5},
+        {0, 0, 0, 0, 0, 0, 0, 0},
+        {0, 1, 2, 3, 6, 7, 4, 5, 8, 9, 10, 11},
+        {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
+    },
+    { // D'
+        {0, 1, 2, 3, 7, 4, 5, 6},
+        {0, 0, 0, 0, 0, 0, 0, 0},
+        {0, 1, 2, 3, 7, 4, 5, 6, 8, 9, 10, 11},
+        {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
+    },
+    { // U
+        {3, 0, 1, 2, 4, 5, 6, 7},
+        {0, 0, 0, 0, 0, 0, 0, 0},
+        {3, 0, 1, 2, 4, 5, 6, 7, 8, 9, 10, 11},
+        {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
+    },
+    { // U2
+        {2, 3, 0, 1, 4, 5, 6, 7},
+        {0, 0, 0, 0, 0, 0, 0, 0},
+        {2, 3, 0, 1, 4, 5, 6, 7, 8, 9, 10, 11},
+        {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
+    },
+    { // U'
+        {1, 2, 3, 0, 4, 5, 6, 7},
+        {0, 0, 0, 0, 0, 0, 0, 0},
+        {1, 2, 3, 0, 4, 5, 6, 7, 8, 9, 10, 11},
+        {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
+    },
+};
+
+const uint8_t faceletMoveTable[MOVE_COUNT][FACELET_COUNT] = {
+    { // F
+        0, 1, 2, 3, 4, 5, 44, 41, 38, 6, 10, 11, 7, 13, 14, 8, 16, 17,
+        24, 21, 18, 25, 22, 19, 26, 23, 20, 15, 12, 9, 30, 31, 32, 33, 34, 35,
+        36, 37, 27, 39, 40, 28, 42, 43, 29, 45, 46, 47, 48, 49, 50, 51, 52, 53,
+    },
+    { // F2
+        0, 1, 2, 3, 4, 5, 29, 28, 27, 44, 10, 11, 41, 13, 14, 38, 16, 17,
+        26, 25, 24, 23, 22, 21, 20, 19, 18, 8, 7, 6, 30, 31, 32, 33, 34, 35,
+        36, 37, 15, 39, 40, 12, 42, 43, 9, 45, 46, 47, 48, 49, 50, 51, 52, 53,
+    },
+    { // F'
+        0, 1, 2, 3, 4, 5, 9, 12, 15, 29, 10, 11, 28, 13, 14, 27, 16, 17,
+        20, 23, 26, 19, 22, 25, 18, 21, 24, 38, 41, 44, 30, 31, 32, 33, 34, 35,
+        36, 37, 8, 39, 40, 7, 42, 43, 6, 45, 46, 47, 48, 49, 50, 51, 52, 53,
+    },
+    { // B
+        11, 14, 17, 3, 4, 5, 6, 7, 8, 9, 10, 35, 12, 13, 34, 15, 16, 33,
+        18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 36, 39, 42,
+        2, 37, 38, 1, 40, 41, 0, 43, 44, 51, 48, 45, 52, 49, 46, 53, 50, 47,
+    },
+    { // B2
+        35, 34, 33, 3, 4, 5, 6, 7, 8, 9, 10, 42, 12, 13, 39, 15, 16, 36,
+        18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 2, 1, 0,
+        17, 37, 38, 14, 40, 41, 11, 43, 44, 53, 52, 51, 50, 49, 48, 47, 46, 45,
+    },
+    { // B'
+        42, 39, 36, 3, 4, 5, 6, 7, 8, 9, 10, 0, 12, 13, 1, 15, 16, 2,
+        18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 17, 14, 11,
+        33, 37, 38, 34, 40, 41, 35, 43, 44, 47, 50, 53, 46, 49, 52, 45, 48, 51,
+    },
+    { // L
+        53, 1, 2, 50, 4, 5, 47, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17,
+        0, 19, 20, 3, 22, 23, 6, 25, 26, 18, 28, 29, 21, 31, 32, 24, 34, 35,
+        42, 39, 36, 43, 40, 37, 44, 41, 38, 45, 46, 33, 48, 49, 30, 51, 52, 27,
+    },
+    { // L2
+        27, 1, 2, 30, 4, 5, 33, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17,
+        53, 19, 20, 50, 22, 23, 47, 25, 26, 0, 28, 29, 3, 31, 32, 6, 34, 35,
+        44, 43, 42, 41, 40, 39, 38, 37, 36, 45, 46, 24, 48, 49, 21, 51, 52, 18,
+    },
+    { // L'
+        18, 1, 2, 21, 4, 5, 24, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17,
+        27, 19, 20, 30, 22, 23, 33, 25, 26, 53, 28, 29, 50, 31, 32, 47, 34, 35,
+        38, 41, 44, 37, 40, 43, 36, 39, 42, 45, 46, 6, 48, 49, 3, 51, 52, 0,
+    },
+    { // R
+        0, 1, 20, 3, 4, 23, 6, 7, 26, 15, 12, 9, 16, 13, 10, 17, 14, 11,
+        18, 19, 29, 21, 22, 32, 24, 25, 35, 27, 28, 51, 30, 31, 48, 33, 34, 45,
+        36, 37, 38, 39, 40, 41, 42, 43, 44, 8, 46, 47, 5, 49, 50, 2, 52, 53,
+    },
+    { // R2
+        0, 1, 29, 3, 4, 32, 6, 7, 35, 17, 16, 15, 14, 13, 12, 11, 10, 9,
+        18, 19, 51, 21, 22, 48, 24, 25, 45, 27, 28, 2, 30, 31, 5, 33, 34, 8,
+        36, 37, 38, 39, 40, 41, 42, 43, 44, 26, 46, 47, 23, 49, 50, 20, 52, 53,
+    },
+    { // R'
+        0, 1, 51, 3, 4, 48, 6, 7, 45, 11, 14, 17, 10, 13, 16, 9, 12, 15,
+        18, 19, 2, 21, 22, 5, 24, 25, 8, 27, 28, 20, 30, 31, 23, 33, 34, 26,
+        36, 37, 38, 39, 40, 41, 42, 43, 44, 35, 46, 47, 32, 49, 50, 29, 52, 53,
+    },
+    { // D
+        0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 24, 25, 26,
+        18, 19, 20, 21, 22, 23, 42, 43, 44, 33, 30, 27, 34, 31, 28, 35, 32, 29,
+        36, 37, 38, 39, 40, 41, 51, 52, 53, 45, 46, 47, 48, 49, 50, 15, 16, 17,
+    },
+    { // D2
+        0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 42, 43, 44,
+        18, 19, 20, 21, 22, 23, 51, 52, 53, 35, 34, 33, 32, 31, 30, 29, 28, 27,
+        36, 37, 38, 39, 40, 41, 15, 16, 17, 45, 46, 47, 48, 49, 50, 24, 25, 26,
+    },
+    { // D'
+        0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 51, 52, 53,
+        18, 19, 20, 21, 22, 23, 15, 16, 17, 29, 32, 35, 28, 31, 34, 27, 30, 33,
+        36, 37, 38, 39, 40, 41, 24, 25, 26, 45, 46, 47, 48, 49, 50, 42, 43, 44,
+    },
+    { // U
+        6, 3, 0, 7, 4, 1, 8, 5, 2, 45, 46, 47, 12, 13, 14, 15, 16, 17,
+        9, 10, 11, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35,
+        18, 19, 20, 39, 40, 41, 42, 43, 44, 36, 37, 38, 48, 49, 50, 51, 52, 53,
+    },
+    { // U2
+        8, 7, 6, 5, 4, 3, 2, 1, 0, 36, 37, 38, 12, 13, 14, 15, 16, 17,
+        45, 46, 47, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35,
+        9, 10, 11, 39, 40, 41, 42, 43, 44, 18, 19, 20, 48, 49, 50, 51, 52, 53,
+    },
+    { // U'
+        2, 5, 8, 1, 4, 7, 0, 3, 6, 18, 19, 20, 12, 13, 14, 15, 16, 17,
+        36, 37, 38, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35,
+        45, 46, 47, 39, 40, 41, 42, 43, 44, 9, 10, 11, 48, 49, 50, 51, 52, 53,
+    },
+};
@@ -0,0 +1,396 @@
+#include <stdlib.h>
+#include <string.h>
+#include "optimal.h"
+#include "prunetable.h"
+#include "solver.h"
+#include "statecodec.h"
+#include "clock.h"
+
+// Nodes with at least this many moves to go are worth handing to an idle worker
+#define SPLIT_MIN_TOGO 6
+
+// Position of each edge within the tabulated half, or EDGE_COUNT if it is in the other
+static const uint8_t edgeMember[EDGE_COUNT] = {
+    0, 1, 2, 3, EDGE_COUNT, EDGE_COUNT, EDGE_COUNT, EDGE_COUNT, 4, 5, EDGE_COUNT, EDGE_COUNT,
+};
+
+// Where a move takes the edge in each slot, and whether it flips it
+typedef struct {
+    uint8_t slot[MOVE_COUNT][EDGE_COUNT];
+    uint8_t flip[MOVE_COUNT][EDGE_COUNT];
+} EdgeMoves;
+
+typedef struct {
+    const PatternDatabase* pdb;
+    WorkPool* pool;
+    Metric metric;
+    const Move* moves;
+    int moveCount;
+    int bound;                                // Longest solution the current iteration looks for
+    _Atomic bool found;
+    _Atomic uint64_t nodes;
+    int length;
+    uint8_t solution[OPTIMAL_MAX_LENGTH];
+} Search;
+
+typedef struct {
+    Search* search;
+    CubeState state;
+    int depth;
+    uint8_t path[OPTIMAL_MAX_LENGTH];
+} SearchTask;
+
+static const Move quarterTurns[12] = {
+    MOVE_F, MOVE_F_PRIME, MOVE_B, MOVE_B_PRIME, MOVE_L, MOVE_L_PRIME,
+    MOVE_R, MOVE_R_PRIME, MOVE_D, MOVE_D_PRIME, MOVE_U, MOVE_U_PRIME,
+};
+
+static const Move faceTurns[MOVE_COUNT] = {
+    MOVE_F, MOVE_F2, MOVE_F_PRIME, MOVE_B, MOVE_B2, MOVE_B_PRIME,
+    MOVE_L, MOVE_L2, MOVE_L_PRIME, MOVE_R, MOVE_R2, MOVE_R_PRIME,
+    MOVE_D, MOVE_D2, MOVE_D_PRIME, MOVE_U, MOVE_U2, MOVE_U_PRIME,
+};
+
+static uint32_t conjugateCornerPerm(uint32_t raw, int sym, const void* context) {
+    (void)context;
+    CubeState state;
+    cubeStateInit(&state);
+    permutationUnrank(raw, CORNER_COUNT, 0, state.cp);
+    cubeStateConjugateCorners(&state, sym, &state);
+    return permutationRank(state.cp, CORNER_COUNT);
+}
+
+/**
+ * Class of the corner permutation, then the twist seen through the symmetry
+ * that reduced it. When the representative has symmetries of its own, each
+ * gives an equally valid twist; the smallest is taken so that conjugate
+ * states always share one entry.
+ */
+static size_t cornerIndex(const SymmetryClasses* classes, const CubeState* state) {
+    uint32_t perm = permutationRank(state->cp, CORNER_COUNT);
+    uint32_t class = classes->classOf[perm];
+    CubeState reduced;
+    cubeStateConjugateCorners(state, classes->symmetry[perm], &reduced);
+    int twist = twistRank(&reduced);
+
+    for (uint64_t others = classes->stabilizer[class] & ~1ull; others; others &= others - 1) {
+        CubeState image;
+        cubeStateConjugateCorners(&reduced, __builtin_ctzll(others), &image);
+        int imageTwist = twistRank(&image);
+        if (imageTwist < twist) twist = imageTwist;
+    }
+    return (size_t)class * TWIST_COUNT + twist;
+}
+
+// Rank of the slots holding six distinct edges, in 12 * 11 * ... * 7 positions
+static size_t edgeSlotRank(const int* slot) {
+    size_t rank = 0;
+    unsigned used = 0;
+    for (int k = 0; k < EDGE_PDB_EDGES; k++) {
+        rank = rank * (EDGE_COUNT - k) + slot[k] - __builtin_popcount(used & ((1u << slot[k]) - 1));
+        used |= 1u << slot[k];
+    }
+    return rank;
+}
+
+static void edgeSlotUnrank(size_t rank, int* slot) {
+    int digits[EDGE_PDB_EDGES];
+    unsigned used = 0;
+    for (int k = EDGE_PDB_EDGES - 1; k >= 0; k--) {
+        digits[k] = (int)(rank % (EDGE_COUNT - k));
+        rank /= EDGE_COUNT - k;
+    }
+    for (int k = 0; k < EDGE_PDB_EDGES; k++) {
+        int s = -1;
+        for (int d = digits[k]; d >= 0; d--) {
+            do s++; while (used & (1u << s));
+        }
+        used |= 1u << s;
+        slot[k] = s;
+    }
+}
+
+/**
+ * Slots and flips of the tabulated edges in the state conjugated by view
+ * (flip bit k belongs to member k), without conjugating the rest: through
+ * the x2 view these are the other half of the edges.
+ */
+static size_t edgeIndex(const CubeState* state, const Symmetry* view) {
+    int slot[EDGE_PDB_EDGES];
+    unsigned flip = 0;
+    for (int i = 0; i < EDGE_COUNT; i++) {
+        int edge = state->ep[i];
+        unsigned k = edgeMember[view->edgeSlot[edge]];
+        if (k < EDGE_PDB_EDGES) {
+            slot[k] = view->edgeSlot[i];
+            flip |= (unsigned)(state->eo[i] ^ view->edgeFlip[i] ^ view->edgeFlip[edge]) << k;
+        }
+    }
+    return edgeSlotRank(slot) << EDGE_PDB_EDGES | flip;
+}
+
+// From the class representative: conjugates are as far from solved, and so are their neighbours
+static int expandCorners(const void* context, size_t index, size_t* next) {
+    const SymmetryClasses* classes = context;
+    CubeState state, moved;
+    cubeStateInit(&state);
+    permutationUnrank(classes->representative[index / TWIST_COUNT], CORNER_COUNT, 0, state.cp);
+    twistUnrank(&state, (int)(index % TWIST_COUNT));
+    for (int m = 0; m < MOVE_COUNT; m++) {
+        cubeStateMultiply(&state, &moveTable[m], &moved);
+        next[m] = cornerIndex(classes, &moved);
+    }
+    return MOVE_COUNT;
+}
+
+// Slots and flips only: the same expansion serves either half of the edges
+static int expandEdges(const void* context, size_t index, size_t* next) {
+    const EdgeMoves* edges = context;
+    int slot[EDGE_PDB_EDGES], moved[EDGE_PDB_EDGES];
+    unsigned flip = (unsigned)(index & ((1u << EDGE_PDB_EDGES) - 1));
+    edgeSlotUnrank(index >> EDGE_PDB_EDGES, slot);
+
+    for (int m = 0; m < MOVE_COUNT; m++) {
+        unsigned movedFlip = flip;
+        for (int k = 0; k < EDGE_PDB_EDGES; k++) {
+            moved[k] = edges->slot[m][slot[k]];
+            movedFlip ^= (unsigned)edges->flip[m][slot[k]] << k;
+        }
+        next[m] = edgeSlotRank(moved) << EDGE_PDB_EDGES | movedFlip;
+    }
+    return MOVE_COUNT;
+}
+
+static bool buildEdgePdb(uint8_t* table, int threads) {
+    EdgeMoves edges;
+    for (int m = 0; m < MOVE_COUNT; m++) {
+        for (int i = 0; i < EDGE_COUNT; i++) {
+            edges.slot[m][moveTable[m].ep[i]] = (uint8_t)i;
+            edges.flip[m][moveTable[m].ep[i]] = moveTable[m].eo[i];
+        }
+    }
+
+    CubeState solved;
+    cubeStateInit(&solved);
+    return pruneTableBuild(table, EDGE_PDB_SIZE, edgeIndex(&solved, symmetryGet(SYMMETRY_IDENTITY)),
+                           expandEdges, &edges, threads);
+}
+
+static void pdbSections(const PatternDatabase* pdb, TableSection sections[OPTIMAL_TABLE_COUNT]) {
+    sections[0] = (TableSection){pdb->cornerPdb, CORNER_PDB_SIZE};
+    sections[1] = (TableSection){pdb->edgePdb, EDGE_PDB_SIZE};
+}
+
+uint64_t patternDatabaseFingerprint(void) {
+    const uint32_t sizes[] = {
+        CORNER_CLASS_COUNT, CORNER_PDB_SIZE, EDGE_PDB_SIZE, EDGE_PDB_EDGES, EDGE_PDB_SYMMETRY,
+        MOVE_COUNT, OPTIMAL_TABLE_COUNT,
+    };
+    uint64_t hash = tableChecksum(0, sizes, sizeof(sizes));
+    hash = tableChecksum(hash, edgeMember, sizeof(edgeMember));
+    return tableChecksum(hash, moveTable, sizeof(CubeState) * MOVE_COUNT);
+}
+
+// What lookups need besides the tables themselves; cheap enough to build every time
+static bool initLookup(PatternDatabase* pdb) {
+    memset(pdb, 0, sizeof(*pdb));
+    pdb->edgeViews[0] = symmetryGet(SYMMETRY_IDENTITY);
+    pdb->edgeViews[1] = symmetryGet(EDGE_PDB_SYMMETRY);
+    if (!symmetryClassesBuild(&pdb->cornerClasses, CORNER_PERM_COUNT, conjugateCornerPerm, NULL)) return false;
+    if (pdb->cornerClasses.count != CORNER_CLASS_COUNT) {
+        symmetryClassesFree(&pdb->cornerClasses);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Build both databases in memory, each by breadth-first search from solved
+ * over threads workers (<= 0: one per CPU).
+ */
+bool patternDatabaseInit(PatternDatabase* pdb, int threads) {
+    if (!initLookup(pdb)) return false;
+    pdb->cornerPdb = malloc(CORNER_PDB_SIZE);
+    pdb->edgePdb = malloc(EDGE_PDB_SIZE);
+
+    bool ok = pdb->cornerPdb && pdb->edgePdb
+           && pruneTableBuild(pdb->cornerPdb, CORNER_PDB_SIZE, 0, expandCorners, &pdb->cornerClasses, threads)
+           && buildEdgePdb(pdb->edgePdb, threads);
+    if (!ok) patternDatabaseFree(pdb);
+    return ok;
+}
+
+// Map the databases from a table file, or build and save them (see solverInitCached)
+bool patternDatabaseInitCached(PatternDatabase* pdb, const char* path, int threads) {
+    TableSection sections[OPTIMAL_TABLE_COUNT];
+    PatternDatabase empty;
+    memset(&empty, 0, sizeof(empty));
+    pdbSections(&empty, sections);
+    size_t payloadSize = tableSectionOffset(sections, OPTIMAL_TABLE_COUNT);
+
+    TableStoreMap store;
+    if (tableStoreOpen(path, OPTIMAL_TABLE_NAME, patternDatabaseFingerprint(), payloadSize, TABLE_STORE_VERIFY, &store)) {
+        if (!initLookup(pdb)) {
+            tableStoreClose(&store);
+            return false;
+        }
+        pdb->cornerPdb = (uint8_t*)store.data + tableSectionOffset(sections, 0);
+        pdb->edgePdb = (uint8_t*)store.data + tableSectionOffset(sections, 1);
+        pdb->store = store;
+        return true;
+    }
+
+    if (!patternDatabaseInit(pdb, threads)) return false;
+    pdbSections(pdb, sections);
+    tableStoreWrite(path, OPTIMAL_TABLE_NAME, patternDatabaseFingerprint(), sections, OPTIMAL_TABLE_COUNT);
+    return true;
+}
+
+void patternDatabaseFree(PatternDatabase* pdb) {
+    if (pdb->store.mapping) {
+        tableStoreClose(&pdb->store);
+    } else {
+        free(pdb->cornerPdb);
+        free(pdb->edgePdb);
+    }
+    symmetryClassesFree(&pdb->cornerClasses);
+    memset(pdb, 0, sizeof(*pdb));
+}
+
+/**
+ * Lower bound on the distance to solved, giving up as soon as one database
+ * already says more than togo: most nodes are cut by the corners alone.
+ */
+static int estimateWithin(const PatternDatabase* pdb, const CubeState* state, int togo) {
+    int h = pdb->cornerPdb[cornerIndex(&pdb->cornerClasses, state)];
+    if (h > togo) return h;
+    int e = pdb->edgePdb[edgeIndex(state, pdb->edgeViews[0])];
+    if (e > h) h = e;
+    if (h > togo) return h;
+    e = pdb->edgePdb[edgeIndex(state, pdb->edgeViews[1])];
+    return e > h ? e : h;
+}
+
+int patternDatabaseEstimate(const PatternDatabase* pdb, const CubeState* state) {
+    return estimateWithin(pdb, state, PRUNE_UNVISITED);
+}
+
+/**
+ * Face turn metric: moveIsRedundant. Quarter turn metric: the same, except
+ * that a face may turn twice running, standing for a half turn; only the
+ * clockwise pair is kept and never a third turn.
+ */
+static bool allowedAfter(Metric metric, const uint8_t* path, int depth, Move move) {
+    if (depth == 0) return true;
+    Move last = (Move)path[depth - 1];
+    if (metric == METRIC_QTM && move == last && moveQuarterTurns(move) == 1) {
+        return depth < 2 || moveFace((Move)path[depth - 2]) != moveFace(move);
+    }
+    return !moveIsRedundant(last, move);
+}
+
+static void recordSolution(Search* search, const uint8_t* path, int length) {
+    bool expected = false;
+    if (atomic_compare_exchange_strong(&search->found, &expected, true)) {
+        memcpy(search->solution, path, (size_t)length);
+        search->length = length;
+    }
+}
+
+static void runTask(void* arg, int worker);
+
+// Search below one node on this worker, or hand its children out if a worker is idle
+static void searchNode(Search* search, const CubeState* state, int depth, uint8_t* path, uint64_t* nodes) {
+    if (atomic_load_explicit(&search->found, memory_order_relaxed)) return;
+
+    int togo = search->bound - depth;
+    int h = estimateWithin(search->pdb, state, togo);
+    (*nodes)++;
+    if (h > togo) return;
+    if (h == 0) {
+        recordSolution(search, path, depth);
+        return;
+    }
+
+    bool split = togo >= SPLIT_MIN_TOGO && workPoolHungry(search->pool);
+    for (int m = 0; m < search->moveCount; m++) {
+        Move move = search->moves[m];
+        if (!allowedAfter(search->metric, path, depth, move)) continue;
+
+        path[depth] = (uint8_t)move;
+        SearchTask* task = split ? malloc(sizeof(SearchTask)) : NULL;
+        if (task) {
+            task->search = search;
+            task->depth = depth + 1;
+            cubeStateMultiply(state, &moveTable[move], &task->state);
+            memcpy(task->path, path, (size_t)depth + 1);
+            if (workPoolSubmit(search->pool, runTask, task)) continue;
+            free(task);
+        }
+
+        CubeState next;
+        cubeStateMultiply(state, &moveTable[move], &next);
+        searchNode(search, &next, depth + 1, path, nodes);
+    }
+}
+
+static void runTask(void* arg, int worker) {
+    (void)worker;
+    SearchTask* task = arg;
+    uint64_t nodes = 0;
+    searchNode(task->search, &task->state, task->depth, task->path, &nodes);
+    atomic_fetch_add_explicit(&task->search->nodes, nodes, memory_order_relaxed);
+    free(task);
+}
+
+/**
+ * Write a shortest solution of at most maxLength moves in the given metric
+ * to moves[] and return its length, or -1 if there is none that short. Each
+ * deepening iteration runs on pool, which must not be running anything else
+ * meanwhile. stats, if not NULL, receives the length, node count and time.
+ *
+ * In the quarter turn metric every move is an odd corner permutation, so a
+ * solution's length has the parity of the corner permutation and the bound
+ * goes up two at a time.
+ */
+int optimalSolve(const PatternDatabase* pdb, const CubeState* state, Metric metric, int maxLength,
+                 WorkPool* pool, uint8_t* moves, OptimalStats* stats) {
+    double start = clockSeconds();
+    Search search;
+    memset(&search, 0, sizeof(search));
+    search.pdb = pdb;
+    search.pool = pool;
+    search.metric = metric;
+    search.moves = metric == METRIC_QTM ? quarterTurns : faceTurns;
+    search.moveCount = metric == METRIC_QTM ? 12 : MOVE_COUNT;
+    search.length = -1;
+    atomic_init(&search.found, false);
+    atomic_init(&search.nodes, 0);
+
+    if (maxLength > OPTIMAL_MAX_LENGTH) maxLength = OPTIMAL_MAX_LENGTH;
+    int bound = patternDatabaseEstimate(pdb, state);
+    int step = 1;
+    if (metric == METRIC_QTM) {
+        step = 2;
+        if ((bound & 1) != permutationParity(state->cp, CORNER_COUNT)) bound++;
+    }
+
+    for (; bound <= maxLength && !atomic_load(&search.found); bound += step) {
+        search.bound = bound;
+        SearchTask* root = malloc(sizeof(SearchTask));
+        if (!root) break;
+        root->search = &search;
+        root->state = *state;
+        root->depth = 0;
+        if (!workPoolSubmit(pool, runTask, root)) runTask(root, -1);
+        workPoolWait(pool);
+    }
+
+    if (search.length > 0) memcpy(moves, search.solution, (size_t)search.length);
+    if (stats) {
+        stats->length = search.length;
+        stats->nodes = atomic_load(&search.nodes);
+        stats->seconds = clockSeconds() - start;
+    }
+    return search.length;
+}
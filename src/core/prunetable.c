@@ -0,0 +1,84 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+#include "prunetable.h"
+#include "workpool.h"
+
+#define MAX_THREADS 256
+
+typedef struct {
+    _Atomic uint8_t* table;
+    size_t begin, end;
+    uint8_t depth;
+    PruneExpand expand;
+    const void* context;
+    size_t found;           // Positions this worker claimed for depth + 1
+} PruneWorker;
+
+static void* expandLayer(void* arg) {
+    PruneWorker* worker = arg;
+    size_t next[PRUNE_MAX_NEIGHBORS];
+    uint8_t nextDepth = (uint8_t)(worker->depth + 1);
+
+    worker->found = 0;
+    for (size_t i = worker->begin; i < worker->end; i++) {
+        if (atomic_load_explicit(&worker->table[i], memory_order_relaxed) != worker->depth) continue;
+
+        int count = worker->expand(worker->context, i, next);
+        for (int k = 0; k < count; k++) {
+            // Most neighbours are already claimed in later layers; a plain
+            // load spares those the exclusive cache line a CAS needs
+            if (atomic_load_explicit(&worker->table[next[k]], memory_order_relaxed) != PRUNE_UNVISITED) continue;
+            uint8_t expected = PRUNE_UNVISITED;
+            if (atomic_compare_exchange_strong_explicit(&worker->table[next[k]], &expected, nextDepth,
+                                                        memory_order_relaxed, memory_order_relaxed)) {
+                worker->found++;
+            }
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Fill table[0..size) with distances from goal. Layers are expanded until
+ * one adds nothing; positions never reached keep PRUNE_UNVISITED. threads
+ * <= 0 uses every online CPU. Returns false if a thread could not be
+ * started or the depth would overflow a byte.
+ */
+bool pruneTableBuild(uint8_t* table, size_t size, size_t goal, PruneExpand expand, const void* context, int threads) {
+    if (threads <= 0) threads = workPoolDefaultThreads();
+    if (threads > MAX_THREADS) threads = MAX_THREADS;
+    if ((size_t)threads > size) threads = (int)size;
+
+    memset(table, PRUNE_UNVISITED, size);
+    table[goal] = 0;
+
+    PruneWorker workers[MAX_THREADS];
+    pthread_t handles[MAX_THREADS];
+    for (int t = 0; t < threads; t++) {
+        workers[t].table = (_Atomic uint8_t*)table;
+        workers[t].begin = size * t / threads;
+        workers[t].end = size * (t + 1) / threads;
+        workers[t].expand = expand;
+        workers[t].context = context;
+    }
+
+    for (int depth = 0; depth < PRUNE_UNVISITED - 1; depth++) {
+        // The calling thread takes the first slice itself
+        int started = 1;
+        for (int t = 0; t < threads; t++) workers[t].depth = (uint8_t)depth;
+        for (int t = 1; t < threads; t++, started++) {
+            if (pthread_create(&handles[t], NULL, expandLayer, &workers[t]) != 0) break;
+        }
+        expandLayer(&workers[0]);
+
+        size_t found = workers[0].found;
+        for (int t = 1; t < started; t++) {
+            pthread_join(handles[t], NULL);
+            found += workers[t].found;
+        }
+        if (started < threads) return false;
+        if (found == 0) return true;
+    }
+    return false;
+}
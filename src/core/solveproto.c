@@ -0,0 +1,76 @@
+#include <string.h>
+#include "solveproto.h"
+#include "symmetry.h"
+
+// Whether a request header is one this version can serve; false means the stream cannot be trusted
+bool solveProtoRequestValid(const SolveFrameHeader* header) {
+    return header->version == SOLVE_PROTO_VERSION &&
+           header->op >= SOLVE_OP_SOLVE && header->op <= SOLVE_OP_CANONICALISE &&
+           header->length >= (uint32_t)SOLVE_PROTO_STATE_SIZE && header->length <= SOLVE_PROTO_MAX_PAYLOAD;
+}
+
+/**
+ * Write a request frame to out (sizeof(SolveFrameHeader) +
+ * SOLVE_PROTO_MAX_PAYLOAD bytes at most) and return its size; moveCount is
+ * capped at SOLVE_PROTO_MAX_MOVES.
+ */
+size_t solveProtoEncodeRequest(SolveOp op, uint32_t id, uint8_t param, const CubeState* state,
+                               const uint8_t* moves, int moveCount, uint8_t* out) {
+    if (moveCount > SOLVE_PROTO_MAX_MOVES) moveCount = SOLVE_PROTO_MAX_MOVES;
+    SolveFrameHeader header = {
+        (uint32_t)(SOLVE_PROTO_STATE_SIZE + moveCount), id, (uint8_t)op, SOLVE_STATUS_OK, SOLVE_PROTO_VERSION, param,
+    };
+    memcpy(out, &header, sizeof(header));
+    memcpy(out + sizeof(header), state, SOLVE_PROTO_STATE_SIZE);
+    if (moveCount > 0) memcpy(out + sizeof(header) + SOLVE_PROTO_STATE_SIZE, moves, (size_t)moveCount);
+    return sizeof(header) + (size_t)SOLVE_PROTO_STATE_SIZE + (size_t)moveCount;
+}
+
+static size_t respond(const SolveFrameHeader* request, SolveStatus status, const void* payload, size_t length,
+                      uint8_t* response) {
+    SolveFrameHeader header = {(uint32_t)length, request->id, request->op, (uint8_t)status, SOLVE_PROTO_VERSION, 0};
+    memcpy(response, &header, sizeof(header));
+    if (length > 0) memcpy(response + sizeof(header), payload, length);
+    return sizeof(header) + length;
+}
+
+/**
+ * Serve one request whose header passed solveProtoRequestValid: write the
+ * response frame (SOLVE_PROTO_MAX_RESPONSE bytes at most) and return its
+ * size. Safe to call from any number of threads at once.
+ */
+size_t solveProtoExecute(const SolveService* service, const SolveFrameHeader* request, const uint8_t* payload,
+                         uint8_t* response) {
+    CubeState state;
+    memcpy(&state, payload, SOLVE_PROTO_STATE_SIZE);
+    if (!cubeStateIsValid(&state)) return respond(request, SOLVE_STATUS_INVALID_STATE, NULL, 0, response);
+
+    const uint8_t* moves = payload + SOLVE_PROTO_STATE_SIZE;
+    int moveCount = (int)request->length - SOLVE_PROTO_STATE_SIZE;
+    for (int i = 0; i < moveCount; i++) {
+        if (moves[i] >= MOVE_COUNT) return respond(request, SOLVE_STATUS_BAD_REQUEST, NULL, 0, response);
+    }
+    cubeStateApplyMoves(&state, moves, moveCount);
+
+    switch ((SolveOp)request->op) {
+        case SOLVE_OP_SOLVE: {
+            uint8_t solution[SOLVER_MAX_LENGTH];
+            int target = request->param ? request->param : service->targetLength;
+            int count = solverSolve(service->solver, &state, target, service->timeLimit, solution);
+            if (count < 0) return respond(request, SOLVE_STATUS_NO_SOLUTION, NULL, 0, response);
+            return respond(request, SOLVE_STATUS_OK, solution, (size_t)count, response);
+        }
+        case SOLVE_OP_APPLY:
+            return respond(request, SOLVE_STATUS_OK, &state, SOLVE_PROTO_STATE_SIZE, response);
+        case SOLVE_OP_VERIFY: {
+            uint8_t solved = cubeStateIsSolved(&state);
+            return respond(request, SOLVE_STATUS_OK, &solved, 1, response);
+        }
+        case SOLVE_OP_CANONICALISE: {
+            CubeState canonical;
+            cubeStateCanonical(&state, request->param == 1, &canonical);
+            return respond(request, SOLVE_STATUS_OK, &canonical, SOLVE_PROTO_STATE_SIZE, response);
+        }
+    }
+    return respond(request, SOLVE_STATUS_BAD_REQUEST, NULL, 0, response);
+}
@@ -0,0 +1,406 @@
+#include <stdlib.h>
+#include <string.h>
+#include "prunetable.h"
+#include "solver.h"
+#include "statecodec.h"
+#include "clock.h"
+
+// Any phase 2 position is solvable in 18 moves, but longer phase 2 tails are
+// rarely worth searching: a different phase 1 almost always finishes sooner
+#define PHASE2_MAX_LENGTH 12
+
+const Move phase2Moves[PHASE2_MOVE_COUNT] = {
+    MOVE_U, MOVE_U2, MOVE_U_PRIME, MOVE_D, MOVE_D2, MOVE_D_PRIME,
+    MOVE_R2, MOVE_L2, MOVE_F2, MOVE_B2,
+};
+
+// Binomial coefficients up to 12 choose 4, for the slice coordinate
+static int choose(int n, int k) {
+    if (k < 0 || k > n) return 0;
+    int result = 1;
+    for (int i = 0; i < k; i++) result = result * (n - i) / (i + 1);
+    return result;
+}
+
+// Which 4 of the 12 edge slots hold E-slice edges (FR, FL, BL, BR); 0 when home
+static int getSlice(const CubeState* state) {
+    int slice = 0, found = 0;
+    for (int j = EDGE_COUNT - 1; j >= 0; j--) {
+        if (state->ep[j] >= EDGE_FR) slice += choose(EDGE_COUNT - 1 - j, ++found);
+    }
+    return slice;
+}
+
+static void setSlice(CubeState* state, int slice) {
+    int left = 4, other = 0;
+    for (int j = 0; j < EDGE_COUNT; j++) {
+        int c = choose(EDGE_COUNT - 1 - j, left);
+        if (left > 0 && slice >= c) {
+            state->ep[j] = (uint8_t)(EDGE_FR + 4 - left);
+            slice -= c;
+            left--;
+        } else {
+            state->ep[j] = (uint8_t)other++;
+        }
+    }
+}
+
+static int getCornerPerm(const CubeState* state) { return (int)permutationRank(state->cp, CORNER_COUNT); }
+static int getEdge8Perm(const CubeState* state) { return (int)permutationRank(state->ep, 8); }
+static int getSlicePerm(const CubeState* state) { return (int)permutationRank(state->ep + EDGE_FR, 4); }
+
+static void setCornerPerm(CubeState* state, int rank) { permutationUnrank((uint32_t)rank, CORNER_COUNT, 0, state->cp); }
+static void setEdge8Perm(CubeState* state, int rank) { permutationUnrank((uint32_t)rank, 8, 0, state->ep); }
+static void setSlicePerm(CubeState* state, int rank) { permutationUnrank((uint32_t)rank, 4, EDGE_FR, state->ep + EDGE_FR); }
+
+/**
+ * coordinate x move -> coordinate, by building a representative state for
+ * each coordinate and applying every move to it once.
+ */
+static void buildMoveTable(uint16_t* table, int count, const Move* moves, int moveCount,
+                           void (*set)(CubeState*, int), int (*get)(const CubeState*)) {
+    for (int c = 0; c < count; c++) {
+        CubeState state, moved;
+        cubeStateInit(&state);
+        set(&state, c);
+        for (int m = 0; m < moveCount; m++) {
+            cubeStateMultiply(&state, &moveTable[moves[m]], &moved);
+            table[c * moveCount + m] = (uint16_t)get(&moved);
+        }
+    }
+}
+
+// The product of two coordinates, for pruning table generation
+typedef struct {
+    const uint16_t* moveA;
+    const uint16_t* moveB;
+    int countB;
+    int moveCount;
+} CoordinatePair;
+
+static int expandPair(const void* context, size_t index, size_t* next) {
+    const CoordinatePair* pair = context;
+    int a = (int)(index / pair->countB), b = (int)(index % pair->countB);
+    for (int m = 0; m < pair->moveCount; m++) {
+        next[m] = (size_t)pair->moveA[a * pair->moveCount + m] * pair->countB + pair->moveB[b * pair->moveCount + m];
+    }
+    return pair->moveCount;
+}
+
+// Distances from the goal (index 0) over the product of two coordinates
+static bool buildPruneTable(uint8_t* table, const uint16_t* moveA, int countA, const uint16_t* moveB, int countB,
+                            int moveCount, int threads) {
+    CoordinatePair pair = {moveA, moveB, countB, moveCount};
+    return pruneTableBuild(table, (size_t)countA * countB, 0, expandPair, &pair, threads);
+}
+
+// Every table in file order; data is NULL for a solver that has none yet
+static int solverSections(const Solver* solver, TableSection sections[SOLVER_TABLE_COUNT]) {
+    const TableSection layout[SOLVER_TABLE_COUNT] = {
+        {solver->twistMove, sizeof(uint16_t) * TWIST_COUNT * MOVE_COUNT},
+        {solver->flipMove, sizeof(uint16_t) * FLIP_COUNT * MOVE_COUNT},
+        {solver->sliceMove, sizeof(uint16_t) * SLICE_COUNT * MOVE_COUNT},
+        {solver->cornerPermMove, sizeof(uint16_t) * CORNER_PERM_COUNT * PHASE2_MOVE_COUNT},
+        {solver->edge8PermMove, sizeof(uint16_t) * EDGE8_PERM_COUNT * PHASE2_MOVE_COUNT},
+        {solver->slicePermMove, sizeof(uint16_t) * SLICE_PERM_COUNT * PHASE2_MOVE_COUNT},
+        {solver->twistSlicePrune, (size_t)TWIST_COUNT * SLICE_COUNT},
+        {solver->flipSlicePrune, (size_t)FLIP_COUNT * SLICE_COUNT},
+        {solver->cornerSlicePrune, (size_t)CORNER_PERM_COUNT * SLICE_PERM_COUNT},
+        {solver->edgeSlicePrune, (size_t)EDGE8_PERM_COUNT * SLICE_PERM_COUNT},
+    };
+    memcpy(sections, layout, sizeof(layout));
+    return SOLVER_TABLE_COUNT;
+}
+
+// Point the solver at its tables, given in solverSections order
+static void assignTables(Solver* solver, uint8_t* tables[SOLVER_TABLE_COUNT]) {
+    solver->twistMove = (uint16_t*)tables[0];
+    solver->flipMove = (uint16_t*)tables[1];
+    solver->sliceMove = (uint16_t*)tables[2];
+    solver->cornerPermMove = (uint16_t*)tables[3];
+    solver->edge8PermMove = (uint16_t*)tables[4];
+    solver->slicePermMove = (uint16_t*)tables[5];
+    solver->twistSlicePrune = tables[6];
+    solver->flipSlicePrune = tables[7];
+    solver->cornerSlicePrune = tables[8];
+    solver->edgeSlicePrune = tables[9];
+}
+
+/**
+ * What the tables depend on: the move set, the phase 2 subgroup and the
+ * coordinate sizes. A table file built under anything else is rejected.
+ */
+uint64_t solverFingerprint(void) {
+    const uint32_t sizes[] = {
+        TWIST_COUNT, FLIP_COUNT, SLICE_COUNT, CORNER_PERM_COUNT, EDGE8_PERM_COUNT, SLICE_PERM_COUNT,
+        MOVE_COUNT, PHASE2_MOVE_COUNT, SOLVER_TABLE_COUNT,
+    };
+    uint8_t moves[PHASE2_MOVE_COUNT];
+    for (int m = 0; m < PHASE2_MOVE_COUNT; m++) moves[m] = (uint8_t)phase2Moves[m];
+
+    uint64_t hash = tableChecksum(0, sizes, sizeof(sizes));
+    hash = tableChecksum(hash, moveTable, sizeof(CubeState) * MOVE_COUNT);
+    return tableChecksum(hash, moves, sizeof(moves));
+}
+
+/**
+ * Build every table in memory. The pruning tables are filled one BFS depth
+ * layer at a time by threads workers (<= 0: one per CPU).
+ */
+bool solverInit(Solver* solver, int threads) {
+    Move allMoves[MOVE_COUNT];
+    for (int m = 0; m < MOVE_COUNT; m++) allMoves[m] = (Move)m;
+
+    memset(solver, 0, sizeof(*solver));
+    TableSection sections[SOLVER_TABLE_COUNT];
+    uint8_t* tables[SOLVER_TABLE_COUNT];
+    solverSections(solver, sections);
+    for (int i = 0; i < SOLVER_TABLE_COUNT; i++) {
+        tables[i] = malloc(sections[i].size);
+    }
+    assignTables(solver, tables);
+    for (int i = 0; i < SOLVER_TABLE_COUNT; i++) {
+        if (!tables[i]) {
+            solverFree(solver);
+            return false;
+        }
+    }
+
+    buildMoveTable(solver->twistMove, TWIST_COUNT, allMoves, MOVE_COUNT, twistUnrank, twistRank);
+    buildMoveTable(solver->flipMove, FLIP_COUNT, allMoves, MOVE_COUNT, flipUnrank, flipRank);
+    buildMoveTable(solver->sliceMove, SLICE_COUNT, allMoves, MOVE_COUNT, setSlice, getSlice);
+    buildMoveTable(solver->cornerPermMove, CORNER_PERM_COUNT, phase2Moves, PHASE2_MOVE_COUNT, setCornerPerm, getCornerPerm);
+    buildMoveTable(solver->edge8PermMove, EDGE8_PERM_COUNT, phase2Moves, PHASE2_MOVE_COUNT, setEdge8Perm, getEdge8Perm);
+    buildMoveTable(solver->slicePermMove, SLICE_PERM_COUNT, phase2Moves, PHASE2_MOVE_COUNT, setSlicePerm, getSlicePerm);
+
+    bool ok = buildPruneTable(solver->twistSlicePrune, solver->twistMove, TWIST_COUNT,
+                              solver->sliceMove, SLICE_COUNT, MOVE_COUNT, threads)
+           && buildPruneTable(solver->flipSlicePrune, solver->flipMove, FLIP_COUNT,
+                              solver->sliceMove, SLICE_COUNT, MOVE_COUNT, threads)
+           && buildPruneTable(solver->cornerSlicePrune, solver->cornerPermMove, CORNER_PERM_COUNT,
+                              solver->slicePermMove, SLICE_PERM_COUNT, PHASE2_MOVE_COUNT, threads)
+           && buildPruneTable(solver->edgeSlicePrune, solver->edge8PermMove, EDGE8_PERM_COUNT,
+                              solver->slicePermMove, SLICE_PERM_COUNT, PHASE2_MOVE_COUNT, threads);
+    if (!ok) solverFree(solver);
+    return ok;
+}
+
+/**
+ * Map the tables from a table file, or build them and save the file for
+ * next time if it is missing or stale. Mapped tables are shared with every
+ * other process using the same file and stay read-only. Failing to save is
+ * reported but not fatal.
+ */
+bool solverInitCached(Solver* solver, const char* path, int threads) {
+    TableSection sections[SOLVER_TABLE_COUNT];
+    Solver empty;
+    memset(&empty, 0, sizeof(empty));
+    solverSections(&empty, sections);
+    size_t payloadSize = tableSectionOffset(sections, SOLVER_TABLE_COUNT);
+
+    TableStoreMap store;
+    if (tableStoreOpen(path, SOLVER_TABLE_NAME, solverFingerprint(), payloadSize, TABLE_STORE_VERIFY, &store)) {
+        // The mapping is read-only; so is the solver after init
+        uint8_t* tables[SOLVER_TABLE_COUNT];
+        for (int i = 0; i < SOLVER_TABLE_COUNT; i++) {
+            tables[i] = (uint8_t*)store.data + tableSectionOffset(sections, i);
+        }
+        memset(solver, 0, sizeof(*solver));
+        assignTables(solver, tables);
+        solver->store = store;
+        return true;
+    }
+
+    if (!solverInit(solver, threads)) return false;
+    solverSections(solver, sections);
+    tableStoreWrite(path, SOLVER_TABLE_NAME, solverFingerprint(), sections, SOLVER_TABLE_COUNT);
+    return true;
+}
+
+void solverFree(Solver* solver) {
+    if (solver->store.mapping) {
+        tableStoreClose(&solver->store);
+    } else {
+        free(solver->twistMove);
+        free(solver->flipMove);
+        free(solver->sliceMove);
+        free(solver->cornerPermMove);
+        free(solver->edge8PermMove);
+        free(solver->slicePermMove);
+        free(solver->twistSlicePrune);
+        free(solver->flipSlicePrune);
+        free(solver->cornerSlicePrune);
+        free(solver->edgeSlicePrune);
+    }
+    memset(solver, 0, sizeof(*solver));
+}
+
+typedef struct {
+    const Solver* solver;
+    CubeState start;
+    int targetLength;       // Stop at a solution this short once no longer phase 1 could beat it
+    double deadline;        // After this, settle for the best solution so far
+    unsigned long nodes;
+    bool stop;
+    int bestLength;         // SOLVER_MAX_LENGTH + 1 until a solution is found
+    uint8_t best[SOLVER_MAX_LENGTH];
+    uint8_t path[SOLVER_MAX_LENGTH];
+} Search;
+
+/**
+ * Skip moves that cannot shorten a solution: the same face twice in a row,
+ * and opposite faces (which commute) in anything but one fixed order.
+ */
+static bool redundantAfter(int depth, const uint8_t* path, Move move) {
+    return depth > 0 && moveIsRedundant((Move)path[depth - 1], move);
+}
+
+// Only a search with something to return may run out of time
+static bool outOfTime(const Search* search) {
+    return search->bestLength <= SOLVER_MAX_LENGTH && clockSeconds() > search->deadline;
+}
+
+static int max2(int a, int b) {
+    return a > b ? a : b;
+}
+
+/**
+ * Phase 2 from depth, in exactly togo more moves. The first of them may turn
+ * the face phase 1 ended on: the two then become one quarter turn (R then R2
+ * is R'), so a phase 1 that overshot by a quarter turn costs nothing. Only a
+ * solution shorter than the best so far counts; it becomes the new best.
+ */
+static bool phase2(Search* search, int cornerPerm, int edge8Perm, int slicePerm, int depth, int togo, bool first) {
+    if (togo == 0) {
+        if (cornerPerm != 0 || edge8Perm != 0 || slicePerm != 0 || depth >= search->bestLength) return false;
+        search->bestLength = depth;
+        memcpy(search->best, search->path, (size_t)depth);
+        return true;
+    }
+
+    const Solver* s = search->solver;
+    bool found = false;
+    for (int m = 0; m < PHASE2_MOVE_COUNT; m++) {
+        Move move = phase2Moves[m];
+        bool merge = first && depth > 0 && moveFace((Move)search->path[depth - 1]) == moveFace(move);
+        if (!merge && (redundantAfter(depth, search->path, move) || depth + togo >= search->bestLength)) continue;
+
+        int c = s->cornerPermMove[cornerPerm * PHASE2_MOVE_COUNT + m];
+        int e = s->edge8PermMove[edge8Perm * PHASE2_MOVE_COUNT + m];
+        int p = s->slicePermMove[slicePerm * PHASE2_MOVE_COUNT + m];
+        int h = max2(s->cornerSlicePrune[c * SLICE_PERM_COUNT + p], s->edgeSlicePrune[e * SLICE_PERM_COUNT + p]);
+        if (h > togo - 1) continue;
+
+        if (merge) {
+            // Phase 1 never ends on a half turn, so the merged move is always a quarter turn
+            uint8_t last = search->path[depth - 1];
+            search->path[depth - 1] = (uint8_t)moveFromFace(moveFace(move), (moveQuarterTurns((Move)last) + 2) % 4);
+            bool merged = phase2(search, c, e, p, depth, togo - 1, false);
+            search->path[depth - 1] = last;
+            if (merged) return true;
+            continue;
+        }
+
+        search->path[depth] = (uint8_t)move;
+        if (phase2(search, c, e, p, depth + 1, togo - 1, false)) {
+            // A merged first move could still save one
+            if (!first) return true;
+            found = true;
+        }
+    }
+    return found;
+}
+
+// A phase 1 solution of this length was found: finish it if that beats the best so far
+static void startPhase2(Search* search, int length1) {
+    if (outOfTime(search)) {
+        search->stop = true;
+        return;
+    }
+
+    const Solver* s = search->solver;
+    CubeState state = search->start;
+    cubeStateApplyMoves(&state, search->path, length1);
+
+    int cornerPerm = getCornerPerm(&state);
+    int edge8Perm = getEdge8Perm(&state);
+    int slicePerm = getSlicePerm(&state);
+    int h = max2(s->cornerSlicePrune[cornerPerm * SLICE_PERM_COUNT + slicePerm],
+                 s->edgeSlicePrune[edge8Perm * SLICE_PERM_COUNT + slicePerm]);
+
+    int saved = length1 > 0 ? 1 : 0;    // At most one move merges at the boundary
+    for (int length2 = h; length2 <= PHASE2_MAX_LENGTH && length1 + length2 - saved < search->bestLength; length2++) {
+        if (phase2(search, cornerPerm, edge8Perm, slicePerm, length1, length2, true)) {
+            // A phase 1 shorter than the solution may still finish sooner; the next length is length1 + 1
+            if (search->bestLength <= search->targetLength && search->bestLength <= length1 + 1) search->stop = true;
+            return;
+        }
+    }
+}
+
+static void phase1(Search* search, int twist, int flip, int slice, int depth, int togo) {
+    // Phase 1 nodes are cheap: look at the clock only now and then
+    if ((++search->nodes & 1023) == 0 && outOfTime(search)) {
+        search->stop = true;
+    }
+    if (search->stop) return;
+
+    if (togo == 0) {
+        // Ending phase 1 on a phase 2 move only repeats a shorter phase 1
+        if (depth > 0) {
+            Move last = (Move)search->path[depth - 1];
+            FaceID face = moveFace(last);
+            if (face == FACE_TOP || face == FACE_BOTTOM || moveQuarterTurns(last) == 2) return;
+        }
+        startPhase2(search, depth);
+        return;
+    }
+
+    const Solver* s = search->solver;
+    for (int m = 0; m < MOVE_COUNT && !search->stop; m++) {
+        if (redundantAfter(depth, search->path, (Move)m)) continue;
+
+        int t = s->twistMove[twist * MOVE_COUNT + m];
+        int f = s->flipMove[flip * MOVE_COUNT + m];
+        int sl = s->sliceMove[slice * MOVE_COUNT + m];
+        int h = max2(s->twistSlicePrune[t * SLICE_COUNT + sl], s->flipSlicePrune[f * SLICE_COUNT + sl]);
+        if (h > togo - 1) continue;
+
+        search->path[depth] = (uint8_t)m;
+        phase1(search, t, f, sl, depth + 1, togo - 1);
+    }
+}
+
+/**
+ * Solve a state (half-turn metric), writing the moves to moves[]. The first
+ * solution turns up within a millisecond or so; the search then keeps
+ * trying longer phase 1 prefixes for shorter totals until the best is
+ * within targetLength and no phase 1 prefix left to try is shorter than it,
+ * or timeLimit seconds have passed, and returns the best so far. Returns
+ * the solution length, or -1 for an invalid state.
+ */
+int solverSolve(const Solver* solver, const CubeState* state, int targetLength, double timeLimit, uint8_t* moves) {
+    if (!cubeStateIsValid(state)) return -1;
+
+    Search search;
+    search.solver = solver;
+    search.start = *state;
+    search.targetLength = targetLength;
+    search.deadline = clockSeconds() + timeLimit;
+    search.nodes = 0;
+    search.stop = false;
+    search.bestLength = SOLVER_MAX_LENGTH + 1;
+
+    int twist = twistRank(state);
+    int flip = flipRank(state);
+    int slice = getSlice(state);
+    int h = max2(solver->twistSlicePrune[twist * SLICE_COUNT + slice], solver->flipSlicePrune[flip * SLICE_COUNT + slice]);
+
+    for (int length1 = h; length1 < search.bestLength && !search.stop; length1++) {
+        phase1(&search, twist, flip, slice, 0, length1);
+    }
+
+    if (search.bestLength > SOLVER_MAX_LENGTH) return -1;
+    memcpy(moves, search.best, (size_t)search.bestLength);
+    return search.bestLength;
+}
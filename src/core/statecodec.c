@@ -0,0 +1,233 @@
+#include <pthread.h>
+#include "statecodec.h"
+
+#define ZOBRIST_SEED 0x52554249u  // "RUBI"
+
+// The slots a move changes; every face turn changes four corners and four edges
+typedef struct {
+    int cornerCount, edgeCount;
+    uint8_t corners[CORNER_COUNT];
+    uint8_t edges[EDGE_COUNT];
+} MoveSlots;
+
+static pthread_once_t keysOnce = PTHREAD_ONCE_INIT;
+static uint64_t cornerKeys[CORNER_COUNT][CORNER_COUNT][3];
+static uint64_t edgeKeys[EDGE_COUNT][EDGE_COUNT][2];
+static MoveSlots moveSlots[MOVE_COUNT];
+
+// __builtin_popcount is a library call unless the target has a popcount instruction
+static inline int countBits(uint32_t x) {
+#ifdef __POPCNT__
+    return __builtin_popcount(x);
+#else
+    x -= (x >> 1) & 0x55555555u;
+    x = (x & 0x33333333u) + ((x >> 2) & 0x33333333u);
+    return (int)((((x + (x >> 4)) & 0x0f0f0f0fu) * 0x01010101u) >> 24);
+#endif
+}
+
+/**
+ * Lehmer rank of n distinct values below 32: digit i counts the later
+ * values smaller than perm[i], read off a bitmask of the values still to
+ * come. Only relative order matters, so any value set ranks from 0.
+ */
+uint32_t permutationRank(const uint8_t* perm, int n) {
+    uint32_t remaining = 0, rank = 0;
+    for (int i = 0; i < n; i++) remaining |= 1u << perm[i];
+    for (int i = 0; i < n; i++) {
+        remaining &= ~(1u << perm[i]);
+        rank = rank * (uint32_t)(n - i) + (uint32_t)countBits(remaining & ((1u << perm[i]) - 1));
+    }
+    return rank;
+}
+
+// Inverse of permutationRank over the values base..base+n-1
+void permutationUnrank(uint32_t rank, int n, int base, uint8_t* perm) {
+    int digits[32];
+    for (int i = n - 1; i >= 0; i--) {
+        digits[i] = (int)(rank % (uint32_t)(n - i));
+        rank /= (uint32_t)(n - i);
+    }
+    uint32_t available = n == 32 ? ~0u : (1u << n) - 1;
+    for (int i = 0; i < n; i++) {
+        uint32_t candidates = available;
+        for (int k = 0; k < digits[i]; k++) candidates &= candidates - 1;
+        int value = __builtin_ctz(candidates);
+        available &= ~(1u << value);
+        perm[i] = (uint8_t)(base + value);
+    }
+}
+
+// 0 for even, 1 for odd: the parity of the number of inversions
+int permutationParity(const uint8_t* perm, int n) {
+    uint32_t seen = 0;
+    int inversions = 0;
+    for (int i = 0; i < n; i++) {
+        inversions += countBits(seen & ~((2u << perm[i]) - 1));
+        seen |= 1u << perm[i];
+    }
+    return inversions & 1;
+}
+
+int twistRank(const CubeState* state) {
+    int twist = 0;
+    for (int i = 0; i < CORNER_COUNT - 1; i++) twist = twist * 3 + state->co[i];
+    return twist;
+}
+
+// The last corner's twist follows from the others (the total is 0 mod 3)
+void twistUnrank(CubeState* state, int twist) {
+    int sum = 0;
+    for (int i = CORNER_COUNT - 2; i >= 0; i--) {
+        state->co[i] = (uint8_t)(twist % 3);
+        sum += state->co[i];
+        twist /= 3;
+    }
+    state->co[CORNER_COUNT - 1] = (uint8_t)((3 - sum % 3) % 3);
+}
+
+int flipRank(const CubeState* state) {
+    int flip = 0;
+    for (int i = 0; i < EDGE_COUNT - 1; i++) flip = flip * 2 + state->eo[i];
+    return flip;
+}
+
+void flipUnrank(CubeState* state, int flip) {
+    int sum = 0;
+    for (int i = EDGE_COUNT - 2; i >= 0; i--) {
+        state->eo[i] = (uint8_t)(flip & 1);
+        sum += state->eo[i];
+        flip >>= 1;
+    }
+    state->eo[EDGE_COUNT - 1] = (uint8_t)(sum & 1);
+}
+
+uint32_t cornerRank(const CubeState* state) {
+    return permutationRank(state->cp, CORNER_COUNT) * 2187u + (uint32_t)twistRank(state);
+}
+
+void cornerUnrank(CubeState* state, uint32_t rank) {
+    permutationUnrank(rank / 2187u, CORNER_COUNT, 0, state->cp);
+    twistUnrank(state, (int)(rank % 2187u));
+}
+
+/**
+ * Lehmer ranks 2k and 2k+1 differ by a swap of the last two values, so
+ * halving the rank loses exactly the parity, which the corners supply.
+ */
+uint64_t edgeRank(const CubeState* state) {
+    return (uint64_t)(permutationRank(state->ep, EDGE_COUNT) >> 1) * 2048u + (uint64_t)flipRank(state);
+}
+
+// The corners must already be in place: they decide the edge parity
+void edgeUnrank(CubeState* state, uint64_t rank) {
+    permutationUnrank((uint32_t)(rank / 2048u) * 2u, EDGE_COUNT, 0, state->ep);
+    if (permutationParity(state->ep, EDGE_COUNT) != permutationParity(state->cp, CORNER_COUNT)) {
+        uint8_t swap = state->ep[EDGE_COUNT - 2];
+        state->ep[EDGE_COUNT - 2] = state->ep[EDGE_COUNT - 1];
+        state->ep[EDGE_COUNT - 1] = swap;
+    }
+    flipUnrank(state, (int)(rank % 2048u));
+}
+
+// The state must be valid (see cubeStateIsValid)
+CubeRank cubeStateRank(const CubeState* state) {
+    return (CubeRank)cornerRank(state) * EDGE_RANK_COUNT + edgeRank(state);
+}
+
+// The flip digits come off with a shift, leaving a 64-bit division instead of a 128-bit one
+bool cubeStateUnrank(CubeRank rank, CubeState* state) {
+    if (rank >= CUBE_STATE_COUNT) return false;
+    uint64_t high = (uint64_t)(rank >> 11);
+    uint64_t edgePerms = EDGE_RANK_COUNT >> 11;
+    cornerUnrank(state, (uint32_t)(high / edgePerms));
+    edgeUnrank(state, (high % edgePerms) << 11 | (uint64_t)(rank & 2047u));
+    return true;
+}
+
+void cubeStatesRank(const CubeState* states, size_t count, CubeRank* ranks) {
+    for (size_t i = 0; i < count; i++) ranks[i] = cubeStateRank(&states[i]);
+}
+
+// Returns how many ranks were decoded: all of them, or up to the first out of range
+size_t cubeStatesUnrank(const CubeRank* ranks, size_t count, CubeState* states) {
+    for (size_t i = 0; i < count; i++) {
+        if (!cubeStateUnrank(ranks[i], &states[i])) return i;
+    }
+    return count;
+}
+
+static uint64_t splitmix64(uint64_t* seed) {
+    uint64_t z = (*seed += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+// Fixed seed: hashes are stable across runs and processes
+static void buildKeys(void) {
+    uint64_t seed = ZOBRIST_SEED;
+    for (int i = 0; i < CORNER_COUNT; i++) {
+        for (int c = 0; c < CORNER_COUNT; c++) {
+            for (int o = 0; o < 3; o++) cornerKeys[i][c][o] = splitmix64(&seed);
+        }
+    }
+    for (int i = 0; i < EDGE_COUNT; i++) {
+        for (int e = 0; e < EDGE_COUNT; e++) {
+            for (int o = 0; o < 2; o++) edgeKeys[i][e][o] = splitmix64(&seed);
+        }
+    }
+
+    for (int m = 0; m < MOVE_COUNT; m++) {
+        MoveSlots* slots = &moveSlots[m];
+        for (int i = 0; i < CORNER_COUNT; i++) {
+            if (moveTable[m].cp[i] != i || moveTable[m].co[i] != 0) slots->corners[slots->cornerCount++] = (uint8_t)i;
+        }
+        for (int i = 0; i < EDGE_COUNT; i++) {
+            if (moveTable[m].ep[i] != i || moveTable[m].eo[i] != 0) slots->edges[slots->edgeCount++] = (uint8_t)i;
+        }
+    }
+}
+
+uint64_t cubeStateHash(const CubeState* state) {
+    pthread_once(&keysOnce, buildKeys);
+    uint64_t hash = 0;
+    for (int i = 0; i < CORNER_COUNT; i++) hash ^= cornerKeys[i][state->cp[i]][state->co[i]];
+    for (int i = 0; i < EDGE_COUNT; i++) hash ^= edgeKeys[i][state->ep[i]][state->eo[i]];
+    return hash;
+}
+
+/**
+ * Apply move and return the new hash, given the hash before the move. Only
+ * the slots the move changes are read, rewritten and rehashed; the rest of
+ * the state and hash stay as they are.
+ */
+uint64_t cubeStateApplyMoveHashed(CubeState* state, uint64_t hash, Move move) {
+    pthread_once(&keysOnce, buildKeys);
+    const MoveSlots* slots = &moveSlots[move];
+    const CubeState* turn = &moveTable[move];
+    uint8_t cp[CORNER_COUNT], co[CORNER_COUNT], ep[EDGE_COUNT], eo[EDGE_COUNT];
+
+    for (int k = 0; k < slots->cornerCount; k++) {
+        int i = slots->corners[k], from = turn->cp[i];
+        cp[k] = state->cp[from];
+        co[k] = (uint8_t)((state->co[from] + turn->co[i]) % 3);
+        hash ^= cornerKeys[i][state->cp[i]][state->co[i]] ^ cornerKeys[i][cp[k]][co[k]];
+    }
+    for (int k = 0; k < slots->edgeCount; k++) {
+        int i = slots->edges[k], from = turn->ep[i];
+        ep[k] = state->ep[from];
+        eo[k] = state->eo[from] ^ turn->eo[i];
+        hash ^= edgeKeys[i][state->ep[i]][state->eo[i]] ^ edgeKeys[i][ep[k]][eo[k]];
+    }
+
+    for (int k = 0; k < slots->cornerCount; k++) {
+        state->cp[slots->corners[k]] = cp[k];
+        state->co[slots->corners[k]] = co[k];
+    }
+    for (int k = 0; k < slots->edgeCount; k++) {
+        state->ep[slots->edges[k]] = ep[k];
+        state->eo[slots->edges[k]] = eo[k];
+    }
+    return hash;
+}
@@ -0,0 +1,463 @@
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include "algorithm.h"
+#include "statecodec.h"
+#include "subgroup.h"
+#include "clock.h"
+
+#define CHUNK_WORDS 4096        // 131072 positions per task
+#define POSITIONS_PER_WORD 32
+#define EVEN_BITS 0x5555555555555555ull
+
+// A position as the coordinates of each orbit, parity and implied digits included
+typedef struct {
+    uint32_t permutation[SUBGROUP_MAX_ORBITS];
+    uint32_t orientation[SUBGROUP_MAX_ORBITS];
+} Coordinates;
+
+// Two bits per position; which of LAYER_A and LAYER_B is the current layer alternates
+enum { UNSEEN = 0, LAYER_A = 1, LAYER_B = 2, DONE = 3 };
+
+typedef struct {
+    const Subgroup* group;
+    _Atomic uint64_t* words;
+    uint64_t wordCount;
+    uint64_t current, next;     // Codes of this layer and the next
+    _Atomic uint64_t found;
+} Layer;
+
+typedef struct {
+    Layer* layer;
+    uint64_t begin, end;        // Words
+} LayerTask;
+
+/**
+ * Parse generators in standard notation: a quarter turn stands for every
+ * turn of its face ("R" is R, R2 and R'), a half turn only for itself ("F2").
+ * Writes the moves in Move order and returns how many, or -1 on a syntax
+ * error or no moves at all.
+ */
+int subgroupParseGenerators(const char* text, Move* moves) {
+    uint8_t parsed[ALGORITHM_MAX_MOVES];
+    int parsedCount = parseAlgorithm(text, parsed, ALGORITHM_MAX_MOVES);
+    if (parsedCount <= 0) return -1;
+
+    bool present[MOVE_COUNT] = { false };
+    for (int i = 0; i < parsedCount; i++) {
+        Move move = (Move)parsed[i];
+        if (moveQuarterTurns(move) == 2) {
+            present[move] = true;
+            continue;
+        }
+        for (int q = 1; q <= 3; q++) present[moveFromFace(moveFace(move), q)] = true;
+    }
+
+    int count = 0;
+    for (int m = 0; m < MOVE_COUNT; m++) {
+        if (present[m]) moves[count++] = (Move)m;
+    }
+    return count;
+}
+
+static int findRoot(uint8_t* parent, int slot) {
+    while (parent[slot] != slot) slot = parent[slot] = parent[parent[slot]];
+    return slot;
+}
+
+// Orbits of one kind of piece under the generators, skipping slots nothing moves
+static void addOrbits(Subgroup* group, bool edges) {
+    int slotCount = edges ? EDGE_COUNT : CORNER_COUNT;
+    uint8_t parent[EDGE_COUNT];
+    bool oriented[EDGE_COUNT] = { false };
+    for (int i = 0; i < slotCount; i++) parent[i] = (uint8_t)i;
+
+    for (int m = 0; m < group->moveCount; m++) {
+        const CubeState* turn = &moveTable[group->moves[m]];
+        for (int i = 0; i < slotCount; i++) {
+            int from = edges ? turn->ep[i] : turn->cp[i];
+            int a = findRoot(parent, i), b = findRoot(parent, from);
+            if (a != b) parent[a] = (uint8_t)b;
+        }
+    }
+    for (int m = 0; m < group->moveCount; m++) {
+        const CubeState* turn = &moveTable[group->moves[m]];
+        for (int i = 0; i < slotCount; i++) {
+            if (edges ? turn->eo[i] : turn->co[i]) oriented[findRoot(parent, i)] = true;
+        }
+    }
+
+    SubgroupOrbit* lastOriented = NULL;
+    for (int root = 0; root < slotCount; root++) {
+        if (findRoot(parent, root) != root) continue;
+
+        SubgroupOrbit* orbit = &group->orbits[group->orbitCount];
+        memset(orbit, 0, sizeof(*orbit));
+        orbit->edges = edges;
+        orbit->oriented = oriented[root];
+        for (int i = 0; i < slotCount; i++) {
+            if (findRoot(parent, i) != root) continue;
+            group->orbitIndex[(edges ? CORNER_COUNT : 0) + i] = (uint8_t)orbit->size;
+            orbit->slots[orbit->size++] = (uint8_t)i;
+        }
+        if (orbit->size < 2) continue;
+
+        // State * turn: slot i takes the piece from turn's slot i, plus turn's orientation there
+        for (int m = 0; m < group->moveCount; m++) {
+            const CubeState* turn = &moveTable[group->moves[m]];
+            for (int k = 0; k < orbit->size; k++) {
+                int slot = orbit->slots[k];
+                int from = edges ? CORNER_COUNT + turn->ep[slot] : turn->cp[slot];
+                orbit->source[m][k] = group->orbitIndex[from];
+                orbit->change[m][k] = edges ? turn->eo[slot] : turn->co[slot];
+            }
+        }
+        if (orbit->oriented) lastOriented = orbit;
+        group->orbitCount++;
+    }
+
+    // The twists (flips) of all pieces add up to 0 mod 3 (2), so one is implied
+    if (lastOriented) lastOriented->implied = true;
+}
+
+static int orientationBase(const SubgroupOrbit* orbit) {
+    return orbit->edges ? 2 : 3;
+}
+
+static uint32_t orientationPower(const SubgroupOrbit* orbit, int digits) {
+    uint32_t power = 1;
+    for (int k = 0; k < digits; k++) power *= (uint32_t)orientationBase(orbit);
+    return power;
+}
+
+static void unrankOrientation(const SubgroupOrbit* orbit, uint32_t coordinate, uint8_t* orientation) {
+    for (int k = orbit->size - 1; k >= 0; k--) {
+        orientation[k] = (uint8_t)(coordinate % (uint32_t)orientationBase(orbit));
+        coordinate /= (uint32_t)orientationBase(orbit);
+    }
+}
+
+static uint32_t rankOrientation(const SubgroupOrbit* orbit, const uint8_t* orientation) {
+    uint32_t coordinate = 0;
+    for (int k = 0; k < orbit->size; k++) coordinate = coordinate * (uint32_t)orientationBase(orbit) + orientation[k];
+    return coordinate;
+}
+
+// Generator m applied to an orbit's pieces and orientations
+static void applyToOrbit(const SubgroupOrbit* orbit, int m, const uint8_t* piece, const uint8_t* orientation,
+                         uint8_t* nextPiece, uint8_t* nextOrientation) {
+    int base = orientationBase(orbit);
+    for (int k = 0; k < orbit->size; k++) {
+        int from = orbit->source[m][k];
+        if (nextPiece) nextPiece[k] = piece[from];
+        if (nextOrientation) nextOrientation[k] = (uint8_t)((orientation[from] + orbit->change[m][k]) % base);
+    }
+}
+
+// Coordinate move tables, built once per subgroup
+static bool buildMoveTables(const Subgroup* group, SubgroupOrbit* orbit) {
+    uint32_t permutations = 1;
+    for (int k = 2; k <= orbit->size; k++) permutations *= (uint32_t)k;
+    uint8_t piece[EDGE_COUNT], next[EDGE_COUNT];
+
+    if (orbit->size <= SUBGROUP_TABLE_PIECES) {
+        orbit->permutationMoves = malloc(sizeof(uint32_t) * permutations * (size_t)group->moveCount);
+        if (!orbit->permutationMoves) return false;
+        for (uint32_t p = 0; p < permutations; p++) {
+            permutationUnrank(p, orbit->size, 0, piece);
+            for (int m = 0; m < group->moveCount; m++) {
+                applyToOrbit(orbit, m, piece, NULL, next, NULL);
+                orbit->permutationMoves[p * (uint32_t)group->moveCount + (uint32_t)m] = permutationRank(next, orbit->size);
+            }
+        }
+    }
+
+    if (orbit->oriented) {
+        uint32_t orientations = orientationPower(orbit, orbit->size);
+        orbit->orientationMoves = malloc(sizeof(uint16_t) * orientations * (size_t)group->moveCount);
+        if (!orbit->orientationMoves) return false;
+        for (uint32_t q = 0; q < orientations; q++) {
+            unrankOrientation(orbit, q, piece);
+            for (int m = 0; m < group->moveCount; m++) {
+                applyToOrbit(orbit, m, NULL, piece, NULL, next);
+                orbit->orientationMoves[q * (uint32_t)group->moveCount + (uint32_t)m] = (uint16_t)rankOrientation(orbit, next);
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Set up the rank space and move tables of the subgroup generated by moves,
+ * tracking the corners, the edges or both. Returns false if there are no
+ * moves, the space does not fit in 64 bits or the tables cannot be
+ * allocated. Free with subgroupFree.
+ */
+bool subgroupInit(Subgroup* group, const Move* moves, int moveCount, SubgroupPieces pieces) {
+    memset(group, 0, sizeof(*group));
+    if (moveCount <= 0 || moveCount > MOVE_COUNT) return false;
+    memcpy(group->moves, moves, sizeof(Move) * (size_t)moveCount);
+    group->moveCount = moveCount;
+    group->pieces = pieces;
+
+    if (pieces & SUBGROUP_CORNERS) addOrbits(group, false);
+    if (pieces & SUBGROUP_EDGES) addOrbits(group, true);
+
+    // Every face turn permutes the corners and the edges with the same parity
+    if (pieces == SUBGROUP_ALL && group->orbitCount > 0) group->orbits[group->orbitCount - 1].halved = true;
+
+    group->size = 1;
+    for (int o = 0; o < group->orbitCount; o++) {
+        SubgroupOrbit* orbit = &group->orbits[o];
+        orbit->permutationCount = 1;
+        for (int k = 2; k <= orbit->size; k++) orbit->permutationCount *= (uint64_t)k;
+        if (orbit->halved) orbit->permutationCount /= 2;
+        int digits = orbit->oriented ? orbit->size - (orbit->implied ? 1 : 0) : 0;
+        orbit->orientationCount = orientationPower(orbit, digits);
+
+        uint64_t count = orbit->permutationCount * orbit->orientationCount;
+        if (group->size > UINT64_MAX / count || !buildMoveTables(group, orbit)) {
+            subgroupFree(group);
+            return false;
+        }
+        group->size *= count;
+    }
+    return true;
+}
+
+void subgroupFree(Subgroup* group) {
+    for (int o = 0; o < group->orbitCount; o++) {
+        free(group->orbits[o].permutationMoves);
+        free(group->orbits[o].orientationMoves);
+        group->orbits[o].permutationMoves = NULL;
+        group->orbits[o].orientationMoves = NULL;
+    }
+}
+
+// Parity of the permutation with this Lehmer rank: the parity of its digit sum
+static int lehmerParity(uint32_t rank, int n) {
+    int parity = 0;
+    for (uint32_t radix = 2; radix <= (uint32_t)n; radix++) {
+        parity ^= (int)(rank % radix) & 1;
+        rank /= radix;
+    }
+    return parity;
+}
+
+static uint64_t rankCoordinates(const Subgroup* group, const Coordinates* coordinates) {
+    uint64_t rank = 0;
+    for (int o = 0; o < group->orbitCount; o++) {
+        const SubgroupOrbit* orbit = &group->orbits[o];
+        uint32_t permutation = coordinates->permutation[o];
+        uint32_t orientation = coordinates->orientation[o];
+        if (orbit->halved) permutation >>= 1;
+        if (orbit->implied) orientation /= (uint32_t)orientationBase(orbit);
+        rank = (rank * orbit->permutationCount + permutation) * orbit->orientationCount + orientation;
+    }
+    return rank;
+}
+
+static void unrankCoordinates(const Subgroup* group, uint64_t rank, Coordinates* coordinates) {
+    int halved = -1, implied[2] = { -1, -1 };
+    int parity[2] = { 0, 0 }, sum[2] = { 0, 0 };
+
+    for (int o = group->orbitCount - 1; o >= 0; o--) {
+        const SubgroupOrbit* orbit = &group->orbits[o];
+        coordinates->orientation[o] = (uint32_t)(rank % orbit->orientationCount);
+        rank /= orbit->orientationCount;
+        coordinates->permutation[o] = (uint32_t)(rank % orbit->permutationCount);
+        rank /= orbit->permutationCount;
+
+        if (orbit->implied) implied[orbit->edges] = o;
+        else if (orbit->oriented) {
+            uint8_t orientation[EDGE_COUNT];
+            unrankOrientation(orbit, coordinates->orientation[o], orientation);
+            for (int k = 0; k < orbit->size; k++) sum[orbit->edges] += orientation[k];
+        }
+        if (orbit->halved) halved = o;
+        else parity[orbit->edges] ^= lehmerParity(coordinates->permutation[o], orbit->size);
+    }
+
+    for (int edges = 0; edges < 2; edges++) {
+        int o = implied[edges];
+        if (o < 0) continue;
+        const SubgroupOrbit* orbit = &group->orbits[o];
+        uint32_t base = (uint32_t)orientationBase(orbit);
+        uint32_t partial = coordinates->orientation[o];
+        for (uint32_t q = partial; q; q /= base) sum[edges] += (int)(q % base);
+        coordinates->orientation[o] = partial * base + (base - (uint32_t)sum[edges] % base) % base;
+    }
+
+    // Ranks 2k and 2k + 1 differ by a swap of the last two pieces
+    if (halved >= 0) {
+        const SubgroupOrbit* orbit = &group->orbits[halved];
+        uint32_t permutation = coordinates->permutation[halved] * 2;
+        if ((parity[orbit->edges] ^ lehmerParity(permutation, orbit->size)) != parity[!orbit->edges]) permutation++;
+        coordinates->permutation[halved] = permutation;
+    }
+}
+
+// The state must be in the subgroup
+uint64_t subgroupRank(const Subgroup* group, const CubeState* state) {
+    Coordinates coordinates;
+    for (int o = 0; o < group->orbitCount; o++) {
+        const SubgroupOrbit* orbit = &group->orbits[o];
+        uint8_t piece[EDGE_COUNT], orientation[EDGE_COUNT];
+        for (int k = 0; k < orbit->size; k++) {
+            int slot = orbit->slots[k];
+            piece[k] = orbit->edges ? group->orbitIndex[CORNER_COUNT + state->ep[slot]] : group->orbitIndex[state->cp[slot]];
+            orientation[k] = orbit->edges ? state->eo[slot] : state->co[slot];
+        }
+        coordinates.permutation[o] = permutationRank(piece, orbit->size);
+        coordinates.orientation[o] = orbit->oriented ? rankOrientation(orbit, orientation) : 0;
+    }
+    return rankCoordinates(group, &coordinates);
+}
+
+// Inverse of subgroupRank; slots outside the orbits are left solved
+void subgroupUnrank(const Subgroup* group, uint64_t rank, CubeState* state) {
+    Coordinates coordinates;
+    unrankCoordinates(group, rank, &coordinates);
+    cubeStateInit(state);
+    for (int o = 0; o < group->orbitCount; o++) {
+        const SubgroupOrbit* orbit = &group->orbits[o];
+        uint8_t* perm = orbit->edges ? state->ep : state->cp;
+        uint8_t* orientation = orbit->edges ? state->eo : state->co;
+        uint8_t piece[EDGE_COUNT], twist[EDGE_COUNT] = { 0 };
+        permutationUnrank(coordinates.permutation[o], orbit->size, 0, piece);
+        if (orbit->oriented) unrankOrientation(orbit, coordinates.orientation[o], twist);
+        for (int k = 0; k < orbit->size; k++) {
+            perm[orbit->slots[k]] = orbit->slots[piece[k]];
+            orientation[orbit->slots[k]] = twist[k];
+        }
+    }
+}
+
+// Claim an unseen position for the next layer; true if this call claimed it
+static bool claim(Layer* layer, uint64_t rank) {
+    _Atomic uint64_t* word = &layer->words[rank / POSITIONS_PER_WORD];
+    int shift = (int)(rank % POSITIONS_PER_WORD) * 2;
+    uint64_t value = atomic_load_explicit(word, memory_order_relaxed);
+    while (((value >> shift) & 3) == UNSEEN) {
+        if (atomic_compare_exchange_weak_explicit(word, &value, value | layer->next << shift,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Generator m applied to a position; orbits without a table go through their pieces
+static void applyMove(const Subgroup* group, const Coordinates* position, uint8_t pieces[][EDGE_COUNT], int m,
+                      Coordinates* result) {
+    uint32_t moveCount = (uint32_t)group->moveCount;
+    for (int o = 0; o < group->orbitCount; o++) {
+        const SubgroupOrbit* orbit = &group->orbits[o];
+        if (orbit->permutationMoves) {
+            result->permutation[o] = orbit->permutationMoves[position->permutation[o] * moveCount + (uint32_t)m];
+        } else {
+            uint8_t next[EDGE_COUNT];
+            applyToOrbit(orbit, m, pieces[o], NULL, next, NULL);
+            result->permutation[o] = permutationRank(next, orbit->size);
+        }
+        result->orientation[o] = orbit->oriented
+            ? orbit->orientationMoves[position->orientation[o] * moveCount + (uint32_t)m] : 0;
+    }
+}
+
+static void expandChunk(void* arg, int worker) {
+    (void)worker;
+    LayerTask* task = arg;
+    Layer* layer = task->layer;
+    const Subgroup* group = layer->group;
+    uint64_t pattern = layer->current * EVEN_BITS;
+    uint64_t found = 0;
+
+    for (uint64_t w = task->begin; w < task->end; w++) {
+        uint64_t value = atomic_load_explicit(&layer->words[w], memory_order_relaxed) ^ pattern;
+        uint64_t matches = ~(value | value >> 1) & EVEN_BITS;
+        if (!matches) continue;
+
+        // Only this task touches this layer's positions in the word, so they retire in one go
+        atomic_fetch_or_explicit(&layer->words[w], matches * DONE, memory_order_relaxed);
+        for (; matches; matches &= matches - 1) {
+            uint64_t rank = w * POSITIONS_PER_WORD + (uint64_t)__builtin_ctzll(matches) / 2;
+            Coordinates position, next;
+            uint8_t pieces[SUBGROUP_MAX_ORBITS][EDGE_COUNT];
+            unrankCoordinates(group, rank, &position);
+            for (int o = 0; o < group->orbitCount; o++) {
+                if (!group->orbits[o].permutationMoves) {
+                    permutationUnrank(position.permutation[o], group->orbits[o].size, 0, pieces[o]);
+                }
+            }
+            for (int m = 0; m < group->moveCount; m++) {
+                applyMove(group, &position, pieces, m, &next);
+                if (claim(layer, rankCoordinates(group, &next))) found++;
+            }
+        }
+    }
+    atomic_fetch_add_explicit(&layer->found, found, memory_order_relaxed);
+}
+
+/**
+ * Count the positions of the subgroup at each distance from solved, one
+ * layer at a time on pool (or the calling thread if pool is NULL), which
+ * must not be running anything else meanwhile. Returns false if the visited
+ * set cannot be allocated or the depth passes SUBGROUP_MAX_DEPTH.
+ */
+bool subgroupEnumerate(const Subgroup* group, WorkPool* pool, SubgroupStats* stats) {
+    double start = clockSeconds();
+    memset(stats, 0, sizeof(*stats));
+
+    Layer layer;
+    layer.group = group;
+    layer.wordCount = (group->size + POSITIONS_PER_WORD - 1) / POSITIONS_PER_WORD;
+    layer.words = calloc(layer.wordCount, sizeof(uint64_t));
+    size_t taskCount = (size_t)((layer.wordCount + CHUNK_WORDS - 1) / CHUNK_WORDS);
+    LayerTask* tasks = malloc(sizeof(LayerTask) * taskCount);
+    if (!layer.words || !tasks) {
+        free((void*)layer.words);
+        free(tasks);
+        return false;
+    }
+    for (size_t t = 0; t < taskCount; t++) {
+        tasks[t].layer = &layer;
+        tasks[t].begin = t * CHUNK_WORDS;
+        tasks[t].end = t + 1 < taskCount ? (t + 1) * CHUNK_WORDS : layer.wordCount;
+    }
+
+    CubeState solved;
+    cubeStateInit(&solved);
+    uint64_t root = subgroupRank(group, &solved);
+    layer.words[root / POSITIONS_PER_WORD] = (uint64_t)LAYER_A << (root % POSITIONS_PER_WORD * 2);
+    layer.current = LAYER_A;
+    layer.next = LAYER_B;
+    stats->counts[0] = stats->total = 1;
+
+    bool complete = false;
+    for (int depth = 0; depth < SUBGROUP_MAX_DEPTH; depth++) {
+        atomic_init(&layer.found, 0);
+        for (size_t t = 0; t < taskCount; t++) {
+            if (!pool || !workPoolSubmit(pool, expandChunk, &tasks[t])) expandChunk(&tasks[t], -1);
+        }
+        if (pool) workPoolWait(pool);
+
+        uint64_t found = atomic_load(&layer.found);
+        if (found == 0) {
+            complete = true;
+            break;
+        }
+        stats->counts[depth + 1] = found;
+        stats->total += found;
+        stats->depth = depth + 1;
+
+        uint64_t swap = layer.current;
+        layer.current = layer.next;
+        layer.next = swap;
+    }
+
+    stats->seconds = clockSeconds() - start;
+    free((void*)layer.words);
+    free(tasks);
+    return complete;
+}
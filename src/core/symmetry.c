@@ -0,0 +1,295 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "facelets.h"
+#include "symmetry.h"
+
+#define UNASSIGNED UINT32_MAX
+
+static const int8_t faceNormal[FACE_COUNT][3] = {
+    {0, 0, 1}, {0, 0, -1}, {-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0},
+};
+
+static const uint8_t axisOrders[6][3] = {
+    {0, 1, 2}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0},
+};
+
+static pthread_once_t tablesOnce = PTHREAD_ONCE_INIT;
+static int8_t matrices[SYMMETRY_COUNT][3][3];
+static Symmetry symmetries[SYMMETRY_COUNT];
+static uint8_t multiplyTable[SYMMETRY_COUNT][SYMMETRY_COUNT];
+static uint8_t inverseTable[SYMMETRY_COUNT];
+static uint8_t moveConjugate[SYMMETRY_COUNT][MOVE_COUNT];
+
+// twistMap[s][slot][corner][twist]: the twist corner ends up with, sitting in slot, after s
+static uint8_t twistMap[SYMMETRY_COUNT][CORNER_COUNT][CORNER_COUNT][3];
+
+static void buildMatrix(int sym, int8_t matrix[3][3]) {
+    memset(matrix, 0, sizeof(int8_t) * 9);
+    for (int row = 0; row < 3; row++) {
+        matrix[row][axisOrders[sym / 8][row]] = (int8_t)((sym >> row) & 1 ? -1 : 1);
+    }
+}
+
+static int determinant(int8_t m[3][3]) {
+    return m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1])
+         - m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0])
+         + m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+}
+
+static void transform(int8_t m[3][3], const int* v, int* result) {
+    for (int row = 0; row < 3; row++) {
+        result[row] = m[row][0] * v[0] + m[row][1] * v[1] + m[row][2] * v[2];
+    }
+}
+
+// Facelet centre in half-cubie units: twice the cubie position plus the face normal
+static void faceletPoint(int facelet, int point[3]) {
+    int position[3];
+    faceletPosition(facelet, position);
+    FaceID face = faceletFace(facelet);
+    for (int axis = 0; axis < 3; axis++) point[axis] = 2 * position[axis] + faceNormal[face][axis];
+}
+
+static int faceletAt(const int point[3]) {
+    for (int i = 0; i < FACELET_COUNT; i++) {
+        int other[3];
+        faceletPoint(i, other);
+        if (other[0] == point[0] && other[1] == point[1] && other[2] == point[2]) return i;
+    }
+    return -1;
+}
+
+static int faceWithNormal(const int normal[3]) {
+    for (int face = 0; face < FACE_COUNT; face++) {
+        if (faceNormal[face][0] == normal[0] && faceNormal[face][1] == normal[1] && faceNormal[face][2] == normal[2]) {
+            return face;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Read each symmetry's slot and orientation maps off the facelets: where
+ * the reference (first) facelet of each slot lands names the new slot and
+ * the orientation offset.
+ */
+static void buildSymmetry(int sym) {
+    Symmetry* s = &symmetries[sym];
+    int8_t (*m)[3] = matrices[sym];
+    buildMatrix(sym, m);
+    s->mirror = determinant(m) < 0;
+
+    uint8_t facelet[FACELET_COUNT];
+    for (int i = 0; i < FACELET_COUNT; i++) {
+        int point[3], moved[3];
+        faceletPoint(i, point);
+        transform(m, point, moved);
+        facelet[i] = (uint8_t)faceletAt(moved);
+    }
+    for (int face = 0; face < FACE_COUNT; face++) {
+        int normal[3] = {faceNormal[face][0], faceNormal[face][1], faceNormal[face][2]}, moved[3];
+        transform(m, normal, moved);
+        s->face[face] = (uint8_t)faceWithNormal(moved);
+    }
+
+    for (int i = 0; i < CORNER_COUNT; i++) {
+        uint8_t target = facelet[cornerFacelet[i][0]];
+        for (int j = 0; j < CORNER_COUNT; j++) {
+            for (int k = 0; k < 3; k++) {
+                if (cornerFacelet[j][k] == target) {
+                    s->cornerSlot[i] = (uint8_t)j;
+                    s->cornerTwist[i] = (uint8_t)k;
+                }
+            }
+        }
+    }
+    for (int i = 0; i < EDGE_COUNT; i++) {
+        uint8_t target = facelet[edgeFacelet[i][0]];
+        for (int j = 0; j < EDGE_COUNT; j++) {
+            for (int k = 0; k < 2; k++) {
+                if (edgeFacelet[j][k] == target) {
+                    s->edgeSlot[i] = (uint8_t)j;
+                    s->edgeFlip[i] = (uint8_t)k;
+                }
+            }
+        }
+    }
+
+    // A corner twisted by t in slot i shows up in slot i' twisted by
+    // offset(i) - offset(corner) + t, with t negated by a mirror
+    for (int slot = 0; slot < CORNER_COUNT; slot++) {
+        for (int corner = 0; corner < CORNER_COUNT; corner++) {
+            for (int t = 0; t < 3; t++) {
+                int twist = s->cornerTwist[slot] + 3 - s->cornerTwist[corner] + (s->mirror ? 3 - t : t);
+                twistMap[sym][slot][corner][t] = (uint8_t)(twist % 3);
+            }
+        }
+    }
+
+    for (int move = 0; move < MOVE_COUNT; move++) {
+        int turns = moveQuarterTurns((Move)move);
+        moveConjugate[sym][move] = (uint8_t)moveFromFace((FaceID)s->face[moveFace((Move)move)], s->mirror ? 4 - turns : turns);
+    }
+}
+
+static void buildTables(void) {
+    for (int sym = 0; sym < SYMMETRY_COUNT; sym++) buildSymmetry(sym);
+
+    for (int a = 0; a < SYMMETRY_COUNT; a++) {
+        for (int b = 0; b < SYMMETRY_COUNT; b++) {
+            int8_t product[3][3];
+            for (int row = 0; row < 3; row++) {
+                for (int col = 0; col < 3; col++) {
+                    product[row][col] = (int8_t)(matrices[a][row][0] * matrices[b][0][col]
+                                               + matrices[a][row][1] * matrices[b][1][col]
+                                               + matrices[a][row][2] * matrices[b][2][col]);
+                }
+            }
+            for (int c = 0; c < SYMMETRY_COUNT; c++) {
+                if (memcmp(product, matrices[c], sizeof(product)) == 0) multiplyTable[a][b] = (uint8_t)c;
+            }
+            if (multiplyTable[a][b] == SYMMETRY_IDENTITY) inverseTable[a] = (uint8_t)b;
+        }
+    }
+}
+
+static void ensureTables(void) {
+    pthread_once(&tablesOnce, buildTables);
+}
+
+const Symmetry* symmetryGet(int sym) {
+    ensureTables();
+    return &symmetries[sym];
+}
+
+// a after b: conjugating by the product is conjugating by b, then by a
+int symmetryMultiply(int a, int b) {
+    ensureTables();
+    return multiplyTable[a][b];
+}
+
+int symmetryInverse(int sym) {
+    ensureTables();
+    return inverseTable[sym];
+}
+
+// The move that plays the role of move in a conjugated state
+Move symmetryMove(int sym, Move move) {
+    ensureTables();
+    return (Move)moveConjugate[sym][move];
+}
+
+// Corners only: the edges of result are left as they were
+void cubeStateConjugateCorners(const CubeState* state, int sym, CubeState* result) {
+    ensureTables();
+    const Symmetry* s = &symmetries[sym];
+    uint8_t cp[CORNER_COUNT], co[CORNER_COUNT];
+    for (int i = 0; i < CORNER_COUNT; i++) {
+        cp[s->cornerSlot[i]] = s->cornerSlot[state->cp[i]];
+        co[s->cornerSlot[i]] = twistMap[sym][i][state->cp[i]][state->co[i]];
+    }
+    memcpy(result->cp, cp, sizeof(cp));
+    memcpy(result->co, co, sizeof(co));
+}
+
+// s X s^-1; result may alias state
+void cubeStateConjugate(const CubeState* state, int sym, CubeState* result) {
+    ensureTables();
+    const Symmetry* s = &symmetries[sym];
+    CubeState out;
+    for (int i = 0; i < CORNER_COUNT; i++) {
+        out.cp[s->cornerSlot[i]] = s->cornerSlot[state->cp[i]];
+        out.co[s->cornerSlot[i]] = twistMap[sym][i][state->cp[i]][state->co[i]];
+    }
+    for (int i = 0; i < EDGE_COUNT; i++) {
+        out.ep[s->edgeSlot[i]] = s->edgeSlot[state->ep[i]];
+        out.eo[s->edgeSlot[i]] = s->edgeFlip[i] ^ s->edgeFlip[state->ep[i]] ^ state->eo[i];
+    }
+    *result = out;
+}
+
+/**
+ * The smallest (bytewise) of the state's 48 conjugates, and with
+ * antisymmetry also of its inverse's. Equivalent states give the same
+ * representative. Returns the symmetry used, plus SYMMETRY_COUNT if the
+ * inverse was conjugated.
+ */
+int cubeStateCanonical(const CubeState* state, bool antisymmetry, CubeState* canonical) {
+    CubeState sources[2], best = *state, candidate;
+    sources[0] = *state;
+    if (antisymmetry) cubeStateInverse(state, &sources[1]);
+
+    int bestSym = SYMMETRY_IDENTITY;
+    for (int inverted = 0; inverted < (antisymmetry ? 2 : 1); inverted++) {
+        for (int sym = 0; sym < SYMMETRY_COUNT; sym++) {
+            cubeStateConjugate(&sources[inverted], sym, &candidate);
+            if (memcmp(&candidate, &best, sizeof(CubeState)) < 0) {
+                best = candidate;
+                bestSym = sym + inverted * SYMMETRY_COUNT;
+            }
+        }
+    }
+    *canonical = best;
+    return bestSym;
+}
+
+// Bit s is set if conjugating by s leaves the state unchanged
+uint64_t cubeStateSymmetries(const CubeState* state) {
+    uint64_t mask = 0;
+    for (int sym = 0; sym < SYMMETRY_COUNT; sym++) {
+        CubeState conjugate;
+        cubeStateConjugate(state, sym, &conjugate);
+        if (cubeStateEquals(&conjugate, state)) mask |= 1ull << sym;
+    }
+    return mask;
+}
+
+/**
+ * Partition 0..rawCount-1 into classes under all 48 symmetries, walking raw
+ * values in order so each class is numbered, and represented, by its
+ * smallest member. conjugate must map the coordinate onto itself.
+ */
+bool symmetryClassesBuild(SymmetryClasses* classes, uint32_t rawCount, SymmetryConjugate conjugate, const void* context) {
+    ensureTables();
+    memset(classes, 0, sizeof(*classes));
+    classes->classOf = malloc(sizeof(uint32_t) * rawCount);
+    classes->symmetry = malloc(rawCount);
+    classes->representative = malloc(sizeof(uint32_t) * rawCount);
+    classes->stabilizer = malloc(sizeof(uint64_t) * rawCount);
+    if (!classes->classOf || !classes->symmetry || !classes->representative || !classes->stabilizer) {
+        symmetryClassesFree(classes);
+        return false;
+    }
+
+    memset(classes->classOf, 0xff, sizeof(uint32_t) * rawCount);
+    for (uint32_t raw = 0; raw < rawCount; raw++) {
+        if (classes->classOf[raw] != UNASSIGNED) continue;
+
+        uint32_t class = classes->count++;
+        classes->representative[class] = raw;
+        classes->stabilizer[class] = 0;
+        for (int sym = 0; sym < SYMMETRY_COUNT; sym++) {
+            uint32_t other = conjugate(raw, sym, context);
+            if (other == raw) classes->stabilizer[class] |= 1ull << sym;
+            if (classes->classOf[other] == UNASSIGNED) {
+                classes->classOf[other] = class;
+                classes->symmetry[other] = inverseTable[sym];
+            }
+        }
+    }
+
+    uint32_t* shrunk = realloc(classes->representative, sizeof(uint32_t) * classes->count);
+    if (shrunk) classes->representative = shrunk;
+    uint64_t* stabilizers = realloc(classes->stabilizer, sizeof(uint64_t) * classes->count);
+    if (stabilizers) classes->stabilizer = stabilizers;
+    return true;
+}
+
+void symmetryClassesFree(SymmetryClasses* classes) {
+    free(classes->classOf);
+    free(classes->symmetry);
+    free(classes->representative);
+    free(classes->stabilizer);
+    memset(classes, 0, sizeof(*classes));
+}
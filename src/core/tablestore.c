@@ -0,0 +1,171 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "tablestore.h"
+
+static const char tableMagic[8] = {'R', 'U', 'B', 'I', 'K', 'T', 'B', 'L'};
+
+static size_t alignUp(size_t size) {
+    return (size + TABLE_STORE_ALIGN - 1) / TABLE_STORE_ALIGN * TABLE_STORE_ALIGN;
+}
+
+/**
+ * 64-bit multiply-xorshift hash, a word at a time. It can be fed in pieces
+ * as long as every piece but the last is a multiple of 8 bytes.
+ */
+uint64_t tableChecksum(uint64_t hash, const void* data, size_t size) {
+    const uint8_t* bytes = data;
+    size_t words = size / 8;
+    for (size_t i = 0; i < words; i++) {
+        uint64_t word;
+        memcpy(&word, bytes + i * 8, 8);
+        hash = (hash ^ word) * 0x9e3779b97f4a7c15ull;
+        hash ^= hash >> 29;
+    }
+    for (size_t i = words * 8; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+// Payload offset of a section, with every earlier section padded to TABLE_STORE_ALIGN
+size_t tableSectionOffset(const TableSection* sections, int index) {
+    size_t offset = 0;
+    for (int i = 0; i < index; i++) offset += alignUp(sections[i].size);
+    return offset;
+}
+
+static bool writeAll(int fd, const void* data, size_t size) {
+    const uint8_t* bytes = data;
+    while (size > 0) {
+        ssize_t written = write(fd, bytes, size);
+        if (written < 0) return false;
+        bytes += written;
+        size -= (size_t)written;
+    }
+    return true;
+}
+
+/**
+ * Write the sections as one table file. The data goes to a temporary file
+ * next to path, is flushed to disk and then renamed over path, so readers
+ * see either the old file or the complete new one.
+ */
+bool tableStoreWrite(const char* path, const char* name, uint64_t fingerprint, const TableSection* sections, int count) {
+    static const uint8_t padding[TABLE_STORE_ALIGN] = {0};
+
+    TableStoreHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, tableMagic, sizeof(tableMagic));
+    header.version = TABLE_STORE_VERSION;
+    header.headerSize = TABLE_STORE_HEADER_SIZE;
+    strncpy(header.name, name, TABLE_STORE_NAME_LENGTH - 1);
+    header.fingerprint = fingerprint;
+    header.payloadSize = tableSectionOffset(sections, count);
+    header.checksum = 0;
+    for (int i = 0; i < count; i++) {
+        // Hash each section as it sits in the file: the ragged end goes in
+        // padded out to a whole aligned block
+        size_t whole = sections[i].size / TABLE_STORE_ALIGN * TABLE_STORE_ALIGN;
+        header.checksum = tableChecksum(header.checksum, sections[i].data, whole);
+        if (whole < sections[i].size) {
+            uint8_t last[TABLE_STORE_ALIGN] = {0};
+            memcpy(last, (const uint8_t*)sections[i].data + whole, sections[i].size - whole);
+            header.checksum = tableChecksum(header.checksum, last, sizeof(last));
+        }
+    }
+
+    size_t length = strlen(path);
+    char* tempPath = malloc(length + 8);
+    if (!tempPath) return false;
+    memcpy(tempPath, path, length);
+    memcpy(tempPath + length, ".XXXXXX", 8);
+
+    int fd = mkstemp(tempPath);
+    if (fd < 0) {
+        fprintf(stderr, "Could not create %s\n", tempPath);
+        free(tempPath);
+        return false;
+    }
+
+    uint8_t headerPage[TABLE_STORE_HEADER_SIZE] = {0};
+    memcpy(headerPage, &header, sizeof(header));
+    bool ok = writeAll(fd, headerPage, sizeof(headerPage));
+    for (int i = 0; ok && i < count; i++) {
+        ok = writeAll(fd, sections[i].data, sections[i].size)
+          && writeAll(fd, padding, alignUp(sections[i].size) - sections[i].size);
+    }
+    ok = ok && fchmod(fd, 0644) == 0 && fsync(fd) == 0;
+    ok = close(fd) == 0 && ok;
+    ok = ok && rename(tempPath, path) == 0;
+
+    if (!ok) {
+        fprintf(stderr, "Could not write table file %s\n", path);
+        unlink(tempPath);
+    }
+    free(tempPath);
+    return ok;
+}
+
+/**
+ * Map a table file read-only and check that it holds the named table, built
+ * for this fingerprint, with the expected payload size (0 accepts whatever
+ * size the header records, for payloads that vary, like driver blobs). With
+ * TABLE_STORE_VERIFY the payload checksum is checked too. Returns false
+ * (quietly if the file does not exist) when the file is unusable.
+ */
+bool tableStoreOpen(const char* path, const char* name, uint64_t fingerprint, size_t payloadSize, int flags, TableStoreMap* map) {
+    memset(map, 0, sizeof(*map));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < TABLE_STORE_HEADER_SIZE) {
+        close(fd);
+        return false;
+    }
+
+    void* mapping = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) return false;
+
+    const TableStoreHeader* header = mapping;
+    const char* problem = NULL;
+    if (memcmp(header->magic, tableMagic, sizeof(tableMagic)) != 0) {
+        problem = "not a table file";
+    } else if (header->version != TABLE_STORE_VERSION || header->headerSize != TABLE_STORE_HEADER_SIZE) {
+        problem = "unsupported version";
+    } else if (strncmp(header->name, name, TABLE_STORE_NAME_LENGTH) != 0) {
+        problem = "holds a different table";
+    } else if (header->fingerprint != fingerprint) {
+        problem = "is out of date";
+    } else if ((payloadSize != 0 && header->payloadSize != payloadSize) ||
+               (size_t)info.st_size != TABLE_STORE_HEADER_SIZE + header->payloadSize) {
+        problem = "has the wrong size";
+    } else if ((flags & TABLE_STORE_VERIFY) &&
+               tableChecksum(0, (const uint8_t*)mapping + TABLE_STORE_HEADER_SIZE, header->payloadSize) != header->checksum) {
+        problem = "is corrupt";
+    }
+
+    if (problem) {
+        fprintf(stderr, "Table file %s %s\n", path, problem);
+        munmap(mapping, (size_t)info.st_size);
+        return false;
+    }
+
+    map->mapping = mapping;
+    map->mappingSize = (size_t)info.st_size;
+    map->data = (const uint8_t*)mapping + TABLE_STORE_HEADER_SIZE;
+    map->size = header->payloadSize;
+    return true;
+}
+
+void tableStoreClose(TableStoreMap* map) {
+    if (map->mapping) munmap(map->mapping, map->mappingSize);
+    memset(map, 0, sizeof(*map));
+}
@@ -0,0 +1,42 @@
+#include "triplebuffer.h"
+
+// The three slots must start out equivalent: the reader may see any of them before the first publish
+void tripleBufferInit(TripleBuffer* buffer, void* first, void* second, void* third) {
+    buffer->slots[0] = first;
+    buffer->slots[1] = second;
+    buffer->slots[2] = third;
+    buffer->back = 0;
+    atomic_init(&buffer->middle, 1);
+    buffer->front = 2;
+}
+
+// Writer side: the slot to fill next
+void* tripleBufferBack(TripleBuffer* buffer) {
+    return buffer->slots[buffer->back];
+}
+
+// Writer side: make the filled back slot the latest and take the old middle one as the new back
+void tripleBufferPublish(TripleBuffer* buffer) {
+    unsigned previous = atomic_exchange_explicit(&buffer->middle, buffer->back | TRIPLE_BUFFER_FRESH,
+                                                 memory_order_acq_rel);
+    buffer->back = previous & ~TRIPLE_BUFFER_FRESH;
+}
+
+/**
+ * Reader side: the newest published slot, valid until the next call. fresh,
+ * if not NULL, says whether it changed since the last call.
+ */
+void* tripleBufferLatest(TripleBuffer* buffer, bool* fresh) {
+    bool changed = atomic_load_explicit(&buffer->middle, memory_order_relaxed) & TRIPLE_BUFFER_FRESH;
+    if (changed) {
+        unsigned previous = atomic_exchange_explicit(&buffer->middle, buffer->front, memory_order_acq_rel);
+        buffer->front = previous & ~TRIPLE_BUFFER_FRESH;
+    }
+    if (fresh) *fresh = changed;
+    return buffer->slots[buffer->front];
+}
+
+// Reader side: whether tripleBufferLatest would return something newer, without taking it
+bool tripleBufferPending(TripleBuffer* buffer) {
+    return atomic_load_explicit(&buffer->middle, memory_order_relaxed) & TRIPLE_BUFFER_FRESH;
+}
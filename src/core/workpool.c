@@ -0,0 +1,206 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "workpool.h"
+
+#define MAX_THREADS 256
+#define INITIAL_DEQUE_CAPACITY 64
+
+// Which pool and worker the calling thread is, if any
+static _Thread_local WorkPool* currentPool = NULL;
+static _Thread_local int currentWorker = -1;
+
+typedef struct {
+    WorkPool* pool;
+    int worker;
+} WorkerStart;
+
+int workPoolDefaultThreads(void) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus < 1 ? 1 : cpus > MAX_THREADS ? MAX_THREADS : (int)cpus;
+}
+
+static bool dequePush(WorkDeque* deque, WorkItem item) {
+    pthread_mutex_lock(&deque->lock);
+    if (deque->tail - deque->head == deque->capacity) {
+        size_t capacity = deque->capacity * 2;
+        WorkItem* items = malloc(sizeof(WorkItem) * capacity);
+        if (!items) {
+            pthread_mutex_unlock(&deque->lock);
+            return false;
+        }
+        for (size_t i = deque->head; i < deque->tail; i++) {
+            items[i - deque->head] = deque->items[i % deque->capacity];
+        }
+        free(deque->items);
+        deque->items = items;
+        deque->tail -= deque->head;
+        deque->head = 0;
+        deque->capacity = capacity;
+    }
+    deque->items[deque->tail++ % deque->capacity] = item;
+    pthread_mutex_unlock(&deque->lock);
+    return true;
+}
+
+// The owner takes the newest item, thieves the oldest
+static bool dequeTake(WorkDeque* deque, bool newest, WorkItem* item) {
+    bool found = false;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->tail != deque->head) {
+        *item = newest ? deque->items[--deque->tail % deque->capacity] : deque->items[deque->head++ % deque->capacity];
+        found = true;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+
+static bool takeWork(WorkPool* pool, int worker, WorkItem* item) {
+    if (atomic_load(&pool->queued) == 0) return false;
+
+    bool found = dequeTake(&pool->deques[worker], true, item) || dequeTake(&pool->inbox, false, item);
+    for (int k = 1; !found && k < pool->threads; k++) {
+        found = dequeTake(&pool->deques[(worker + k) % pool->threads], false, item);
+    }
+    if (found) atomic_fetch_sub(&pool->queued, 1);
+    return found;
+}
+
+static void* workerMain(void* arg) {
+    WorkerStart* start = arg;
+    WorkPool* pool = start->pool;
+    int worker = start->worker;
+    free(start);
+
+    currentPool = pool;
+    currentWorker = worker;
+
+    for (;;) {
+        WorkItem item;
+        if (takeWork(pool, worker, &item)) {
+            atomic_fetch_sub(&pool->idle, 1);
+            item.function(item.arg, worker);
+            atomic_fetch_add(&pool->idle, 1);
+
+            if (atomic_fetch_sub(&pool->pending, 1) == 1) {
+                pthread_mutex_lock(&pool->lock);
+                pthread_cond_broadcast(&pool->allDone);
+                pthread_mutex_unlock(&pool->lock);
+            }
+            continue;
+        }
+
+        pthread_mutex_lock(&pool->lock);
+        while (!pool->stop && atomic_load(&pool->queued) == 0) {
+            pthread_cond_wait(&pool->workAvailable, &pool->lock);
+        }
+        bool stop = pool->stop && atomic_load(&pool->queued) == 0;
+        pthread_mutex_unlock(&pool->lock);
+        if (stop) return NULL;
+    }
+}
+
+// threads <= 0 starts one worker per online CPU
+bool workPoolInit(WorkPool* pool, int threads) {
+    if (threads <= 0) threads = workPoolDefaultThreads();
+    if (threads > MAX_THREADS) threads = MAX_THREADS;
+
+    memset(pool, 0, sizeof(*pool));
+    pool->handles = calloc((size_t)threads, sizeof(pthread_t));
+    pool->deques = calloc((size_t)threads, sizeof(WorkDeque));
+    if (!pool->handles || !pool->deques) {
+        free(pool->handles);
+        free(pool->deques);
+        return false;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->workAvailable, NULL);
+    pthread_cond_init(&pool->allDone, NULL);
+    atomic_init(&pool->queued, 0);
+    atomic_init(&pool->pending, 0);
+    atomic_init(&pool->idle, threads);
+
+    pthread_mutex_init(&pool->inbox.lock, NULL);
+    pool->inbox.capacity = INITIAL_DEQUE_CAPACITY;
+    pool->inbox.items = malloc(sizeof(WorkItem) * INITIAL_DEQUE_CAPACITY);
+    if (!pool->inbox.items) {
+        workPoolDestroy(pool);
+        return false;
+    }
+
+    // Each deque is set up along with its worker, so on a failure the first pool->threads are all there is to undo
+    for (int i = 0; i < threads; i++) {
+        WorkDeque* deque = &pool->deques[i];
+        pthread_mutex_init(&deque->lock, NULL);
+        deque->capacity = INITIAL_DEQUE_CAPACITY;
+        deque->items = malloc(sizeof(WorkItem) * INITIAL_DEQUE_CAPACITY);
+
+        WorkerStart* start = malloc(sizeof(WorkerStart));
+        if (!deque->items || !start || (start->pool = pool, start->worker = i,
+                pthread_create(&pool->handles[i], NULL, workerMain, start) != 0)) {
+            free(start);
+            free(deque->items);
+            pthread_mutex_destroy(&deque->lock);
+            workPoolDestroy(pool);
+            return false;
+        }
+        pool->threads = i + 1;
+    }
+    return true;
+}
+
+// Finishes every queued item, then stops the workers
+void workPoolDestroy(WorkPool* pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->workAvailable);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->threads; i++) {
+        pthread_join(pool->handles[i], NULL);
+    }
+    for (int i = 0; i < pool->threads; i++) {
+        free(pool->deques[i].items);
+        pthread_mutex_destroy(&pool->deques[i].lock);
+    }
+    free(pool->inbox.items);
+    pthread_mutex_destroy(&pool->inbox.lock);
+    free(pool->deques);
+    free(pool->handles);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->workAvailable);
+    pthread_cond_destroy(&pool->allDone);
+    memset(pool, 0, sizeof(*pool));
+}
+
+bool workPoolSubmit(WorkPool* pool, WorkFunction function, void* arg) {
+    WorkDeque* deque = currentPool == pool ? &pool->deques[currentWorker] : &pool->inbox;
+
+    atomic_fetch_add(&pool->pending, 1);
+    if (!dequePush(deque, (WorkItem){function, arg})) {
+        atomic_fetch_sub(&pool->pending, 1);
+        return false;
+    }
+    atomic_fetch_add(&pool->queued, 1);
+
+    pthread_mutex_lock(&pool->lock);
+    pthread_cond_signal(&pool->workAvailable);
+    pthread_mutex_unlock(&pool->lock);
+    return true;
+}
+
+// Block until every submitted item (including ones submitted by items) has finished
+void workPoolWait(WorkPool* pool) {
+    pthread_mutex_lock(&pool->lock);
+    while (atomic_load(&pool->pending) > 0) {
+        pthread_cond_wait(&pool->allDone, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+// True when some worker has nothing to do and nothing is queued for it
+bool workPoolHungry(WorkPool* pool) {
+    return (size_t)atomic_load_explicit(&pool->idle, memory_order_relaxed)
+         > atomic_load_explicit(&pool->queued, memory_order_relaxed);
+}
@@ -1,302 +1,268 @@
+#include <stdlib.h>
 #include <string.h>
 #include "main.h"
+#include "algorithm.h"
+#include "facelets.h"
+#include "simulation.h"
 
-void initCubelets(State* state) {
-    vec3 colors[6] = {
-        {1.0f, 0.0f, 0.0f},   // Front (Red)
-        {1.0f, 0.5f, 0.0f},   // Back (Orange)
-        {0.0f, 1.0f, 0.0f},   // Left (Green)
-        {0.0f, 0.0f, 1.0f},   // Right (Blue)
-        {1.0f, 1.0f, 1.0f},   // Bottom (White)
-        {1.0f, 1.0f, 0.0f}    // Top (Yellow)
-    };
+bool initCubelets(State* state, int size) {
+    Cube* cube = state->cube;
+    if (!bigCubeInit(&cube->state, size)) {
+        fprintf(stderr, "Unsupported cube size %d (%d to %d)\n", size, BIGCUBE_MIN_SIZE, BIGCUBE_MAX_SIZE);
+        return false;
+    }
 
-    int index = 0;
-    for (float x = -1.0f; x <= 1.0f; x += 1.0f) {
-        for (float y = -1.0f; y <= 1.0f; y += 1.0f) {
-            for (float z = -1.0f; z <= 1.0f; z += 1.0f) {
-                Cubelet* cubelet = &state->cube->cubelets[index];
-                glm_vec3_copy((vec3){x, y, z}, cubelet->position);
-                glm_vec3_zero(cubelet->rotating_angle);
+    cube->size = size;
+    cube->isRotating = false;
+    cube->rotation_progress = 0.0f;
+    cube->turn_duration = DEFAULT_TURN_DURATION;
+    moveQueueInit(&cube->queue);
 
-               for (int i = 0; i < 6; i++) {
-                    // Default to dark gray for internal faces instead of black
-                    glm_vec3_copy((vec3){0.2f, 0.2f, 0.2f}, cubelet->face_colors[i]);
-                }
+    state->layerDepth = 0;
+    state->stickersDirty = true;
+    state->solver = NULL;
+    state->recorder = NULL;
+    state->replay = NULL;
+    state->simulation = NULL;
+    return true;
+}
 
-                // Apply colors based on initial position
-                if (z == 1.0f) glm_vec3_copy(colors[0], cubelet->face_colors[0]);  // Front
-                if (z == -1.0f) glm_vec3_copy(colors[1], cubelet->face_colors[1]); // Back
-                if (x == -1.0f) glm_vec3_copy(colors[2], cubelet->face_colors[2]); // Left
-                if (x == 1.0f) glm_vec3_copy(colors[3], cubelet->face_colors[3]);  // Right
-                if (y == -1.0f) glm_vec3_copy(colors[4], cubelet->face_colors[4]); // Bottom
-                if (y == 1.0f) glm_vec3_copy(colors[5], cubelet->face_colors[5]);  // Top
-                index++;
-            }
-        }
+void destroyCubelets(State* state) {
+    bigCubeFree(&state->cube->state);
+    if (state->solver) {
+        solverFree(state->solver);
+        free(state->solver);
+    }
+    if (state->recorder) {
+        if (!moveLogWriterClose(state->recorder)) fprintf(stderr, "The move log is incomplete\n");
+        free(state->recorder);
+    }
+    if (state->replay) {
+        moveLogClose(state->replay);
+        free(state->replay);
     }
-
-    state->cube->cubeCount = CUBELET_COUNT;
-    state->cube->isRotating = false;
 }
 
-void updateCubelets(State* state) {
-    if (state->cube->isRotating) {
-        const float rotation_speed = glm_rad(10.0f);  // Degrees per frame
-        const float target_rotation = glm_rad(90.0f); // Total target rotation
-        
-        // Calculate incremental rotation step
-        float rotation_step = fmin(rotation_speed, target_rotation - state->cube->rotation_progress);
-        
-        // Determine rotation direction
-        float sign = state->cube->rotating_clockwise ? 1.0f : -1.0f;
-        float actual_rotation = sign * rotation_step;
+static uint64_t elapsedMilliseconds(Uint64 since) {
+    return (uint64_t)((double)(SDL_GetPerformanceCounter() - since) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+}
 
-        // Calculate axis index (0=X, 1=Y, 2=Z) from rotation axis
-        int axis_index = (state->cube->rotating_axis[0] != 0.0f) ? 0 : 
-                        (state->cube->rotating_axis[1] != 0.0f) ? 1 : 2;
-        
-        // Determine which face we're rotating (1.0 or -1.0 along the axis)
-        float face_coord = state->cube->rotating_axis[axis_index] > 0 ? 1.0f : -1.0f;
+// Start animating a move popped off the queue
+static void beginTurn(State* state, LayerMove move) {
+    Cube* cube = state->cube;
 
-        // Update rotating angles for affected cubelets
-        for (int i = 0; i < CUBELET_COUNT; i++) {
-            Cubelet* cubelet = &state->cube->cubelets[i];
-            // Use more precise comparison and check if cubelet is part of rotating face
-            if (fabs(cubelet->position[axis_index] - face_coord) < 0.1f) {
-                vec3 rotation_step_vec;
-                glm_vec3_copy(state->cube->rotating_axis, rotation_step_vec);
-                glm_vec3_scale(rotation_step_vec, actual_rotation, rotation_step_vec);
-                glm_vec3_add(cubelet->rotating_angle, rotation_step_vec, cubelet->rotating_angle);
-            }
-        }
+    // Clockwise seen from the +axis end is a negative angle about it
+    cube->rotating_target = move.turns == 3 ? glm_rad(90.0f) : glm_rad(-90.0f) * move.turns;
+    cube->rotating_move = move;
+    cube->rotation_progress = 0.0f;
+    cube->isRotating = true;
+}
 
-        state->cube->rotation_progress += rotation_step;
+/**
+ * Advance the current turn by one simulation step of seconds, and start the
+ * next queued move once it lands. With moves waiting the turn in flight
+ * speeds up (up to 4x) so a burst of input drains quickly. The renderer
+ * reads the angle off rotation_progress, so only the landing turn touches
+ * the stickers, and only the slice's own. Simulation thread only.
+ */
+void updateCubelets(State* state, float seconds) {
+    Cube* cube = state->cube;
 
-        // Finalize rotation when complete
-        if (state->cube->rotation_progress >= target_rotation - 0.001f) {  // Small epsilon for floating point
-            // Create rotation matrix for the final 90-degree snap
-            mat4 rotation_matrix;
-            glm_mat4_identity(rotation_matrix);
-            float final_angle = state->cube->rotating_clockwise ? glm_rad(90.0f) : glm_rad(-90.0f);
-            glm_rotate(rotation_matrix, final_angle, state->cube->rotating_axis);
+    if (!cube->isRotating) {
+        LayerMove move;
+        if (!moveQueuePopCoalesced(&cube->queue, &move)) return;
+        beginTurn(state, move);
+    }
 
-            // Store original positions to avoid floating point drift
-            vec3 original_positions[CUBELET_COUNT];
-            for (int i = 0; i < CUBELET_COUNT; i++) {
-                glm_vec3_copy(state->cube->cubelets[i].position, original_positions[i]);
-            }
+    size_t backlog = moveQueueSize(&cube->queue);
+    float duration = cube->turn_duration / (float)(backlog < 3 ? backlog + 1 : 4);
+    cube->rotation_progress = duration > 0.0f ? fminf(cube->rotation_progress + seconds / duration, 1.0f) : 1.0f;
 
-            for (int i = 0; i < CUBELET_COUNT; i++) {
-                Cubelet* cubelet = &state->cube->cubelets[i];
-                if (fabs(original_positions[i][axis_index] - face_coord) < 0.1f) {
-                    // Apply rotation to position
-                    vec4 pos = {original_positions[i][0], original_positions[i][1], original_positions[i][2], 1.0f};
-                    glm_mat4_mulv(rotation_matrix, pos, pos);
-                    
-                    // Snap to exact grid positions to avoid floating point drift
-                    cubelet->position[0] = roundf(pos[0]);
-                    cubelet->position[1] = roundf(pos[1]); 
-                    cubelet->position[2] = roundf(pos[2]);
-                    
-                    // Update face colors
-                    rotateFaceColors(cubelet, state->cube->rotating_axis, state->cube->rotating_clockwise);
-                    
-                    // Reset rotation state
-                    glm_vec3_zero(cubelet->rotating_angle);
-                }
-            }
+    // Finalize rotation when complete
+    if (cube->rotation_progress >= 1.0f) {
+        bigCubeApplyMove(&cube->state, cube->rotating_move);
+        state->stickersDirty = true;
 
-            // End rotation
-            state->cube->isRotating = false;
-            state->cube->rotation_progress = 0.0f;  // Reset for next rotation
-        }
+        // End rotation
+        cube->isRotating = false;
+        cube->rotation_progress = 0.0f;  // Reset for next rotation
     }
 }
 
-void updateCubelet(State* state) {
-    if (state->cube->isRotating) {
-        const float rotation_speed = glm_rad(5.0f);  // Degrees per frame
-        const float target_rotation = glm_rad(90.0f); // Total target rotation
-        
-        // Calculate incremental rotation step
-        float rotation_step = fmin(rotation_speed, target_rotation - state->cube->rotation_progress);
-        
-        // Determine rotation direction
-        float sign = state->cube->rotating_clockwise ? 1.0f : -1.0f;
-        float actual_rotation = sign * rotation_step;
+// Queue a slice turn for animation (and the move log); never blocks and never waits for the current turn
+bool queueLayerMove(State* state, LayerMove move) {
+    if (!moveQueuePush(&state->cube->queue, move)) {
+        fprintf(stderr, "Move queue full, dropping turn of layer %d on axis %d\n", move.layer, move.axis);
+        return false;
+    }
+    if (state->recorder) moveLogWriterAppend(state->recorder, move, elapsedMilliseconds(0));
+    return true;
+}
 
-        // Calculate axis index (0=X, 1=Y, 2=Z) from rotation axis
-        int axis_index = (state->cube->rotating_axis[0] != 0.0f) ? 0 : 
-                        (state->cube->rotating_axis[1] != 0.0f) ? 1 : 2;
-        
-        // Determine which face we're rotating (1.0 or -1.0 along the axis)
-        float face_coord = state->cube->rotating_axis[axis_index] > 0 ? 1.0f : -1.0f;
+// Queue a 3x3 face move; on bigger cubes it turns the outer layer
+bool queueMove(State* state, Move move) {
+    return queueLayerMove(state, layerMoveFromMove(state->cube->size, move));
+}
 
-        // Update rotating angles for affected cubelets
-        for (int i = 0; i < CUBELET_COUNT; i++) {
-            Cubelet* cubelet = &state->cube->cubelets[i];
-            if (fabs(cubelet->position[axis_index] - face_coord) < 0.01f) {
-                vec3 rotation_step_vec;
-                glm_vec3_copy(state->cube->rotating_axis, rotation_step_vec);
-                glm_vec3_scale(rotation_step_vec, actual_rotation, rotation_step_vec);
-                glm_vec3_add(cubelet->rotating_angle, rotation_step_vec, cubelet->rotating_angle);
-            }
-        }
+/**
+ * Turn the slice depth layers in from a face (1 = the face itself). The
+ * layer turns +90 degrees about the face's outward axis when "clockwise",
+ * which is counter-clockwise seen from outside: X'
+ */
+void startLayerRotation(State* state, int face_index, int depth, bool clockwise) {
+    if (face_index < 0 || face_index >= FACE_COUNT) return;
+    if (depth < 1 || depth > state->cube->size) return;
 
-        state->cube->rotation_progress += rotation_step;
+    queueLayerMove(state, layerMoveFromFace(state->cube->size, (FaceID)face_index, depth, clockwise ? 3 : 1));
+}
 
-        // Finalize rotation when complete
-        if (state->cube->rotation_progress >= target_rotation) {
-            mat4 rotation_matrix;
-            glm_mat4_identity(rotation_matrix);
-            float final_angle = state->cube->rotating_clockwise ? glm_rad(90.0f) : glm_rad(-90.0f);
-            glm_rotate(rotation_matrix, final_angle, state->cube->rotating_axis);
+void startFaceRotation(State* state, int face_index, bool clockwise) {
+    startLayerRotation(state, face_index, 1, clockwise);
+}
 
-            for (int i = 0; i < CUBELET_COUNT; i++) {
-                Cubelet* cubelet = &state->cube->cubelets[i];
-                if (fabs(cubelet->position[axis_index] - face_coord) < 0.01f) {
-                    // Update position
-                    vec4 pos = {cubelet->position[0], cubelet->position[1], cubelet->position[2], 1.0f};
-                    glm_mat4_mulv(rotation_matrix, pos, pos);
-                    glm_vec4_copy3(pos, cubelet->position);
-                    
-                    // Update face colors
-                    rotateFaceColors(cubelet, state->cube->rotating_axis, state->cube->rotating_clockwise);
-                    
-                    // Reset rotation state
-                    glm_vec3_zero(cubelet->rotating_angle);
-                }
-            }
+/**
+ * Solve the cube as shown and queue the solution for playback. Only a 3x3x3
+ * at rest can be solved: its stickers are exactly a FaceletCube. The solver
+ * tables are built the first time round. Runs on the main thread, off the
+ * latest snapshot, so the simulation keeps ticking meanwhile.
+ */
+void solveCube(State* state) {
+    if (state->cube->size != 3) {
+        fprintf(stderr, "The solver only handles the 3x3x3 cube\n");
+        return;
+    }
+    const CubeSnapshot* snapshot = latestSnapshot(state);
+    if (!snapshotSettled(state, snapshot)) {
+        fprintf(stderr, "Wait for the current turns to finish before solving\n");
+        return;
+    }
 
-            // End rotation
-            state->cube->isRotating = false;
+    if (!state->solver) {
+        state->solver = malloc(sizeof(Solver));
+        if (!state->solver || !solverInitCached(state->solver, SOLVER_TABLE_PATH, 0)) {
+            fprintf(stderr, "Failed to build the solver tables\n");
+            free(state->solver);
+            state->solver = NULL;
+            return;
         }
     }
-}
 
-void startFaceRotation(State* state, int face_index, bool clockwise) {
-    if (state->cube->isRotating) return;
-    
-    state->cube->isRotating = true;
-    state->cube->rotating_clockwise = clockwise;
-    state->cube->rotation_progress = 0.0f;
+    FaceletCube facelets;
+    CubeState cubeState;
+    memcpy(facelets.f, snapshot->stickers, FACELET_COUNT);
+    if (!faceletsToCubeState(&facelets, &cubeState)) {
+        fprintf(stderr, "The cube is not in a solvable state\n");
+        return;
+    }
 
-    vec3 axis;
-    // Set axis based on face
-    switch(face_index) {
-        case FACE_FRONT:    glm_vec3_copy((vec3){ 0.0f,  0.0f,  1.0f}, axis); break;
-        case FACE_BACK:     glm_vec3_copy((vec3){ 0.0f,  0.0f, -1.0f}, axis); break;
-        case FACE_LEFT:     glm_vec3_copy((vec3){-1.0f,  0.0f,  0.0f}, axis); break;
-        case FACE_RIGHT:    glm_vec3_copy((vec3){ 1.0f,  0.0f,  0.0f}, axis); break;
-        case FACE_BOTTOM:   glm_vec3_copy((vec3){ 0.0f, -1.0f,  0.0f}, axis); break;
-        case FACE_TOP:      glm_vec3_copy((vec3){ 0.0f,  1.0f,  0.0f}, axis); break;
-        default: state->cube->isRotating = false; return;
+    uint8_t moves[SOLVER_MAX_LENGTH];
+    int count = solverSolve(state->solver, &cubeState, SOLVER_DEFAULT_TARGET_LENGTH, SOLVER_DEFAULT_TIME_LIMIT, moves);
+    if (count < 0) {
+        fprintf(stderr, "No solution found\n");
+        return;
     }
 
-    glm_vec3_copy(axis, state->cube->rotating_axis);
+    char text[SOLVER_MAX_LENGTH * 4];
+    formatAlgorithm(moves, count, text, sizeof(text));
+    printf("Solution (%d moves): %s\n", count, text);
 
-    // Calculate axis index here only for initialization
-    int axis_index = (axis[0] != 0.0f) ? 0 : (axis[1] != 0.0f) ? 1 : 2;
-    float face_coord = axis[axis_index] > 0 ? 1.0f : -1.0f;
+    // startFaceRotation's "clockwise" is X', so X is its counter-clockwise
+    // turn; X2 queues two and the queue folds them back into one half turn
+    for (int i = 0; i < count; i++) {
+        FaceID face = moveFace((Move)moves[i]);
+        int turns = moveQuarterTurns((Move)moves[i]);
+        startFaceRotation(state, face, turns == 3);
+        if (turns == 2) startFaceRotation(state, face, false);
+    }
+}
 
-    // Initialize rotating angles
-    for (int i = 0; i < CUBELET_COUNT; i++) {
-        Cubelet* cubelet = &state->cube->cubelets[i];
-        if (fabs(cubelet->position[axis_index] - face_coord) < 0.01f) {
-            glm_vec3_zero(cubelet->rotating_angle);
-        } else {
-            glm_vec3_zero(cubelet->rotating_angle);
-        }
+// Log every turn queued from now on to path, timed in milliseconds
+bool startRecording(State* state, const char* path) {
+    state->recorder = malloc(sizeof(MoveLogWriter));
+    if (!state->recorder || !moveLogWriterOpen(state->recorder, path, state->cube->size, elapsedMilliseconds(0))) {
+        free(state->recorder);
+        state->recorder = NULL;
+        return false;
     }
+    return true;
 }
 
-void rotateFaceColors(Cubelet* c, vec3 axis, bool clockwise) {
-    vec3 old[6];
-    for (int i = 0; i < 6; i++) {
-        glm_vec3_copy(c->face_colors[i], old[i]);
+static void finishReplay(State* state) {
+    printf("Replay finished after %zu bytes of log\n", state->replayCursor.offset);
+    state->cube->turn_duration = state->cube->turn_duration * (float)state->replaySpeed;
+    moveLogClose(state->replay);
+    free(state->replay);
+    state->replay = NULL;
+}
+
+/**
+ * Play a move log back onto the cube, which must be the log's size. Speed
+ * 0 applies the whole log at once, without animation, so it has to happen
+ * before the simulation starts; otherwise turns are
+ * queued at the recorded times divided by speed (updateReplay, every
+ * frame) and animate that much faster.
+ */
+bool startReplay(State* state, const char* path, double speed) {
+    state->replay = malloc(sizeof(MoveLog));
+    if (!state->replay || !moveLogOpen(state->replay, path)) {
+        free(state->replay);
+        state->replay = NULL;
+        return false;
+    }
+    if (state->replay->cubeSize != state->cube->size) {
+        fprintf(stderr, "%s was recorded on a %d-cube\n", path, state->replay->cubeSize);
+        moveLogClose(state->replay);
+        free(state->replay);
+        state->replay = NULL;
+        return false;
     }
 
-    // X-axis rotation (L/R moves)
-    if (fabs(axis[0]) > 0.5f) {
-        if (axis[0] > 0) { // Right face
-             if (clockwise) { // R
-                glm_vec3_copy(old[0], c->face_colors[4]); // Front to Bottom
-                glm_vec3_copy(old[4], c->face_colors[1]); // Bottom to Back
-                glm_vec3_copy(old[1], c->face_colors[5]); // Back to Top
-                glm_vec3_copy(old[5], c->face_colors[0]); // Top to Front
-            } else { // R'
-                glm_vec3_copy(old[4], c->face_colors[0]); // Bottom to Front
-                glm_vec3_copy(old[0], c->face_colors[5]); // Front to Top
-                glm_vec3_copy(old[5], c->face_colors[1]); // Top to Back
-                glm_vec3_copy(old[1], c->face_colors[4]); // Back to Bottom
-            }
-        } else { // Left face
-            if (clockwise) { // L
-                glm_vec3_copy(old[4], c->face_colors[0]); // Bottom to Front
-                glm_vec3_copy(old[0], c->face_colors[5]); // Front to Top  
-                glm_vec3_copy(old[5], c->face_colors[1]); // Top to Back
-                glm_vec3_copy(old[1], c->face_colors[4]); // Back to Bottom
-            } else { // L'
-                glm_vec3_copy(old[0], c->face_colors[4]); // Front to Bottom
-                glm_vec3_copy(old[4], c->face_colors[1]); // Bottom to Back
-                glm_vec3_copy(old[1], c->face_colors[5]); // Back to Top
-                glm_vec3_copy(old[5], c->face_colors[0]); // Top to Front
-            }
-        }
-    // Y-axis rotation (U/D moves)
-    } else if (fabs(axis[1]) > 0.5f) {
-        if (axis[1] > 0) { // Top face
-            if (clockwise) { // U
-                glm_vec3_copy(old[2], c->face_colors[0]); // Left to Front
-                glm_vec3_copy(old[0], c->face_colors[3]); // Front to Right
-                glm_vec3_copy(old[3], c->face_colors[1]); // Right to Back
-                glm_vec3_copy(old[1], c->face_colors[2]); // Back to Left
-            } else { // U'
-                glm_vec3_copy(old[0], c->face_colors[2]); // Front to Left
-                glm_vec3_copy(old[2], c->face_colors[1]); // Left to Back
-                glm_vec3_copy(old[1], c->face_colors[3]); // Back to Right
-                glm_vec3_copy(old[3], c->face_colors[0]); // Right to Front
-            }
-        } else { // Bottom face
-            if (clockwise) { // D
-                glm_vec3_copy(old[0], c->face_colors[2]); // Front to Left
-                glm_vec3_copy(old[2], c->face_colors[1]); // Left to Back
-                glm_vec3_copy(old[1], c->face_colors[3]); // Back to Right
-                glm_vec3_copy(old[3], c->face_colors[0]); // Right to Front
-            } else { // D'
-                glm_vec3_copy(old[2], c->face_colors[0]); // Left to Front
-                glm_vec3_copy(old[0], c->face_colors[3]); // Front to Right
-                glm_vec3_copy(old[3], c->face_colors[1]); // Right to Back
-                glm_vec3_copy(old[1], c->face_colors[2]); // Back to Left
+    if (speed <= 0.0) {
+        size_t count = 0;
+        if (!state->recorder) {
+            count = moveLogReplay(state->replay, &state->cube->state);
+        } else {
+            MoveLogCursor cursor = {0, 0};
+            LayerMove move;
+            for (; moveLogNext(state->replay, &cursor, &move); count++) {
+                bigCubeApplyMove(&state->cube->state, move);
+                moveLogWriterAppend(state->recorder, move, elapsedMilliseconds(0));
             }
         }
-    // Z-axis rotation (F/B moves)
-    } else if (fabs(axis[2]) > 0.5f) {
-        if (axis[2] > 0) { // Front face
-            if (clockwise) { // F
-                glm_vec3_copy(old[4], c->face_colors[3]); // Bottom to Right
-                glm_vec3_copy(old[3], c->face_colors[5]); // Right to Top
-                glm_vec3_copy(old[5], c->face_colors[2]); // Top to Left
-                glm_vec3_copy(old[2], c->face_colors[4]); // Left to Bottom
-            } else { // F'
-                glm_vec3_copy(old[3], c->face_colors[4]); // Right to Bottom
-                glm_vec3_copy(old[4], c->face_colors[2]); // Bottom to Left
-                glm_vec3_copy(old[2], c->face_colors[5]); // Left to Top
-                glm_vec3_copy(old[5], c->face_colors[3]); // Top to Right
-            }
-        } else { // Back face
-            if (clockwise) { // B
-                glm_vec3_copy(old[3], c->face_colors[4]); // Right to Bottom
-                glm_vec3_copy(old[4], c->face_colors[2]); // Bottom to Left
-                glm_vec3_copy(old[2], c->face_colors[5]); // Left to Top
-                glm_vec3_copy(old[5], c->face_colors[3]); // Top to Right
-            } else { // B'
-                glm_vec3_copy(old[4], c->face_colors[3]); // Bottom to Right
-                glm_vec3_copy(old[3], c->face_colors[5]); // Right to Top
-                glm_vec3_copy(old[5], c->face_colors[2]); // Top to Left
-                glm_vec3_copy(old[2], c->face_colors[4]); // Left to Bottom
-            }
+        printf("Replayed %zu turns\n", count);
+        state->stickersDirty = true;
+        moveLogClose(state->replay);
+        free(state->replay);
+        state->replay = NULL;
+        return true;
+    }
+
+    state->replayCursor = (MoveLogCursor){0, 0};
+    state->replaySpeed = speed;
+    state->replayStart = SDL_GetPerformanceCounter();
+    state->cube->turn_duration = state->cube->turn_duration / (float)speed;
+    return true;
+}
+
+/**
+ * Queue every logged turn that is due; a full queue just holds the rest
+ * back. Returns the milliseconds until the next turn is due (1 while the
+ * queue is full), or -1 with no replay running.
+ */
+int updateReplay(State* state) {
+    if (!state->replay) return -1;
+
+    double due = (double)elapsedMilliseconds(state->replayStart) * state->replaySpeed;
+    while (moveQueueSize(&state->cube->queue) < MOVE_QUEUE_CAPACITY) {
+        MoveLogCursor next = state->replayCursor;
+        LayerMove move;
+        if (!moveLogNext(state->replay, &next, &move)) {
+            finishReplay(state);
+            return -1;
         }
+        if ((double)next.time > due) return (int)ceil(((double)next.time - due) / state->replaySpeed);
+        queueLayerMove(state, move);
+        state->replayCursor = next;
     }
+    return 1;
 }
@@ -1,5 +1,14 @@
 #include "main.h"
 #include "events.h"
+#include "profiler.h"
+
+// Face keys turn the slice at the depth typed just before them ("2r" is the
+// second layer from the right), or the outer layer when none was typed
+static void turnFace(State* state, int face, bool clockwise) {
+    int depth = state->layerDepth > 0 ? state->layerDepth : 1;
+    state->layerDepth = 0;
+    startLayerRotation(state, face, depth, clockwise);
+}
 
 void handleInput(State* state) {
     bool clockwise = !(SDL_GetModState() & KMOD_SHIFT);
@@ -7,16 +16,41 @@ void handleInput(State* state) {
         case SDL_QUIT:
             state->isActive = false;
             break;
-        case SDL_KEYDOWN:
-            switch(state->event.key.keysym.sym) {
+        case SDL_WINDOWEVENT:
+            // The loop only draws on change, so the window system has to ask for repaints
+            switch (state->event.window.event) {
+                case SDL_WINDOWEVENT_HIDDEN:
+                case SDL_WINDOWEVENT_MINIMIZED:
+                    state->frames.visible = false;
+                    break;
+                case SDL_WINDOWEVENT_SHOWN:
+                case SDL_WINDOWEVENT_RESTORED:
+                case SDL_WINDOWEVENT_EXPOSED:
+                case SDL_WINDOWEVENT_SIZE_CHANGED:
+                    state->frames.visible = true;
+                    state->frames.redraw = true;
+                    break;
+            }
+            break;
+        case SDL_KEYDOWN: {
+            SDL_Keycode key = state->event.key.keysym.sym;
+            if (key >= SDLK_0 && key <= SDLK_9) {
+                int depth = state->layerDepth * 10 + (key - SDLK_0);
+                state->layerDepth = depth <= state->cube->size ? depth : 0;
+                break;
+            }
+            switch(key) {
                 case SDLK_ESCAPE: state->isActive = false; break;
-                case SDLK_r: startFaceRotation(state, FACE_RIGHT, clockwise); break;
-                case SDLK_l: startFaceRotation(state, FACE_LEFT, clockwise); break;
-                case SDLK_u: startFaceRotation(state, FACE_TOP, clockwise); break;
-                case SDLK_d: startFaceRotation(state, FACE_BOTTOM, clockwise); break;
-                case SDLK_f: startFaceRotation(state, FACE_FRONT, clockwise); break;
-                case SDLK_b: startFaceRotation(state, FACE_BACK, clockwise); break;
+                case SDLK_r: turnFace(state, FACE_RIGHT, clockwise); break;
+                case SDLK_l: turnFace(state, FACE_LEFT, clockwise); break;
+                case SDLK_u: turnFace(state, FACE_TOP, clockwise); break;
+                case SDLK_d: turnFace(state, FACE_BOTTOM, clockwise); break;
+                case SDLK_f: turnFace(state, FACE_FRONT, clockwise); break;
+                case SDLK_b: turnFace(state, FACE_BACK, clockwise); break;
+                case SDLK_s: solveCube(state); break;
+                case SDLK_p: toggleProfilerHud(state); break;
             }
             break;
+        }
     }
 }
@@ -1,254 +1,349 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <cglm/cglm.h>
 #include "main.h"
 #include "utils.h"
 #include "events.h"
+#include "render.h"
+#include "simulation.h"
+#include "profiler.h"
+#include "stress.h"
+#include "capture.h"
+#include "offscreen.h"
+
+// Undo a window and its context, or an offscreen context, then SDL
+static void destroyDisplay(SDL_Window* window, SDL_GLContext context, Offscreen* offscreen) {
+    destroyOffscreen(offscreen);
+    if (context) SDL_GL_DeleteContext(context);
+    if (window) SDL_DestroyWindow(window);
+    SDL_Quit();
+}
 
-State* initializeState() {
+/**
+ * A window with a GL context, or with offscreen an EGL context drawing
+ * into a WIDTH x HEIGHT framebuffer and no video subsystem at all.
+ */
+State* initializeState(int size, bool offscreen, const char* shaderDir, const char* shaderCache) {
     State* gameState = malloc(sizeof(State));
-    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+    if (SDL_Init(offscreen ? SDL_INIT_EVENTS | SDL_INIT_TIMER : SDL_INIT_VIDEO) < 0) {
         fprintf(stderr, "SDL could not initialize! SDL_Error: %s\n", SDL_GetError());
         return NULL;
     }
 
-    SDL_Window* window = SDL_CreateWindow(
-        "Rubik's Cube Simulation",
-        SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
-        WIDTH, HEIGHT,
-        SDL_WINDOW_OPENGL | SDL_WINDOW_SHOWN
-    );
-    if (!window) {
-        free(gameState);
-        SDL_Quit();
-        fprintf(stderr, "Window could not be created! SDL_Error: %s\n", SDL_GetError());
-        return NULL;
-    }
+    SDL_Window* window = NULL;
+    SDL_GLContext context = NULL;
+    Offscreen* target = NULL;
+    if (offscreen) {
+        target = createOffscreenContext();
+        if (!target) {
+            free(gameState);
+            SDL_Quit();
+            return NULL;
+        }
+    } else {
+        window = SDL_CreateWindow(
+            WINDOW_TITLE,
+            SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+            WIDTH, HEIGHT,
+            SDL_WINDOW_OPENGL | SDL_WINDOW_SHOWN
+        );
+        if (!window) {
+            free(gameState);
+            SDL_Quit();
+            fprintf(stderr, "Window could not be created! SDL_Error: %s\n", SDL_GetError());
+            return NULL;
+        }
 
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
 
-    SDL_GLContext context = SDL_GL_CreateContext(window);
-    if (!context) {
-        SDL_DestroyWindow(window);
-        free(gameState);
-        SDL_Quit();
-        fprintf(stderr, "OpenGL context could not be created! SDL_Error: %s\n", SDL_GetError());
-        return NULL;
+        context = SDL_GL_CreateContext(window);
+        if (!context) {
+            fprintf(stderr, "OpenGL context could not be created! SDL_Error: %s\n", SDL_GetError());
+            destroyDisplay(window, NULL, NULL);
+            free(gameState);
+            return NULL;
+        }
     }
 
-    glViewport(0, 0, WIDTH, HEIGHT);
-
     glewExperimental = GL_TRUE;
-    if (glewInit() != GLEW_OK) {
-        SDL_GL_DeleteContext(context);
-        SDL_DestroyWindow(window);
+    GLenum glewStatus = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    // A GLX build of GLEW loads the GL functions fine, then finds no X display to check
+    if (offscreen && glewStatus == GLEW_ERROR_NO_GLX_DISPLAY) glewStatus = GLEW_OK;
+#endif
+    if (glewStatus != GLEW_OK || (target && !attachOffscreenFramebuffer(target, WIDTH, HEIGHT))) {
+        if (glewStatus != GLEW_OK) fprintf(stderr, "Failed to initialize GLEW\n");
+        destroyDisplay(window, context, target);
         free(gameState);
-        SDL_Quit();
-        fprintf(stderr, "Failed to initialize GLEW\n");
         return NULL;
     }
 
+    glViewport(0, 0, WIDTH, HEIGHT);
     glEnable(GL_DEPTH_TEST);
 
-     GLuint shaderProgram = createShaderProgram(
-        "shaders/vertex.glsl",
-        "shaders/fragment.glsl"
-    );
-    if (!shaderProgram) {
+    ShaderProgram shader;
+    if (!loadShaderFiles(shaderDir, "vertex.glsl", "fragment.glsl", shaderCache, &shader)) {
         fprintf(stderr, "Failed to create shader program.\n");
-        SDL_GL_DeleteContext(context);
-        SDL_DestroyWindow(window);
+        destroyDisplay(window, context, target);
         free(gameState);
-        SDL_Quit();
         return NULL;
     }
 
     gameState->scene = malloc(sizeof(Scene));
     if (!gameState->scene) {
         fprintf(stderr, "Failed to allocate Scene\n");
-        glDeleteProgram(shaderProgram);
-        SDL_GL_DeleteContext(context);
-        SDL_DestroyWindow(window);
+        glDeleteProgram(shader.program);
+        destroyDisplay(window, context, target);
         free(gameState);
-        SDL_Quit();
         return NULL;
     }
 
     gameState->scene->window = window;
     gameState->scene->context = context;
-    gameState->scene->shaderProgram = shaderProgram;
+    gameState->scene->offscreen = target;
+    gameState->scene->shader = shader;
 
     gameState->cube = malloc(sizeof(Cube));
     if (!gameState->cube) {
         fprintf(stderr, "Failed to allocate Cube\n");
-        glDeleteProgram(shaderProgram);
-        SDL_GL_DeleteContext(context);
-        SDL_DestroyWindow(window);
+        glDeleteProgram(shader.program);
+        destroyDisplay(window, context, target);
 
         free(gameState->scene);
         free(gameState);
-        SDL_Quit();
         return NULL;
     }
 
-    initCubelets(gameState);
+    if (!initCubelets(gameState, size)) {
+        glDeleteProgram(shader.program);
+        destroyDisplay(window, context, target);
+
+        free(gameState->cube);
+        free(gameState->scene);
+        free(gameState);
+        return NULL;
+    }
 
     return gameState;
 }
 
 void cleanup(State* state) {
-    glDeleteVertexArrays(1, &state->VAO);
-    glDeleteBuffers(1, &state->VBO);
-    glDeleteBuffers(1, &state->faceIndexBuffer);
-    glDeleteProgram(state->scene->shaderProgram);
+    stopSimulation(state);
+    stopProfiler(state);
+    stopCapture(state);
+    destroyRenderer(state);
+    glDeleteProgram(state->scene->shader.program);
 
-    SDL_GL_DeleteContext(state->scene->context);
-    SDL_DestroyWindow(state->scene->window);
-    SDL_Quit();
+    destroyDisplay(state->scene->window, state->scene->context, state->scene->offscreen);
 
+    destroyCubelets(state);
     free(state->scene);
     free(state->cube);
     free(state);
 }
 
+/**
+ * Swap interval for --vsync: 0 off, 1 on, -1 adaptive (late frames tear
+ * instead of waiting a whole extra refresh). Drivers without adaptive sync
+ * fall back to plain vsync.
+ */
+static void setSwapInterval(int interval) {
+    if (SDL_GL_SetSwapInterval(interval) == 0) return;
+    if (interval < 0 && SDL_GL_SetSwapInterval(1) == 0) {
+        fprintf(stderr, "Adaptive vsync not supported, using vsync\n");
+        return;
+    }
+    fprintf(stderr, "Could not set the swap interval: %s\n", SDL_GetError());
+}
+
+/**
+ * Whether anything on screen changed: a new simulation snapshot, the
+ * camera, or the window asking for a repaint. While capturing, every frame
+ * the cap allows is drawn, so recordings keep real time. Offscreen no
+ * event will ever wake the loop, so every frame is needed there too and
+ * the run ends through --frames or finalFrame instead.
+ */
+static bool frameNeeded(State* state) {
+    return state->frames.visible &&
+           (state->capture || state->scene->offscreen || state->frames.redraw || state->camera.dirty ||
+            snapshotPending(state));
+}
+
+/**
+ * Offscreen there is nobody to close a window: without --frames the run
+ * ends with the first frame showing the cube with nothing left to do, i.e.
+ * replay over and every turn landed. Checked before drawing, since the
+ * frame can only show that snapshot or a later, identical one.
+ */
+static bool finalFrame(State* state) {
+    return state->scene->offscreen && state->frames.frameLimit == 0 && !state->replay &&
+           snapshotSettled(state, latestSnapshot(state));
+}
+
+/**
+ * How long the loop may block waiting for input, in milliseconds, -1 for
+ * as long as it takes. A settled cube only changes when this thread queues
+ * a turn, so with no frame owed and no replay the loop sleeps until an
+ * event arrives. Mid-turn it sleeps until the simulation's next tick, and
+ * with a frame owed, until the frame cap allows drawing it.
+ */
+static int frameTimeout(State* state, int replayDue) {
+    const CubeSnapshot* snapshot = latestSnapshot(state);
+    int timeout = replayDue;
+    if (frameNeeded(state)) {
+        Uint64 current = SDL_GetPerformanceCounter();
+        if (current >= state->frames.nextFrame) return 0;
+        Uint64 frequency = SDL_GetPerformanceFrequency();
+        timeout = (int)(((state->frames.nextFrame - current) * 1000 + frequency - 1) / frequency);
+    } else if (!snapshotSettled(state, snapshot)) {
+        timeout = 1000 / SIMULATION_RATE;
+    } else {
+        return timeout;
+    }
+    return replayDue >= 0 && replayDue < timeout ? replayDue : timeout;
+}
+
+// Schedule the earliest next frame the cap allows, never piling up frames owed from a stall
+static void frameDrawn(State* state) {
+    state->frames.redraw = false;
+    if (state->frames.maxFps <= 0) return;
+
+    Uint64 current = SDL_GetPerformanceCounter();
+    state->frames.nextFrame += SDL_GetPerformanceFrequency() / (Uint64)state->frames.maxFps;
+    if (state->frames.nextFrame < current) state->frames.nextFrame = current;
+}
+
 int main(int argc, char* argv[]) {
-    State* state = initializeState();
+    int size = DEFAULT_CUBE_SIZE;
+    float turnDuration = DEFAULT_TURN_DURATION;
+    const char* recordPath = NULL;
+    const char* replayPath = NULL;
+    double replaySpeed = 1.0;
+    int maxFps = 0;
+    int swapInterval = DEFAULT_SWAP_INTERVAL;
+    bool profile = false;
+    const char* profilePath = NULL;
+    const char* shaderDir = NULL;
+    const char* shaderCache = DEFAULT_PROGRAM_CACHE_PATH;
+    int stressCount = 0;
+    bool offscreen = false;
+    const char* capturePath = NULL;
+    int frameLimit = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--turn-duration") == 0 && i + 1 < argc) {
+            turnDuration = strtof(argv[++i], NULL);
+        } else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            size = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replayPath = argv[++i];
+        } else if (strcmp(argv[i], "--replay-speed") == 0 && i + 1 < argc) {
+            replaySpeed = strtod(argv[++i], NULL);
+        } else if (strcmp(argv[i], "--max-fps") == 0 && i + 1 < argc) {
+            maxFps = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--vsync") == 0 && i + 1 < argc &&
+                   (strcmp(argv[i + 1], "off") == 0 || strcmp(argv[i + 1], "on") == 0 ||
+                    strcmp(argv[i + 1], "adaptive") == 0)) {
+            i++;
+            swapInterval = strcmp(argv[i], "off") == 0 ? 0 : strcmp(argv[i], "on") == 0 ? 1 : -1;
+        } else if (strcmp(argv[i], "--profile") == 0) {
+            profile = true;
+        } else if (strcmp(argv[i], "--profile-csv") == 0 && i + 1 < argc) {
+            profilePath = argv[++i];
+        } else if (strcmp(argv[i], "--shader-dir") == 0 && i + 1 < argc) {
+            shaderDir = argv[++i];
+        } else if (strcmp(argv[i], "--shader-cache") == 0 && i + 1 < argc) {
+            shaderCache = argv[++i];
+        } else if (strcmp(argv[i], "--no-shader-cache") == 0) {
+            shaderCache = NULL;
+        } else if (strcmp(argv[i], "--stress") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0) {
+            stressCount = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--offscreen") == 0) {
+            offscreen = true;
+        } else if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc) {
+            capturePath = argv[++i];
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0) {
+            frameLimit = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s [--size n] [--turn-duration seconds] [--record log] "
+                            "[--replay log] [--replay-speed factor, 0 = instant] "
+                            "[--max-fps n] [--vsync off|on|adaptive] [--profile] [--profile-csv file] "
+                            "[--shader-dir dir] [--shader-cache file | --no-shader-cache] [--stress cubes] "
+                            "[--offscreen] [--capture frame%%05d.ppm | file | -] [--frames n]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    State* state = initializeState(size, offscreen, shaderDir, shaderCache);
     if (!state) {
         return 1;
     }
 
     state->isActive = true;
+    state->cube->turn_duration = turnDuration;
+    state->frames = (FrameScheduler){maxFps, SDL_GetPerformanceCounter(), true, true, frameLimit, 0};
+    state->profiler = NULL;
+    state->capture = NULL;
+    if (!offscreen) setSwapInterval(swapInterval);
+
+    initRenderer(state);
+
+    // The stress scene replaces the single cube and its simulation entirely
+    if (stressCount > 0) {
+        bool ok = (!(profile || profilePath) || startProfiler(state, profilePath, profile)) &&
+                  (!capturePath || startCapture(state, capturePath)) &&
+                  runStress(state, stressCount, shaderDir, shaderCache);
+        cleanup(state);
+        return ok ? 0 : 1;
+    }
 
-    // Vertex data with positions and colors (6 faces × 6 vertices × (3 position + 3 color))
-    float positions[6*6*3] = {
-        // Front face
-        -0.5f, -0.5f,  0.5f,
-        0.5f, -0.5f,  0.5f,
-        0.5f,  0.5f,  0.5f,
-        0.5f,  0.5f,  0.5f,
-        -0.5f,  0.5f,  0.5f,
-        -0.5f, -0.5f,  0.5f,
-        
-        // Back face
-        -0.5f, -0.5f, -0.5f,
-        0.5f, -0.5f, -0.5f,
-        0.5f,  0.5f, -0.5f,
-        0.5f,  0.5f, -0.5f,
-        -0.5f,  0.5f, -0.5f,
-        -0.5f, -0.5f, -0.5f,
-        
-        // Left face
-        -0.5f,  0.5f,  0.5f,
-        -0.5f,  0.5f, -0.5f,
-        -0.5f, -0.5f, -0.5f,
-        -0.5f, -0.5f, -0.5f,
-        -0.5f, -0.5f,  0.5f,
-        -0.5f,  0.5f,  0.5f,
-        
-        // Right face
-        0.5f,  0.5f,  0.5f,
-        0.5f,  0.5f, -0.5f,
-        0.5f, -0.5f, -0.5f,
-        0.5f, -0.5f, -0.5f,
-        0.5f, -0.5f,  0.5f,
-        0.5f,  0.5f,  0.5f,
-        
-        // Bottom face
-        -0.5f, -0.5f, -0.5f,
-        0.5f, -0.5f, -0.5f,
-        0.5f, -0.5f,  0.5f,
-        0.5f, -0.5f,  0.5f,
-        -0.5f, -0.5f,  0.5f,
-        -0.5f, -0.5f, -0.5f,
-        
-        // Top face
-        -0.5f,  0.5f, -0.5f,
-        0.5f,  0.5f, -0.5f,
-        0.5f,  0.5f,  0.5f,
-        0.5f,  0.5f,  0.5f,
-        -0.5f,  0.5f,  0.5f,
-        -0.5f,  0.5f, -0.5f
-    };
-
-    int faceIndices[36] = {
-        FACE_FRONT, FACE_FRONT, FACE_FRONT, FACE_FRONT, FACE_FRONT, FACE_FRONT,  // Front (Red)
-        FACE_BACK, FACE_BACK, FACE_BACK, FACE_BACK, FACE_BACK, FACE_BACK,  // Back (Orange)
-        FACE_LEFT, FACE_LEFT, FACE_LEFT, FACE_LEFT, FACE_LEFT, FACE_LEFT,  // Left (Green)
-        FACE_RIGHT, FACE_RIGHT, FACE_RIGHT, FACE_RIGHT, FACE_RIGHT, FACE_RIGHT,  // Right (Blue)
-        FACE_BOTTOM, FACE_BOTTOM, FACE_BOTTOM, FACE_BOTTOM, FACE_BOTTOM, FACE_BOTTOM,  // Bottom (White)
-        FACE_TOP, FACE_TOP, FACE_TOP, FACE_TOP, FACE_TOP, FACE_TOP   // Top (Yellow)
-    };
-
-    glGenVertexArrays(1, &state->VAO);
-    glGenBuffers(1, &state->VBO);
-    glGenBuffers(1, &state->faceIndexBuffer);
-
-    glBindVertexArray(state->VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, state->VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(positions), positions, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    glBindBuffer(GL_ARRAY_BUFFER, state->faceIndexBuffer);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(faceIndices), faceIndices, GL_STATIC_DRAW);
-    glVertexAttribIPointer(2, 1, GL_INT, 0, (void*)0);
-    glEnableVertexAttribArray(2);
-
-    glBindVertexArray(0);
+    // Recording starts first so replayed turns are logged too, and an
+    // instant replay lands before the simulation takes the cube over
+    if ((recordPath && !startRecording(state, recordPath)) ||
+        (replayPath && !startReplay(state, replayPath, replaySpeed)) ||
+        !startSimulation(state) ||
+        ((profile || profilePath) && !startProfiler(state, profilePath, profile)) ||
+        (capturePath && !startCapture(state, capturePath))) {
+        cleanup(state);
+        return 1;
+    }
 
+    // Turns and their animation advance on the simulation thread; this one
+    // only feeds it moves and draws its snapshots, and only when they change
+    int replayDue = updateReplay(state);
     while (state->isActive) {
+        int timeout = frameTimeout(state, replayDue);
+        bool woken = timeout != 0 && SDL_WaitEventTimeout(&state->event, timeout);
+        profileResume(state);
+        if (woken) {
+            handleInput(state);
+        }
         while (SDL_PollEvent(&state->event)) {
             handleInput(state);
         }
 
-        updateCubelets(state);
+        replayDue = updateReplay(state);
+        profileMark(state, PHASE_EVENTS);
+        if (!frameNeeded(state) || SDL_GetPerformanceCounter() < state->frames.nextFrame) continue;
 
+        bool last = finalFrame(state);
+        profileFrameBegin(state);
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        profileMark(state, PHASE_DRAW);
 
-        glUseProgram(state->scene->shaderProgram);
-
-        // Camera setup
-        mat4 view, projection;
-        glm_mat4_identity(view);
-        glm_lookat((vec3){3.0f, 3.0f, 3.0f}, (vec3){0.0f, 0.0f, 0.0f}, (vec3){0.0f, 1.0f,0.0f}, view);
-        glm_perspective(glm_rad(45.0f), (float)WIDTH / (float)HEIGHT, 0.1f, 100.0f, projection);
-
-        GLuint viewLoc = glGetUniformLocation(state->scene->shaderProgram, "view");
-        GLuint projLoc = glGetUniformLocation(state->scene->shaderProgram, "projection");
-        glUniformMatrix4fv(viewLoc, 1, GL_FALSE, (float*)view);
-        glUniformMatrix4fv(projLoc, 1, GL_FALSE, (float*)projection);
-
-        glBindVertexArray(state->VAO);
-        for (int i = 0; i < CUBELET_COUNT; i++) {
-            Cubelet* cubelet = &state->cube->cubelets[i];
-
-            mat4 model;
-            glm_mat4_identity(model);
-
-            float angle = glm_vec3_norm(cubelet->rotating_angle);
-            if (angle > 0.0f) {
-                vec3 axis;
-                glm_vec3_copy(cubelet->rotating_angle, axis);
-                glm_vec3_normalize(axis); // You naughty lil angle, behave! 😤
-                glm_rotate(model, angle, axis); // YAS twist that body 😩
-            }
-
-            glm_translate(model, cubelet->position);
-
-            GLuint colorsLoc = glGetUniformLocation(state->scene->shaderProgram, "faceColors");
-            glUniform3fv(colorsLoc, 6, (float*)cubelet->face_colors);
-
-            GLuint modelLoc = glGetUniformLocation(state->scene->shaderProgram, "model");
-            glUniformMatrix4fv(modelLoc, 1, GL_FALSE, (float*)model);
-            glDrawArrays(GL_TRIANGLES, 0, 36);
-        }
-        glBindVertexArray(0);
+        renderCube(state);
 
-        SDL_GL_SwapWindow(state->scene->window);
+        profileSubmitted(state);
+        presentFrame(state);
+        profileFrameEnd(state);
+        frameDrawn(state);
+        if (last) state->isActive = false;
     }
 
     cleanup(state);
@@ -0,0 +1,159 @@
+#include <stdlib.h>
+#include <string.h>
+#include "main.h"
+#include "capture.h"
+#include "offscreen.h"
+
+/**
+ * Present the frame drawn since the last one: capture it, then swap unless
+ * there is no window. Ends the loop once --frames frames are out.
+ */
+void presentFrame(State* state) {
+    captureFrame(state);
+    if (!state->scene->offscreen) SDL_GL_SwapWindow(state->scene->window);
+
+    FrameScheduler* frames = &state->frames;
+    if (frames->frameLimit > 0 && ++frames->framesPresented >= frames->frameLimit) state->isActive = false;
+}
+
+#ifdef RUBIK_OFFSCREEN
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+struct Offscreen {
+    EGLDisplay display;
+    EGLContext context;
+    EGLSurface surface;                 // EGL_NO_SURFACE on the surfaceless platform
+    GLuint framebuffer;
+    GLuint renderbuffers[2];            // Colour, depth
+};
+
+static bool hasExtension(const char* extensions, const char* name) {
+    size_t length = strlen(name);
+    for (const char* found = extensions; found && (found = strstr(found, name)); found += length) {
+        if ((found == extensions || found[-1] == ' ') && (found[length] == ' ' || found[length] == '\0')) return true;
+    }
+    return false;
+}
+
+static EGLDisplay openDisplay(bool* surfaceless) {
+    const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    *surfaceless = getPlatformDisplay && hasExtension(clientExtensions, "EGL_MESA_platform_surfaceless");
+    if (*surfaceless) {
+        EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+        if (display != EGL_NO_DISPLAY && eglInitialize(display, NULL, NULL)) return display;
+        *surfaceless = false;
+    }
+    EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (display != EGL_NO_DISPLAY && eglInitialize(display, NULL, NULL)) return display;
+    return EGL_NO_DISPLAY;
+}
+
+/**
+ * A current GL 3.3 core context with no window, or NULL. GL functions can
+ * be loaded once this returns; the framebuffer comes after that.
+ */
+Offscreen* createOffscreenContext(void) {
+    Offscreen* offscreen = calloc(1, sizeof(Offscreen));
+    if (!offscreen) {
+        fprintf(stderr, "Failed to allocate the offscreen target\n");
+        return NULL;
+    }
+
+    bool surfaceless;
+    offscreen->display = openDisplay(&surfaceless);
+    if (offscreen->display == EGL_NO_DISPLAY) {
+        fprintf(stderr, "No EGL display for offscreen rendering (EGL error 0x%x)\n", eglGetError());
+        free(offscreen);
+        return NULL;
+    }
+
+    const EGLint configAttributes[] = {
+        EGL_SURFACE_TYPE, surfaceless ? 0 : EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE,
+    };
+    const EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE,
+    };
+    const EGLint pbufferAttributes[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+    EGLConfig config;
+    EGLint configs = 0;
+    offscreen->surface = EGL_NO_SURFACE;
+    offscreen->context = EGL_NO_CONTEXT;
+    if (eglBindAPI(EGL_OPENGL_API) &&
+        eglChooseConfig(offscreen->display, configAttributes, &config, 1, &configs) && configs > 0 &&
+        (surfaceless ||
+         (offscreen->surface = eglCreatePbufferSurface(offscreen->display, config, pbufferAttributes)) != EGL_NO_SURFACE) &&
+        (offscreen->context = eglCreateContext(offscreen->display, config, EGL_NO_CONTEXT, contextAttributes)) != EGL_NO_CONTEXT &&
+        eglMakeCurrent(offscreen->display, offscreen->surface, offscreen->surface, offscreen->context)) {
+        return offscreen;
+    }
+
+    fprintf(stderr, "Could not create an offscreen OpenGL 3.3 context (EGL error 0x%x)\n", eglGetError());
+    destroyOffscreen(offscreen);
+    return NULL;
+}
+
+// Render into width x height colour and depth buffers from now on; needs GL functions loaded
+bool attachOffscreenFramebuffer(Offscreen* offscreen, int width, int height) {
+    glGenFramebuffers(1, &offscreen->framebuffer);
+    glGenRenderbuffers(2, offscreen->renderbuffers);
+    glBindRenderbuffer(GL_RENDERBUFFER, offscreen->renderbuffers[0]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, offscreen->renderbuffers[1]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, offscreen->framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, offscreen->renderbuffers[0]);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, offscreen->renderbuffers[1]);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        fprintf(stderr, "The offscreen framebuffer is incomplete (0x%x)\n", status);
+        return false;
+    }
+    return true;
+}
+
+// Also releases the context, so any GL objects must be gone first
+void destroyOffscreen(Offscreen* offscreen) {
+    if (!offscreen) return;
+
+    if (offscreen->framebuffer) {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteFramebuffers(1, &offscreen->framebuffer);
+        glDeleteRenderbuffers(2, offscreen->renderbuffers);
+    }
+    eglMakeCurrent(offscreen->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (offscreen->context != EGL_NO_CONTEXT) eglDestroyContext(offscreen->display, offscreen->context);
+    if (offscreen->surface != EGL_NO_SURFACE) eglDestroySurface(offscreen->display, offscreen->surface);
+    eglTerminate(offscreen->display);
+    free(offscreen);
+}
+
+#else
+
+Offscreen* createOffscreenContext(void) {
+    fprintf(stderr, "This build has no offscreen rendering: EGL was not found\n");
+    return NULL;
+}
+
+bool attachOffscreenFramebuffer(Offscreen* offscreen, int width, int height) {
+    (void)offscreen;
+    (void)width;
+    (void)height;
+    return false;
+}
+
+void destroyOffscreen(Offscreen* offscreen) {
+    (void)offscreen;
+}
+
+#endif
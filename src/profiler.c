@@ -0,0 +1,195 @@
+#include <stdlib.h>
+#include <string.h>
+#include "main.h"
+#include "profiler.h"
+#include "simulation.h"
+
+static const char* phaseNames[PHASE_COUNT] = {
+    "events", "simulation", "upload", "draw", "swap", "cpu", "interval", "gpu",
+};
+
+static const float reportedRanks[3] = {50.0f, 95.0f, 99.0f};
+
+static float millisecondsSince(Uint64 since, Uint64 until) {
+    return (float)((double)(until - since) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+}
+
+/**
+ * Time frames from now on. csvPath, if not NULL, gets one row per frame;
+ * hud shows rolling percentiles in the window title. Needs the GL context.
+ */
+bool startProfiler(State* state, const char* csvPath, bool hud) {
+    Profiler* profiler = calloc(1, sizeof(Profiler));
+    if (!profiler) {
+        fprintf(stderr, "Failed to allocate the profiler\n");
+        return false;
+    }
+
+    if (csvPath) {
+        profiler->csv = fopen(csvPath, "w");
+        if (!profiler->csv) {
+            fprintf(stderr, "Could not create %s\n", csvPath);
+            free(profiler);
+            return false;
+        }
+        fprintf(profiler->csv, "frame");
+        for (int i = 0; i < PHASE_COUNT; i++) fprintf(profiler->csv, ",%s_ms", phaseNames[i]);
+        fprintf(profiler->csv, "\n");
+    }
+
+    for (int i = 0; i < PHASE_COUNT; i++) rollingSamplesInit(&profiler->windows[i]);
+    glGenQueries(PROFILER_QUERIES, profiler->queries);
+    profiler->hud = hud;
+    profiler->mark = SDL_GetPerformanceCounter();
+    profiler->lastReport = profiler->mark;
+    state->profiler = profiler;
+    return true;
+}
+
+// Finish the CSV row of the frame a query timed; gpu < 0 leaves its GPU column empty
+static void writeRow(Profiler* profiler, uint64_t frame, const float* phases, float gpu) {
+    if (!profiler->csv) return;
+
+    fprintf(profiler->csv, "%llu", (unsigned long long)frame);
+    for (int i = 0; i < PHASE_GPU; i++) fprintf(profiler->csv, ",%.4f", phases[i]);
+    if (gpu >= 0.0f) {
+        fprintf(profiler->csv, ",%.4f\n", gpu);
+    } else {
+        fprintf(profiler->csv, ",\n");
+    }
+}
+
+// Read back a query slot's result if the driver has it (or, with wait, once it does)
+static void collectQuery(Profiler* profiler, int slot, bool wait) {
+    if (!profiler->queryPending[slot]) return;
+    profiler->queryPending[slot] = false;
+
+    GLint available = 0;
+    if (!wait) glGetQueryObjectiv(profiler->queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+    float gpu = -1.0f;
+    if (wait || available) {
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(profiler->queries[slot], GL_QUERY_RESULT, &nanoseconds);
+        gpu = (float)((double)nanoseconds * 1e-6);
+        rollingSamplesAdd(&profiler->windows[PHASE_GPU], gpu);
+    } else {
+        profiler->dropped++;
+    }
+    writeRow(profiler, profiler->queryFrame[slot], profiler->queryRows[slot], gpu);
+}
+
+// "name p50/p95/p99" of a phase into out; returns the length snprintf would have written
+static int formatPercentiles(char* out, size_t size, const Profiler* profiler, ProfilePhase phase) {
+    float values[3];
+    if (!rollingSamplesPercentiles(&profiler->windows[phase], reportedRanks, 3, values)) {
+        return snprintf(out, size, "%s -", phaseNames[phase]);
+    }
+    return snprintf(out, size, "%s %.2f/%.2f/%.2f", phaseNames[phase], values[0], values[1], values[2]);
+}
+
+// Outstanding results are waited for here, so the CSV has every frame; needs the GL context
+void stopProfiler(State* state) {
+    Profiler* profiler = state->profiler;
+    if (!profiler) return;
+
+    for (int i = 0; i < PROFILER_QUERIES; i++) {
+        collectQuery(profiler, (int)((profiler->frame + (uint64_t)i) % PROFILER_QUERIES), true);
+    }
+    glDeleteQueries(PROFILER_QUERIES, profiler->queries);
+    if (profiler->csv && fclose(profiler->csv) != 0) fprintf(stderr, "The profile CSV is incomplete\n");
+
+    printf("%llu frames profiled, p50/p95/p99 ms over the last %d:\n",
+           (unsigned long long)profiler->frame, FRAME_STATS_WINDOW);
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        char line[64];
+        formatPercentiles(line, sizeof(line), profiler, (ProfilePhase)i);
+        printf("  %s\n", line);
+    }
+    if (profiler->dropped) printf("%llu GPU timings were not ready in time\n", (unsigned long long)profiler->dropped);
+
+    if (profiler->hud) SDL_SetWindowTitle(state->scene->window, WINDOW_TITLE);
+    free(profiler);
+    state->profiler = NULL;
+}
+
+void toggleProfilerHud(State* state) {
+    Profiler* profiler = state->profiler;
+    if (!profiler) return;
+
+    profiler->hud = !profiler->hud;
+    if (!profiler->hud) SDL_SetWindowTitle(state->scene->window, WINDOW_TITLE);
+}
+
+// Forget the time since the last mark: the loop was blocked waiting for something to do
+void profileResume(State* state) {
+    if (state->profiler) state->profiler->mark = SDL_GetPerformanceCounter();
+}
+
+// Charge the time since the last mark to phase
+void profileMark(State* state, ProfilePhase phase) {
+    Profiler* profiler = state->profiler;
+    if (!profiler) return;
+
+    Uint64 current = SDL_GetPerformanceCounter();
+    profiler->phases[phase] += millisecondsSince(profiler->mark, current);
+    profiler->mark = current;
+}
+
+// Before the frame's first GL command: start its GPU timer in the slot freed two frames ago
+void profileFrameBegin(State* state) {
+    Profiler* profiler = state->profiler;
+    if (!profiler) return;
+
+    int slot = (int)(profiler->frame % PROFILER_QUERIES);
+    collectQuery(profiler, slot, false);
+    glBeginQuery(GL_TIME_ELAPSED, profiler->queries[slot]);
+}
+
+// After the frame's last GL command, before the swap
+void profileSubmitted(State* state) {
+    if (!state->profiler) return;
+
+    profileMark(state, PHASE_DRAW);
+    glEndQuery(GL_TIME_ELAPSED);
+}
+
+static void updateHud(State* state) {
+    static const ProfilePhase shown[] = {PHASE_CPU, PHASE_GPU, PHASE_SWAP, PHASE_SIMULATION};
+    char title[256];
+    size_t length = (size_t)snprintf(title, sizeof(title), "%s | p50/p95/p99 ms:", WINDOW_TITLE);
+    for (size_t i = 0; i < sizeof(shown) / sizeof(shown[0]) && length + 1 < sizeof(title); i++) {
+        title[length++] = ' ';
+        length += (size_t)formatPercentiles(title + length, sizeof(title) - length, state->profiler, shown[i]);
+    }
+    SDL_SetWindowTitle(state->scene->window, title);
+}
+
+// After the swap: close the frame's CPU phases and hand its row to its GPU query
+void profileFrameEnd(State* state) {
+    Profiler* profiler = state->profiler;
+    if (!profiler) return;
+
+    profileMark(state, PHASE_SWAP);
+    Uint64 current = profiler->mark;
+    float* phases = profiler->phases;
+    phases[PHASE_SIMULATION] = takeSlowestTick(state);
+    phases[PHASE_CPU] = phases[PHASE_EVENTS] + phases[PHASE_UPLOAD] + phases[PHASE_DRAW] + phases[PHASE_SWAP];
+    phases[PHASE_INTERVAL] = profiler->frame > 0 ? millisecondsSince(profiler->lastSwap, current) : 0.0f;
+    profiler->lastSwap = current;
+
+    for (int i = 0; i < PHASE_GPU; i++) {
+        if (i != PHASE_INTERVAL || profiler->frame > 0) rollingSamplesAdd(&profiler->windows[i], phases[i]);
+    }
+
+    int slot = (int)(profiler->frame % PROFILER_QUERIES);
+    memcpy(profiler->queryRows[slot], phases, sizeof(profiler->queryRows[slot]));
+    profiler->queryFrame[slot] = profiler->frame;
+    profiler->queryPending[slot] = true;
+    memset(profiler->phases, 0, sizeof(profiler->phases));
+    profiler->frame++;
+
+    if (profiler->hud && millisecondsSince(profiler->lastReport, current) >= PROFILER_HUD_INTERVAL * 1000.0) {
+        profiler->lastReport = current;
+        updateHud(state);
+    }
+}
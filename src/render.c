@@ -0,0 +1,275 @@
+#include <stddef.h>
+#include <stdlib.h>
+#include <cglm/cglm.h>
+#include "main.h"
+#include "render.h"
+#include "profiler.h"
+#include "simulation.h"
+
+/**
+ * Every sticker and cap is an instance of one unit quad in the z = 0 plane,
+ * facing +Z with counter-clockwise winding so back-face culling keeps only
+ * the side facing out of the cube.
+ */
+static const float quadVertices[4 * 3] = {
+    -0.5f, -0.5f, 0.0f,
+     0.5f, -0.5f, 0.0f,
+     0.5f,  0.5f, 0.0f,
+    -0.5f,  0.5f, 0.0f,
+};
+
+static const GLuint quadIndices[6] = {
+    0, 1, 2,
+    2, 3, 0,
+};
+
+static const vec3 faceNormals[FACE_COUNT] = {
+    { 0.0f,  0.0f,  1.0f},  // Front
+    { 0.0f,  0.0f, -1.0f},  // Back
+    {-1.0f,  0.0f,  0.0f},  // Left
+    { 1.0f,  0.0f,  0.0f},  // Right
+    { 0.0f, -1.0f,  0.0f},  // Bottom
+    { 0.0f,  1.0f,  0.0f},  // Top
+};
+
+const vec3 stickerColors[FACE_COUNT + 1] = {
+    {1.0f, 0.0f, 0.0f},   // Front (Red)
+    {1.0f, 0.5f, 0.0f},   // Back (Orange)
+    {0.0f, 1.0f, 0.0f},   // Left (Green)
+    {0.0f, 0.0f, 1.0f},   // Right (Blue)
+    {1.0f, 1.0f, 1.0f},   // Bottom (White)
+    {1.0f, 1.0f, 0.0f},   // Top (Yellow)
+    {0.2f, 0.2f, 0.2f},   // Caps (CAP_COLOR)
+};
+
+// Faces looking down the negative and positive end of each axis
+static const FaceID axisFaces[3][2] = {
+    {FACE_LEFT, FACE_RIGHT},
+    {FACE_BOTTOM, FACE_TOP},
+    {FACE_BACK, FACE_FRONT},
+};
+
+// Rotation taking the quad's +Z normal onto each face normal
+static mat4 faceOrientation[FACE_COUNT];
+static bool faceOrientationReady = false;
+
+static void initFaceOrientation(void) {
+    if (faceOrientationReady) return;
+
+    glm_mat4_identity(faceOrientation[FACE_FRONT]);
+    glm_rotate_make(faceOrientation[FACE_BACK], glm_rad(180.0f), (vec3){0.0f, 1.0f, 0.0f});
+    glm_rotate_make(faceOrientation[FACE_LEFT], glm_rad(-90.0f), (vec3){0.0f, 1.0f, 0.0f});
+    glm_rotate_make(faceOrientation[FACE_RIGHT], glm_rad(90.0f), (vec3){0.0f, 1.0f, 0.0f});
+    glm_rotate_make(faceOrientation[FACE_BOTTOM], glm_rad(90.0f), (vec3){1.0f, 0.0f, 0.0f});
+    glm_rotate_make(faceOrientation[FACE_TOP], glm_rad(-90.0f), (vec3){1.0f, 0.0f, 0.0f});
+    faceOrientationReady = true;
+}
+
+void setCamera(State* state, vec3 eye, float fovy) {
+    glm_lookat(eye, (vec3){0.0f, 0.0f, 0.0f}, (vec3){0.0f, 1.0f, 0.0f}, state->camera.view);
+    glm_perspective(fovy, (float)WIDTH / (float)HEIGHT, 0.1f, fmaxf(100.0f, 4.0f * glm_vec3_norm(eye)), state->camera.projection);
+    state->camera.dirty = true;
+}
+
+/**
+ * Only the surface is ever built: one quad per sticker, 6 * size^2 in all,
+ * placed once with the cube centred on the origin and one unit per layer.
+ * Turns rotate these rest matrices, they never move them.
+ */
+void stickerRestMatrix(int size, int sticker, mat4 rest) {
+    initFaceOrientation();
+
+    int pos[3];
+    stickerPosition(size, sticker, pos);
+    FaceID face = stickerFace(size, sticker);
+    float half = 0.5f * (float)(size - 1);
+    vec3 center;
+    for (int axis = 0; axis < 3; axis++) {
+        center[axis] = (float)pos[axis] - half + 0.5f * faceNormals[face][axis];
+    }
+    glm_translate_make(rest, center);
+    glm_mat4_mul(rest, faceOrientation[face], rest);
+}
+
+static void initStickerGeometry(State* state) {
+    for (int i = 0; i < state->cube->state.stickerCount; i++) {
+        stickerRestMatrix(state->cube->size, i, state->stickerRest[i]);
+    }
+}
+
+// Current rotation of the turning slice
+static void turnRotation(const CubeSnapshot* snapshot, mat4 rotation) {
+    vec3 axis = {0.0f, 0.0f, 0.0f};
+    axis[snapshot->rotatingMove.axis] = 1.0f;
+    glm_rotate_make(rotation, snapshot->rotatingTarget * snapshot->rotationProgress, axis);
+}
+
+static void buildSticker(State* state, const CubeSnapshot* snapshot, int sticker, mat4 rotation) {
+    StickerInstance* instance = &state->stickers[sticker];
+    if (rotation) {
+        glm_mat4_mul(rotation, state->stickerRest[sticker], instance->model);
+    } else {
+        glm_mat4_copy(state->stickerRest[sticker], instance->model);
+    }
+    glm_vec3_copy((float*)stickerColors[snapshot->stickers[sticker]], instance->color);
+}
+
+static void capRestMatrix(int size, int axis, float offset, FaceID face, mat4 rest) {
+    vec3 center = {0.0f, 0.0f, 0.0f};
+    center[axis] = offset;
+
+    glm_translate_make(rest, center);
+    glm_mat4_mul(rest, faceOrientation[face], rest);
+    glm_scale(rest, (vec3){(float)size, (float)size, 1.0f});
+}
+
+/**
+ * The caps that close the gaps a turning slice opens: at each cut into the
+ * cube, one size x size cap on the still part facing the slice (still) and
+ * one on the slice facing back (turning, to be rotated with it). An outer
+ * layer has one cut, an inner slice two. Returns the number of cuts.
+ */
+int layerCaps(int size, int axis, int layer, mat4 still[2], mat4 turning[2]) {
+    initFaceOrientation();
+
+    float center = (float)layer - 0.5f * (float)(size - 1);
+    int count = 0;
+    if (layer > 0) {
+        capRestMatrix(size, axis, center - 0.5f, axisFaces[axis][1], still[count]);
+        capRestMatrix(size, axis, center - 0.5f, axisFaces[axis][0], turning[count++]);
+    }
+    if (layer < size - 1) {
+        capRestMatrix(size, axis, center + 0.5f, axisFaces[axis][0], still[count]);
+        capRestMatrix(size, axis, center + 0.5f, axisFaces[axis][1], turning[count++]);
+    }
+    return count;
+}
+
+// Write the turning slice's caps after the stickers; returns the number written
+static int buildCaps(State* state, const CubeSnapshot* snapshot, mat4 rotation) {
+    StickerInstance* caps = &state->stickers[state->cube->state.stickerCount];
+    mat4 still[2], turning[2];
+    int cuts = layerCaps(state->cube->size, snapshot->rotatingMove.axis, snapshot->rotatingMove.layer, still, turning);
+
+    for (int i = 0; i < cuts; i++) {
+        glm_mat4_copy(still[i], caps[2 * i].model);
+        glm_mat4_mul(rotation, turning[i], caps[2 * i + 1].model);
+        glm_vec3_copy((float*)stickerColors[CAP_COLOR], caps[2 * i].color);
+        glm_vec3_copy((float*)stickerColors[CAP_COLOR], caps[2 * i + 1].color);
+    }
+    return 2 * cuts;
+}
+
+void initRenderer(State* state) {
+    int size = state->cube->size;
+    int instanceCapacity = STICKER_INSTANCE_COUNT(size);
+    state->stickers = calloc((size_t)instanceCapacity, sizeof(StickerInstance));
+    state->stickerRest = malloc(sizeof(mat4) * (size_t)state->cube->state.stickerCount);
+    state->stickersShown = UINT64_MAX;
+    initStickerGeometry(state);
+
+    glGenBuffers(1, &state->cameraUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, state->cameraUBO);
+    glBufferData(GL_UNIFORM_BUFFER, 2 * sizeof(mat4), NULL, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, CAMERA_BINDING, state->cameraUBO);
+    bindShaderBlock(&state->scene->shader, "Camera", CAMERA_BINDING);
+    setCamera(state, (vec3){(float)size, (float)size, (float)size}, glm_rad(45.0f));
+
+    glGenVertexArrays(1, &state->VAO);
+    glGenBuffers(1, &state->VBO);
+    glGenBuffers(1, &state->EBO);
+    glGenBuffers(1, &state->instanceBuffer);
+
+    glBindVertexArray(state->VAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, state->VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, state->EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(quadIndices), quadIndices, GL_STATIC_DRAW);
+
+    // One StickerInstance per quad: the model matrix takes locations 3-6
+    // (one per column), the colour location 7
+    glBindBuffer(GL_ARRAY_BUFFER, state->instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(StickerInstance) * instanceCapacity, NULL, GL_DYNAMIC_DRAW);
+    for (int i = 0; i < 4; i++) {
+        glVertexAttribPointer(3 + i, 4, GL_FLOAT, GL_FALSE, sizeof(StickerInstance),
+                              (void*)(offsetof(StickerInstance, model) + i * sizeof(vec4)));
+        glEnableVertexAttribArray(3 + i);
+        glVertexAttribDivisor(3 + i, 1);
+    }
+    glVertexAttribPointer(7, 3, GL_FLOAT, GL_FALSE, sizeof(StickerInstance),
+                          (void*)offsetof(StickerInstance, color));
+    glEnableVertexAttribArray(7);
+    glVertexAttribDivisor(7, 1);
+
+    glBindVertexArray(0);
+
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_BACK);
+}
+
+void renderCube(State* state) {
+    glUseProgram(state->scene->shader.program);
+
+    // The camera only reaches the GPU when it changed
+    if (state->camera.dirty) {
+        glBindBuffer(GL_UNIFORM_BUFFER, state->cameraUBO);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(mat4), state->camera.view);
+        glBufferSubData(GL_UNIFORM_BUFFER, sizeof(mat4), sizeof(mat4), state->camera.projection);
+        state->camera.dirty = false;
+    }
+
+    // Everything drawn comes from the latest simulation snapshot. A landed
+    // turn repaints every sticker once; mid-turn only the turning slice
+    // (O(size^2) stickers, from its index list, which never changes) and the
+    // caps move, and a static cube uploads nothing at all
+    Cube* cube = state->cube;
+    const CubeSnapshot* snapshot = latestSnapshot(state);
+    int stickerCount = cube->state.stickerCount;
+    int instanceCount = stickerCount;
+    bool upload = false;
+    if (state->stickersShown != snapshot->stickerVersion) {
+        for (int i = 0; i < stickerCount; i++) {
+            buildSticker(state, snapshot, i, NULL);
+        }
+        state->stickersShown = snapshot->stickerVersion;
+        upload = true;
+    }
+    if (snapshot->isRotating) {
+        mat4 rotation;
+        turnRotation(snapshot, rotation);
+
+        int count;
+        const uint32_t* layer = bigCubeLayerStickers(&cube->state, snapshot->rotatingMove.axis, snapshot->rotatingMove.layer, &count);
+        for (int i = 0; i < count; i++) {
+            buildSticker(state, snapshot, (int)layer[i], rotation);
+        }
+        instanceCount += buildCaps(state, snapshot, rotation);
+        upload = true;
+    }
+
+    if (upload) {
+        // Orphan the previous storage so the upload never waits on the GPU
+        glBindBuffer(GL_ARRAY_BUFFER, state->instanceBuffer);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(StickerInstance) * STICKER_INSTANCE_COUNT(cube->size), NULL, GL_DYNAMIC_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(StickerInstance) * instanceCount, state->stickers);
+    }
+    profileMark(state, PHASE_UPLOAD);
+
+    glBindVertexArray(state->VAO);
+    glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, (void*)0, instanceCount);
+    glBindVertexArray(0);
+}
+
+void destroyRenderer(State* state) {
+    glDeleteVertexArrays(1, &state->VAO);
+    glDeleteBuffers(1, &state->VBO);
+    glDeleteBuffers(1, &state->EBO);
+    glDeleteBuffers(1, &state->instanceBuffer);
+    glDeleteBuffers(1, &state->cameraUBO);
+    free(state->stickers);
+    free(state->stickerRest);
+}
@@ -0,0 +1,166 @@
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "main.h"
+#include "simulation.h"
+
+#define NANOSECONDS 1000000000L
+#define SIMULATION_STEP_NS (NANOSECONDS / SIMULATION_RATE)
+
+static void addNanoseconds(struct timespec* time, long nanoseconds) {
+    time->tv_nsec += nanoseconds;
+    while (time->tv_nsec >= NANOSECONDS) {
+        time->tv_nsec -= NANOSECONDS;
+        time->tv_sec++;
+    }
+}
+
+static bool later(const struct timespec* a, const struct timespec* b) {
+    return a->tv_sec > b->tv_sec || (a->tv_sec == b->tv_sec && a->tv_nsec > b->tv_nsec);
+}
+
+// Fill the back slot from the cube; stickers are only copied when they changed since that slot last held them
+static void publishSnapshot(State* state) {
+    Simulation* simulation = state->simulation;
+    Cube* cube = state->cube;
+    CubeSnapshot* snapshot = tripleBufferBack(&simulation->snapshots);
+
+    if (snapshot->stickerVersion != simulation->stickerVersion) {
+        memcpy(snapshot->stickers, cube->state.stickers, (size_t)cube->state.stickerCount);
+        snapshot->stickerVersion = simulation->stickerVersion;
+    }
+    snapshot->consumed = simulation->consumed;
+    snapshot->isRotating = cube->isRotating;
+    snapshot->rotatingMove = cube->rotating_move;
+    snapshot->rotatingTarget = cube->rotating_target;
+    snapshot->rotationProgress = cube->rotation_progress;
+    tripleBufferPublish(&simulation->snapshots);
+}
+
+/**
+ * One tick every 1/SIMULATION_RATE s on an absolute schedule, so sleeping
+ * late never accumulates drift. Behind schedule, ticks run back to back
+ * until caught up; more than SIMULATION_MAX_LAG behind (the process was
+ * stopped, say) the missed time is dropped instead. A tick that changed
+ * nothing publishes nothing.
+ */
+static void* simulationThread(void* arg) {
+    State* state = arg;
+    Simulation* simulation = state->simulation;
+    Cube* cube = state->cube;
+
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (atomic_load_explicit(&simulation->running, memory_order_acquire)) {
+        struct timespec tickStart;
+        clock_gettime(CLOCK_MONOTONIC, &tickStart);
+        updateCubelets(state, 1.0f / SIMULATION_RATE);
+
+        size_t consumed = atomic_load_explicit(&cube->queue.head, memory_order_relaxed);
+        if (cube->isRotating || consumed != simulation->consumed || state->stickersDirty) {
+            if (state->stickersDirty) simulation->stickerVersion++;
+            state->stickersDirty = false;
+            simulation->consumed = consumed;
+            publishSnapshot(state);
+        }
+
+        struct timespec current;
+        clock_gettime(CLOCK_MONOTONIC, &current);
+        uint32_t tick = (uint32_t)((current.tv_sec - tickStart.tv_sec) * NANOSECONDS + (current.tv_nsec - tickStart.tv_nsec));
+        uint32_t slowest = atomic_load_explicit(&simulation->slowestTick, memory_order_relaxed);
+        while (tick > slowest && !atomic_compare_exchange_weak_explicit(&simulation->slowestTick, &slowest, tick,
+                                                                        memory_order_relaxed, memory_order_relaxed)) {}
+
+        addNanoseconds(&next, SIMULATION_STEP_NS);
+        struct timespec limit = next;
+        addNanoseconds(&limit, SIMULATION_MAX_LAG * SIMULATION_STEP_NS);
+        if (later(&current, &limit)) next = current;
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+    }
+    return NULL;
+}
+
+static void freeSnapshots(Simulation* simulation) {
+    for (int i = 0; i < 3; i++) free(simulation->slots[i].stickers);
+    free(simulation);
+}
+
+/**
+ * Hand the cube over to the simulation thread. Until stopSimulation the
+ * main thread must only queue moves and read snapshots; anything set up
+ * before (a replay applied instantly, say) is in the first snapshot.
+ */
+bool startSimulation(State* state) {
+    Cube* cube = state->cube;
+    Simulation* simulation = calloc(1, sizeof(Simulation));
+    if (!simulation) {
+        fprintf(stderr, "Failed to allocate the simulation\n");
+        return false;
+    }
+
+    for (int i = 0; i < 3; i++) {
+        CubeSnapshot* slot = &simulation->slots[i];
+        slot->stickers = malloc((size_t)cube->state.stickerCount);
+        if (!slot->stickers) {
+            freeSnapshots(simulation);
+            return false;
+        }
+        memcpy(slot->stickers, cube->state.stickers, (size_t)cube->state.stickerCount);
+        slot->consumed = atomic_load_explicit(&cube->queue.head, memory_order_relaxed);
+        slot->isRotating = false;
+    }
+    simulation->consumed = simulation->slots[0].consumed;
+    state->stickersDirty = false;
+    tripleBufferInit(&simulation->snapshots, &simulation->slots[0], &simulation->slots[1], &simulation->slots[2]);
+
+    state->simulation = simulation;
+    atomic_init(&simulation->running, true);
+    atomic_init(&simulation->slowestTick, 0);
+    if (pthread_create(&simulation->thread, NULL, simulationThread, state) != 0) {
+        fprintf(stderr, "Could not start the simulation thread\n");
+        state->simulation = NULL;
+        freeSnapshots(simulation);
+        return false;
+    }
+    return true;
+}
+
+// Join the simulation thread; the cube is the caller's again afterwards
+void stopSimulation(State* state) {
+    Simulation* simulation = state->simulation;
+    if (!simulation) return;
+
+    atomic_store_explicit(&simulation->running, false, memory_order_release);
+    pthread_join(simulation->thread, NULL);
+    state->simulation = NULL;
+    freeSnapshots(simulation);
+}
+
+// Main thread only: the newest snapshot, valid until the next call; taking a new one owes a frame
+const CubeSnapshot* latestSnapshot(State* state) {
+    bool fresh;
+    const CubeSnapshot* snapshot = tripleBufferLatest(&state->simulation->snapshots, &fresh);
+    if (fresh) state->frames.redraw = true;
+    return snapshot;
+}
+
+// Main thread only: whether the simulation published since the last latestSnapshot
+bool snapshotPending(State* state) {
+    return tripleBufferPending(&state->simulation->snapshots);
+}
+
+/**
+ * True if the snapshot is the cube at rest with every queued turn applied,
+ * i.e. the state the cube will stay in until something else is queued.
+ * Only meaningful on the thread that queues moves.
+ */
+bool snapshotSettled(State* state, const CubeSnapshot* snapshot) {
+    return !snapshot->isRotating &&
+           snapshot->consumed == atomic_load_explicit(&state->cube->queue.tail, memory_order_relaxed);
+}
+
+// Milliseconds of the slowest simulation tick since the last call, for the profiler
+float takeSlowestTick(State* state) {
+    if (!state->simulation) return 0.0f;
+    return (float)atomic_exchange_explicit(&state->simulation->slowestTick, 0, memory_order_relaxed) * 1e-6f;
+}
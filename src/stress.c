@@ -0,0 +1,361 @@
+#include <stdlib.h>
+#include <string.h>
+#include "main.h"
+#include "render.h"
+#include "profiler.h"
+#include "stress.h"
+#include "offscreen.h"
+
+// Same unit quad as the single cube, see render.c
+static const float quadVertices[4 * 3] = {
+    -0.5f, -0.5f, 0.0f,
+     0.5f, -0.5f, 0.0f,
+     0.5f,  0.5f, 0.0f,
+    -0.5f,  0.5f, 0.0f,
+};
+
+static const GLuint quadIndices[6] = {
+    0, 1, 2,
+    2, 3, 0,
+};
+
+// Layout of a GL_DRAW_INDIRECT_BUFFER entry for glDrawElementsIndirect
+typedef struct {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+} DrawElementsCommand;
+
+static double secondsSince(Uint64 since, Uint64 until) {
+    return (double)(until - since) / (double)SDL_GetPerformanceFrequency();
+}
+
+// Worker side: advance a range of cubes, then pack the visible ones for upload
+static void stepRange(void* arg, int worker) {
+    (void)worker;
+    StressRange* range = arg;
+    Stress* stress = range->stress;
+    CubeFarm* farm = &stress->farm;
+
+    range->landed = cubeFarmUpdate(farm, range->first, range->last, stress->seconds);
+
+    int visible = 0;
+    for (int i = range->first; i < range->last; i++) {
+        const FarmCube* cube = &farm->cubes[i];
+        if (!cubeFarmVisible(cube, (const float (*)[4])stress->planes)) continue;
+
+        int slot = range->first + visible++;
+        StressCube* data = &stress->cubes[slot];
+        LayerMove move;
+        float angle;
+        bool turning = cubeFarmTurn(farm, cube, &move, &angle);
+        memcpy(data->center, cube->center, sizeof(data->center));
+        data->angle = turning ? angle : 0.0f;
+        data->axis = turning ? (float)move.axis : 0.0f;
+        data->layer = turning ? (float)move.layer : 0.0f;
+        data->turning = turning ? 1.0f : 0.0f;
+        memcpy(stress->stickers + (size_t)slot * STRESS_PIECES, cube->facelets.f, FACELET_COUNT);
+    }
+    range->visible = visible;
+}
+
+// Rest transforms and colours shared by every cube, uploaded once
+static void uploadPieces(Stress* stress) {
+    StressPieces pieces;
+    memset(&pieces, 0, sizeof(pieces));
+    for (int i = 0; i < FACELET_COUNT; i++) stickerRestMatrix(3, i, pieces.rest[i]);
+    for (int axis = 0; axis < 3; axis++) {
+        for (int side = 0; side < 2; side++) {
+            mat4 still[2], turning[2];
+            layerCaps(3, axis, side * 2, still, turning);
+            glm_mat4_copy(still[0], pieces.rest[FACELET_COUNT + (axis * 2 + side) * 2]);
+            glm_mat4_copy(turning[0], pieces.rest[FACELET_COUNT + (axis * 2 + side) * 2 + 1]);
+        }
+    }
+    for (int i = 0; i <= CAP_COLOR; i++) {
+        memcpy(pieces.palette[i], stickerColors[i], sizeof(vec3));
+        pieces.palette[i][3] = 1.0f;
+    }
+
+    glGenBuffers(1, &stress->piecesUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, stress->piecesUBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(pieces), &pieces, GL_STATIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, STRESS_PIECES_BINDING, stress->piecesUBO);
+    bindShaderBlock(&stress->shader, "Pieces", STRESS_PIECES_BINDING);
+    bindShaderBlock(&stress->shader, "Camera", CAMERA_BINDING);
+}
+
+static void initStressBuffers(Stress* stress) {
+    glGenVertexArrays(1, &stress->VAO);
+    glGenBuffers(1, &stress->VBO);
+    glGenBuffers(1, &stress->EBO);
+    glBindVertexArray(stress->VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, stress->VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, stress->EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(quadIndices), quadIndices, GL_STATIC_DRAW);
+    glBindVertexArray(0);
+
+    // Per-cube data lives in buffer textures the vertex shader fetches from by instance
+    size_t count = (size_t)stress->farm.count;
+    glGenBuffers(1, &stress->cubeBuffer);
+    glGenBuffers(1, &stress->stickerBuffer);
+    glGenTextures(2, stress->textures);
+    glBindBuffer(GL_TEXTURE_BUFFER, stress->cubeBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, sizeof(StressCube) * count, NULL, GL_STREAM_DRAW);
+    glBindTexture(GL_TEXTURE_BUFFER, stress->textures[0]);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, stress->cubeBuffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, stress->stickerBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, STRESS_PIECES * count, NULL, GL_STREAM_DRAW);
+    glBindTexture(GL_TEXTURE_BUFFER, stress->textures[1]);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_R8UI, stress->stickerBuffer);
+
+    glUseProgram(stress->shader.program);
+    setUniformInt(findShaderUniform(&stress->shader, "cubes"), 0);
+    setUniformInt(findShaderUniform(&stress->shader, "stickers"), 1);
+
+    stress->indirect = GLEW_ARB_draw_indirect;
+    if (stress->indirect) {
+        glGenBuffers(1, &stress->indirectBuffer);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, stress->indirectBuffer);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(DrawElementsCommand), NULL, GL_STREAM_DRAW);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+}
+
+static void destroyStress(Stress* stress) {
+    if (stress->VAO) {
+        glDeleteVertexArrays(1, &stress->VAO);
+        glDeleteBuffers(1, &stress->VBO);
+        glDeleteBuffers(1, &stress->EBO);
+        glDeleteBuffers(1, &stress->cubeBuffer);
+        glDeleteBuffers(1, &stress->stickerBuffer);
+        glDeleteBuffers(1, &stress->piecesUBO);
+        if (stress->indirectBuffer) glDeleteBuffers(1, &stress->indirectBuffer);
+        glDeleteTextures(2, stress->textures);
+    }
+    if (stress->shader.program) glDeleteProgram(stress->shader.program);
+    if (stress->ranges) workPoolDestroy(&stress->pool);
+    free(stress->ranges);
+    free(stress->cubes);
+    free(stress->stickers);
+    cubeFarmFree(&stress->farm);
+}
+
+/**
+ * Scripts end in the solver's solutions when its tables can be had (they
+ * are built and cached on the first run, like for the S key), and in the
+ * scrambles undone otherwise.
+ */
+static bool initStress(State* state, Stress* stress, int count, const char* shaderDir, const char* shaderCache) {
+    char cachePath[1024];
+    if (shaderCache) snprintf(cachePath, sizeof(cachePath), "%s.stress", shaderCache);
+    if (!loadShaderFiles(shaderDir, "stressVertex.glsl", "fragment.glsl", shaderCache ? cachePath : NULL,
+                         &stress->shader)) {
+        fprintf(stderr, "Failed to create the stress shader program.\n");
+        return false;
+    }
+
+    if (!cubeFarmInit(&stress->farm, count, STRESS_SCRIPTS, STRESS_TURN_DURATION) ||
+        !workPoolInit(&stress->pool, 0)) {
+        fprintf(stderr, "Could not set up %d cubes\n", count);
+        return false;
+    }
+    stress->rangeCount = stress->pool.threads * STRESS_RANGES_PER_THREAD;
+    if (stress->rangeCount > count) stress->rangeCount = count;
+    stress->ranges = calloc((size_t)stress->rangeCount, sizeof(StressRange));
+    stress->cubes = malloc(sizeof(StressCube) * (size_t)count);
+    stress->stickers = malloc((size_t)STRESS_PIECES * (size_t)count);
+    if (!stress->ranges || !stress->cubes || !stress->stickers) {
+        fprintf(stderr, "Could not set up %d cubes\n", count);
+        if (!stress->ranges) workPoolDestroy(&stress->pool);
+        return false;
+    }
+    for (int i = 0; i < stress->rangeCount; i++) {
+        stress->ranges[i].stress = stress;
+        stress->ranges[i].first = (int)((long)count * i / stress->rangeCount);
+        stress->ranges[i].last = (int)((long)count * (i + 1) / stress->rangeCount);
+    }
+
+    if (!state->solver) {
+        state->solver = malloc(sizeof(Solver));
+        if (!state->solver || !solverInitCached(state->solver, SOLVER_TABLE_PATH, 0)) {
+            fprintf(stderr, "No solver tables, the cubes will undo their scrambles instead\n");
+            free(state->solver);
+            state->solver = NULL;
+        }
+    }
+    Uint64 start = SDL_GetPerformanceCounter();
+    cubeFarmBuildScripts(&stress->farm, state->solver, &stress->pool, (uint32_t)start);
+    cubeFarmStart(&stress->farm, (uint32_t)start);
+    printf("%d scripts ready in %.2f s\n", STRESS_SCRIPTS, secondsSince(start, SDL_GetPerformanceCounter()));
+
+    initStressBuffers(stress);
+    uploadPieces(stress);
+    return true;
+}
+
+/**
+ * Above the middle of the grid, looking out and down at a point circling
+ * it, so the cubes in view (and those culled) keep changing.
+ */
+static void aimCamera(State* state, Stress* stress, float yaw) {
+    float extent = 0.5f * sqrtf((float)stress->farm.count) * CUBE_FARM_SPACING;
+    float height = fmaxf(8.0f, 0.2f * extent);
+    vec3 eye = {0.0f, height, 0.0f};
+    vec3 target = {0.5f * extent * cosf(yaw), 0.0f, 0.5f * extent * sinf(yaw)};
+    glm_lookat(eye, target, (vec3){0.0f, 1.0f, 0.0f}, state->camera.view);
+    glm_perspective(glm_rad(60.0f), (float)WIDTH / (float)HEIGHT, 0.5f, 3.0f * extent + height, state->camera.projection);
+
+    mat4 viewProjection;
+    glm_mat4_mul(state->camera.projection, state->camera.view, viewProjection);
+    glm_frustum_planes(viewProjection, stress->planes);
+
+    glBindBuffer(GL_UNIFORM_BUFFER, state->cameraUBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(mat4), state->camera.view);
+    glBufferSubData(GL_UNIFORM_BUFFER, sizeof(mat4), sizeof(mat4), state->camera.projection);
+}
+
+// Upload every range's packed cubes back to back; returns how many there are
+static int uploadVisible(Stress* stress) {
+    glBindBuffer(GL_TEXTURE_BUFFER, stress->cubeBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, sizeof(StressCube) * (size_t)stress->farm.count, NULL, GL_STREAM_DRAW);
+    int visible = 0;
+    for (int i = 0; i < stress->rangeCount; i++) {
+        const StressRange* range = &stress->ranges[i];
+        glBufferSubData(GL_TEXTURE_BUFFER, sizeof(StressCube) * (size_t)visible, sizeof(StressCube) * (size_t)range->visible,
+                        &stress->cubes[range->first]);
+        visible += range->visible;
+    }
+
+    glBindBuffer(GL_TEXTURE_BUFFER, stress->stickerBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, (size_t)STRESS_PIECES * (size_t)stress->farm.count, NULL, GL_STREAM_DRAW);
+    visible = 0;
+    for (int i = 0; i < stress->rangeCount; i++) {
+        const StressRange* range = &stress->ranges[i];
+        glBufferSubData(GL_TEXTURE_BUFFER, (size_t)STRESS_PIECES * (size_t)visible, (size_t)STRESS_PIECES * (size_t)range->visible,
+                        stress->stickers + (size_t)STRESS_PIECES * (size_t)range->first);
+        visible += range->visible;
+    }
+    return visible;
+}
+
+static void drawStress(Stress* stress, int visible) {
+    glUseProgram(stress->shader.program);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_BUFFER, stress->textures[0]);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_BUFFER, stress->textures[1]);
+    glActiveTexture(GL_TEXTURE0);
+
+    glBindVertexArray(stress->VAO);
+    GLuint instances = (GLuint)visible * STRESS_PIECES;
+    if (stress->indirect) {
+        DrawElementsCommand command = {6, instances, 0, 0, 0};
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, stress->indirectBuffer);
+        glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(command), &command);
+        glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    } else {
+        glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, (void*)0, (GLsizei)instances);
+    }
+    glBindVertexArray(0);
+}
+
+/**
+ * Every STRESS_REPORT_INTERVAL: frame rate, cubes drawn and the 60 FPS
+ * capacity the frame time implies, to stdout and the title. A shorter
+ * interval left at exit is only part of the overall summary.
+ */
+static void report(State* state, Stress* stress, Uint64 current) {
+    double elapsed = secondsSince(stress->reportStart, current);
+    if (stress->reportFrames == 0 || elapsed < STRESS_REPORT_INTERVAL) return;
+
+    int count = stress->farm.count;
+    double frameSeconds = elapsed / stress->reportFrames;
+    double drawn = (double)stress->reportDrawn / stress->reportFrames;
+    char line[256];
+    snprintf(line, sizeof(line), "%d cubes, %.0f%% drawn, %.1f FPS (%.2f ms), %.0f turns/s, ~%.0f cubes/frame at 60 FPS",
+             count, 100.0 * drawn / count, 1.0 / frameSeconds, frameSeconds * 1000.0,
+             (double)stress->reportTurns / elapsed, count / (frameSeconds * 60.0));
+    printf("%s\n", line);
+    char title[320];
+    snprintf(title, sizeof(title), "%s | %s", WINDOW_TITLE, line);
+    SDL_SetWindowTitle(state->scene->window, title);
+
+    stress->reportStart = current;
+    stress->reportFrames = 0;
+    stress->reportDrawn = 0;
+    stress->reportTurns = 0;
+}
+
+/**
+ * Run the stress scene until the window closes, in place of the single
+ * cube. Needs the renderer initialised (for the camera buffer). Returns
+ * false if the scene could not be set up.
+ */
+bool runStress(State* state, int count, const char* shaderDir, const char* shaderCache) {
+    Stress stress;
+    memset(&stress, 0, sizeof(stress));
+    if (!initStress(state, &stress, count, shaderDir, shaderCache)) {
+        destroyStress(&stress);
+        return false;
+    }
+    SDL_GL_SetSwapInterval(0);
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    Uint64 previous = start;
+    Uint64 totalFrames = 0;
+    stress.reportStart = start;
+    while (state->isActive) {
+        while (SDL_PollEvent(&state->event)) {
+            if (state->event.type == SDL_QUIT ||
+                (state->event.type == SDL_KEYDOWN && state->event.key.keysym.sym == SDLK_ESCAPE)) {
+                state->isActive = false;
+            }
+        }
+        profileResume(state);
+
+        Uint64 current = SDL_GetPerformanceCounter();
+        stress.seconds = fminf((float)secondsSince(previous, current), 0.1f);
+        previous = current;
+        aimCamera(state, &stress, 0.05f * (float)secondsSince(start, current));
+        profileMark(state, PHASE_EVENTS);
+
+        // A range the pool cannot take is stepped here rather than drawn stale
+        for (int i = 0; i < stress.rangeCount; i++) {
+            if (!workPoolSubmit(&stress.pool, stepRange, &stress.ranges[i])) stepRange(&stress.ranges[i], -1);
+        }
+        workPoolWait(&stress.pool);
+
+        profileFrameBegin(state);
+        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        int visible = uploadVisible(&stress);
+        profileMark(state, PHASE_UPLOAD);
+        drawStress(&stress, visible);
+        profileSubmitted(state);
+        presentFrame(state);
+        profileFrameEnd(state);
+
+        for (int i = 0; i < stress.rangeCount; i++) stress.reportTurns += (uint64_t)stress.ranges[i].landed;
+        stress.reportDrawn += (uint64_t)visible;
+        stress.reportFrames++;
+        totalFrames++;
+        report(state, &stress, SDL_GetPerformanceCounter());
+    }
+
+    double elapsed = secondsSince(start, SDL_GetPerformanceCounter());
+    if (totalFrames > 0) {
+        printf("Overall: %llu frames in %.1f s, %.1f FPS, ~%.0f cubes/frame at 60 FPS\n",
+               (unsigned long long)totalFrames, elapsed, totalFrames / elapsed,
+               count * (totalFrames / elapsed) / 60.0);
+    }
+    SDL_SetWindowTitle(state->scene->window, WINDOW_TITLE);
+    destroyStress(&stress);
+    return true;
+}
@@ -1,7 +1,10 @@
 #include <GL/glew.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include "utils.h"
+#include "tablestore.h"
+#include "shadersources.h"
 
 char* readFile(const char* filename) {
     FILE* file = fopen(filename, "r");
@@ -14,20 +17,21 @@ char* readFile(const char* filename) {
     long length = ftell(file);
     rewind(file);
     char* buffer = (char*)malloc(length + 1);
-    fread(buffer, 1, length, file);
-    buffer[length] = '\0';
+    if (!buffer) {
+        fclose(file);
+        return NULL;
+    }
+    size_t read = fread(buffer, 1, length, file);
+    buffer[read] = '\0';
     fclose(file);
     return buffer;
 }
 
-GLuint compileShader(const char* path, GLenum shaderType) {
-    char* source = readFile(path);
-    if (!source) return 0;
-
+// Compile one stage; on failure the log goes to stderr and nothing is left behind
+GLuint compileShader(const char* source, GLenum shaderType) {
     GLuint shader = glCreateShader(shaderType);
     glShaderSource(shader, 1, (const GLchar* const*)&source, NULL);
     glCompileShader(shader);
-    free(source);
 
     int success;
     glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
@@ -35,32 +39,259 @@ GLuint compileShader(const char* path, GLenum shaderType) {
         char infoLog[512];
         glGetShaderInfoLog(shader, 512, NULL, infoLog);
         fprintf(stderr, "ERROR::SHADER::COMPILATION_FAILED\n%s\n", infoLog);
+        glDeleteShader(shader);
         return 0;
     }
     return shader;
 }
 
-GLuint createShaderProgram(const char* vertexPath, const char* fragmentPath) {
-    GLuint vertexShader = compileShader(vertexPath, GL_VERTEX_SHADER);
-    GLuint fragmentShader = compileShader(fragmentPath, GL_FRAGMENT_SHADER);
-    if (!vertexShader || !fragmentShader) return 0;
+GLuint createShaderProgram(const char* vertexSource, const char* fragmentSource) {
+    GLuint vertexShader = compileShader(vertexSource, GL_VERTEX_SHADER);
+    GLuint fragmentShader = compileShader(fragmentSource, GL_FRAGMENT_SHADER);
+    if (!vertexShader || !fragmentShader) {
+        glDeleteShader(vertexShader);
+        glDeleteShader(fragmentShader);
+        return 0;
+    }
 
     GLuint program = glCreateProgram();
+    if (GLEW_ARB_get_program_binary) glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glAttachShader(program, vertexShader);
     glAttachShader(program, fragmentShader);
     glLinkProgram(program);
 
+    // The program keeps what it needs, so the stages go whether or not the link worked
+    glDetachShader(program, vertexShader);
+    glDetachShader(program, fragmentShader);
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
     int success;
     glGetProgramiv(program, GL_LINK_STATUS, &success);
     if (!success) {
         char infoLog[512];
         glGetProgramInfoLog(program, 512, NULL, infoLog);
         fprintf(stderr, "ERROR::PROGRAM::LINKING_FAILED\n%s\n", infoLog);
+        glDeleteProgram(program);
         return 0;
     }
+    return program;
+}
 
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+static bool programBinariesSupported(void) {
+    if (!GLEW_ARB_get_program_binary) return false;
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+}
+
+/**
+ * What a cached binary is only valid for: the driver that produced it
+ * (vendor, renderer and version strings) and the exact sources, so a driver
+ * update or an edited shader misses the cache instead of loading stale code.
+ */
+static uint64_t programCacheKey(const char* vertexSource, const char* fragmentSource) {
+    const GLenum names[] = {GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION};
+    uint64_t key = PROGRAM_CACHE_VERSION;
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        const char* value = (const char*)glGetString(names[i]);
+        if (value) key = tableChecksum(key, value, strlen(value) + 1);
+    }
+    key = tableChecksum(key, vertexSource, strlen(vertexSource) + 1);
+    return tableChecksum(key, fragmentSource, strlen(fragmentSource) + 1);
+}
 
+// A program from the cache file, or 0 if there is none for this key or the driver turns it down
+static GLuint loadProgramBinary(const char* path, uint64_t key) {
+    TableStoreMap map;
+    if (!tableStoreOpen(path, PROGRAM_CACHE_NAME, key, 0, TABLE_STORE_VERIFY, &map)) return 0;
+
+    GLuint program = 0;
+    ProgramBinaryHeader header;
+    if (map.size >= sizeof(header)) {
+        memcpy(&header, map.data, sizeof(header));
+        TableSection sections[2] = {{NULL, sizeof(header)}, {NULL, header.length}};
+        size_t offset = tableSectionOffset(sections, 1);
+        if (offset + header.length <= map.size) {
+            program = glCreateProgram();
+            glProgramBinary(program, header.format, map.data + offset, (GLsizei)header.length);
+
+            GLint linked = 0;
+            glGetProgramiv(program, GL_LINK_STATUS, &linked);
+            if (!linked) {
+                fprintf(stderr, "The driver rejected the cached shader program, compiling it\n");
+                glDeleteProgram(program);
+                program = 0;
+                while (glGetError() != GL_NO_ERROR) {}
+            }
+        }
+    }
+    tableStoreClose(&map);
     return program;
 }
+
+static void storeProgramBinary(const char* path, uint64_t key, GLuint program) {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+
+    void* binary = malloc((size_t)length);
+    if (!binary) return;
+    GLsizei written = 0;
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &written, &format, binary);
+    if (written > 0) {
+        ProgramBinaryHeader header = {format, (uint32_t)written};
+        TableSection sections[2] = {{&header, sizeof(header)}, {binary, (size_t)written}};
+        tableStoreWrite(path, PROGRAM_CACHE_NAME, key, sections, 2);
+    }
+    free(binary);
+}
+
+/**
+ * Link a program from GLSL sources and reflect it. With cachePath (and a
+ * driver that can hand out program binaries) the linked binary is kept in
+ * that file and reused on the next start, skipping compilation entirely;
+ * a missing, stale or rejected cache just means compiling as usual.
+ */
+bool loadShaderProgram(const char* vertexSource, const char* fragmentSource, const char* cachePath, ShaderProgram* shader) {
+    bool cacheable = cachePath && programBinariesSupported();
+    uint64_t key = cacheable ? programCacheKey(vertexSource, fragmentSource) : 0;
+    GLuint program = cacheable ? loadProgramBinary(cachePath, key) : 0;
+    bool cached = program != 0;
+    if (!program) program = createShaderProgram(vertexSource, fragmentSource);
+    if (!program) return false;
+
+    if (!reflectShaderProgram(program, shader)) {
+        glDeleteProgram(program);
+        return false;
+    }
+    if (cacheable && !cached) storeProgramBinary(cachePath, key, program);
+    return true;
+}
+
+// The copy of shaders/<name> built into the binary, or NULL
+static const char* embeddedShader(const char* name) {
+    for (int i = 0; i < EMBEDDED_SHADER_COUNT; i++) {
+        if (strcmp(embeddedShaders[i].name, name) == 0) return embeddedShaders[i].source;
+    }
+    fprintf(stderr, "No shader %s was built in\n", name);
+    return NULL;
+}
+
+/**
+ * loadShaderProgram on two files of the shaders/ directory, by name: the
+ * copies built into the binary, or with shaderDir the files in it, for
+ * editing shaders without rebuilding.
+ */
+bool loadShaderFiles(const char* shaderDir, const char* vertexName, const char* fragmentName, const char* cachePath,
+                     ShaderProgram* shader) {
+    if (!shaderDir) {
+        const char* vertexSource = embeddedShader(vertexName);
+        const char* fragmentSource = embeddedShader(fragmentName);
+        return vertexSource && fragmentSource && loadShaderProgram(vertexSource, fragmentSource, cachePath, shader);
+    }
+
+    char vertexPath[1024], fragmentPath[1024];
+    snprintf(vertexPath, sizeof(vertexPath), "%s/%s", shaderDir, vertexName);
+    snprintf(fragmentPath, sizeof(fragmentPath), "%s/%s", shaderDir, fragmentName);
+    char* vertexSource = readFile(vertexPath);
+    char* fragmentSource = readFile(fragmentPath);
+    bool ok = vertexSource && fragmentSource && loadShaderProgram(vertexSource, fragmentSource, cachePath, shader);
+    free(vertexSource);
+    free(fragmentSource);
+    return ok;
+}
+
+/**
+ * Record every active uniform and uniform block of a linked program. Uniforms
+ * that live inside a block have no location and are only reachable through
+ * the block, so they are left out of the uniform list.
+ */
+bool reflectShaderProgram(GLuint program, ShaderProgram* shader) {
+    memset(shader, 0, sizeof(ShaderProgram));
+    shader->program = program;
+
+    GLint uniformCount = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &uniformCount);
+    for (GLuint i = 0; i < (GLuint)uniformCount; i++) {
+        GLint blockIndex = -1;
+        glGetActiveUniformsiv(program, 1, &i, GL_UNIFORM_BLOCK_INDEX, &blockIndex);
+        if (blockIndex != -1) continue;
+
+        if (shader->uniformCount >= SHADER_MAX_UNIFORMS) {
+            fprintf(stderr, "Too many uniforms in program %u\n", program);
+            return false;
+        }
+
+        ShaderUniform* uniform = &shader->uniforms[shader->uniformCount++];
+        glGetActiveUniform(program, i, SHADER_NAME_LENGTH, NULL, &uniform->size, &uniform->type, uniform->name);
+
+        // Arrays reflect as "name[0]"; keep the plain name for lookups
+        char* bracket = strchr(uniform->name, '[');
+        if (bracket) *bracket = '\0';
+        uniform->location = glGetUniformLocation(program, uniform->name);
+    }
+
+    GLint blockCount = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount);
+    if (blockCount > SHADER_MAX_BLOCKS) {
+        fprintf(stderr, "Too many uniform blocks in program %u\n", program);
+        return false;
+    }
+    for (GLuint i = 0; i < (GLuint)blockCount; i++) {
+        ShaderBlock* block = &shader->blocks[shader->blockCount++];
+        block->index = i;
+        glGetActiveUniformBlockName(program, i, SHADER_NAME_LENGTH, NULL, block->name);
+        glGetActiveUniformBlockiv(program, i, GL_UNIFORM_BLOCK_DATA_SIZE, &block->dataSize);
+        GLint binding = 0;
+        glGetActiveUniformBlockiv(program, i, GL_UNIFORM_BLOCK_BINDING, &binding);
+        block->binding = (GLuint)binding;
+    }
+
+    return true;
+}
+
+// Lookups are for setup code; keep the returned pointer rather than calling this per frame
+const ShaderUniform* findShaderUniform(const ShaderProgram* shader, const char* name) {
+    for (int i = 0; i < shader->uniformCount; i++) {
+        if (strcmp(shader->uniforms[i].name, name) == 0) return &shader->uniforms[i];
+    }
+    return NULL;
+}
+
+const ShaderBlock* findShaderBlock(const ShaderProgram* shader, const char* name) {
+    for (int i = 0; i < shader->blockCount; i++) {
+        if (strcmp(shader->blocks[i].name, name) == 0) return &shader->blocks[i];
+    }
+    return NULL;
+}
+
+bool bindShaderBlock(ShaderProgram* shader, const char* name, GLuint binding) {
+    for (int i = 0; i < shader->blockCount; i++) {
+        ShaderBlock* block = &shader->blocks[i];
+        if (strcmp(block->name, name) == 0) {
+            glUniformBlockBinding(shader->program, block->index, binding);
+            block->binding = binding;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Typed setters act on the bound program; a NULL uniform (optimised out) is a no-op
+void setUniformInt(const ShaderUniform* uniform, int value) {
+    if (uniform) glUniform1i(uniform->location, value);
+}
+
+void setUniformFloat(const ShaderUniform* uniform, float value) {
+    if (uniform) glUniform1f(uniform->location, value);
+}
+
+void setUniformVec3(const ShaderUniform* uniform, const float* value) {
+    if (uniform) glUniform3fv(uniform->location, uniform->size, value);
+}
+
+void setUniformMat4(const ShaderUniform* uniform, const float* value) {
+    if (uniform) glUniformMatrix4fv(uniform->location, uniform->size, GL_FALSE, value);
+}
@@ -0,0 +1,83 @@
+#include <stdio.h>
+#include "movequeue.h"
+
+/**
+ * The move queue's folding rules, which the S key counts on to turn its
+ * queued pairs of quarter turns back into half turns, and its capacity.
+ */
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    if (ok) return;
+    fprintf(stderr, "FAIL: %s\n", what);
+    failures++;
+}
+
+static LayerMove layerMove(int axis, int layer, int turns) {
+    LayerMove move = {(uint8_t)axis, (uint8_t)layer, (uint8_t)turns};
+    return move;
+}
+
+static bool isMove(LayerMove move, int axis, int layer, int turns) {
+    return move.axis == axis && move.layer == layer && move.turns == turns;
+}
+
+static void testCoalescing(void) {
+    MoveQueue queue;
+    LayerMove move;
+
+    moveQueueInit(&queue);
+    moveQueuePush(&queue, layerMove(0, 2, 1));
+    moveQueuePush(&queue, layerMove(0, 2, 1));
+    check(moveQueuePopCoalesced(&queue, &move) && isMove(move, 0, 2, 2), "R R pops as R2");
+    check(moveQueueSize(&queue) == 0, "R R is taken off the queue whole");
+
+    moveQueueInit(&queue);
+    moveQueuePush(&queue, layerMove(0, 2, 1));
+    moveQueuePush(&queue, layerMove(0, 2, 3));
+    check(!moveQueuePopCoalesced(&queue, &move), "R R' pops as nothing");
+    check(moveQueueSize(&queue) == 0, "R R' is taken off the queue");
+
+    moveQueueInit(&queue);
+    moveQueuePush(&queue, layerMove(0, 2, 1));
+    moveQueuePush(&queue, layerMove(0, 2, 3));
+    moveQueuePush(&queue, layerMove(1, 0, 1));
+    check(moveQueuePopCoalesced(&queue, &move) && isMove(move, 1, 0, 1), "the move after R R' comes out next");
+
+    moveQueueInit(&queue);
+    for (int i = 0; i < 3; i++) moveQueuePush(&queue, layerMove(0, 2, 1));
+    check(moveQueuePopCoalesced(&queue, &move) && isMove(move, 0, 2, 3), "R R R pops as R'");
+
+    moveQueueInit(&queue);
+    moveQueuePush(&queue, layerMove(0, 2, 1));
+    moveQueuePush(&queue, layerMove(0, 1, 1));
+    moveQueuePush(&queue, layerMove(0, 2, 1));
+    check(moveQueuePopCoalesced(&queue, &move) && isMove(move, 0, 2, 1), "other layers of the axis stay apart");
+    check(moveQueuePopCoalesced(&queue, &move) && isMove(move, 0, 1, 1), "moves come out in order");
+    check(moveQueuePopCoalesced(&queue, &move) && isMove(move, 0, 2, 1), "only neighbouring moves fold");
+    check(!moveQueuePopCoalesced(&queue, &move), "the queue ends empty");
+}
+
+static void testCapacity(void) {
+    MoveQueue queue;
+    LayerMove move;
+    moveQueueInit(&queue);
+
+    bool ok = true;
+    for (int i = 0; i < MOVE_QUEUE_CAPACITY; i++) ok = ok && moveQueuePush(&queue, layerMove(i % 3, 0, 1));
+    check(ok, "a queue takes MOVE_QUEUE_CAPACITY moves");
+    check(!moveQueuePush(&queue, layerMove(0, 0, 1)), "a full queue rejects the next push");
+    check(moveQueueSize(&queue) == MOVE_QUEUE_CAPACITY, "a rejected push leaves the queue as it was");
+
+    check(moveQueuePop(&queue, &move) && isMove(move, 0, 0, 1), "the first move pushed comes out first");
+    check(moveQueuePush(&queue, layerMove(2, 1, 2)), "a pop makes room for one more");
+}
+
+int main(void) {
+    testCoalescing();
+    testCapacity();
+
+    if (failures == 0) printf("movequeue: all checks passed\n");
+    return failures == 0 ? 0 : 1;
+}
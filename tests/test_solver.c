@@ -0,0 +1,58 @@
+#include <stdio.h>
+#include "solver.h"
+#include "algorithm.h"
+
+/**
+ * The two-phase solver on cubes a few moves from solved, where a long
+ * answer is easy to spot: every single turn has to come back as its inverse,
+ * and short sequences no longer than themselves.
+ */
+
+static int failures = 0;
+
+static void check(bool ok, const char* what, const char* detail) {
+    if (ok) return;
+    fprintf(stderr, "FAIL: %s (%s)\n", what, detail);
+    failures++;
+}
+
+// Solve the scramble with the default settings; the solution must solve it in at most maxLength moves
+static void checkSolve(const Solver* solver, const uint8_t* scramble, int count, int maxLength, const char* name) {
+    CubeState state;
+    cubeStateInit(&state);
+    cubeStateApplyMoves(&state, scramble, count);
+
+    uint8_t moves[SOLVER_MAX_LENGTH];
+    int length = solverSolve(solver, &state, SOLVER_DEFAULT_TARGET_LENGTH, SOLVER_DEFAULT_TIME_LIMIT, moves);
+    check(length >= 0, "a valid cube is solved", name);
+    if (length < 0) return;
+
+    cubeStateApplyMoves(&state, moves, length);
+    check(cubeStateIsSolved(&state), "the solution solves the cube", name);
+    check(length <= maxLength, "the solution is no longer than the scramble", name);
+}
+
+int main(void) {
+    Solver solver;
+    if (!solverInit(&solver, 0)) {
+        fprintf(stderr, "Failed to build the solver tables\n");
+        return 1;
+    }
+
+    checkSolve(&solver, NULL, 0, 0, "solved");
+    for (int m = 0; m < MOVE_COUNT; m++) {
+        uint8_t move = (uint8_t)m;
+        checkSolve(&solver, &move, 1, 1, moveName((Move)m));
+    }
+
+    const char* sequences[] = {"R U R' U'", "R U", "F2 L D'", "R U R' U R U2 R'"};
+    for (size_t i = 0; i < sizeof(sequences) / sizeof(sequences[0]); i++) {
+        uint8_t scramble[16];
+        int count = parseAlgorithm(sequences[i], scramble, 16);
+        checkSolve(&solver, scramble, count, count, sequences[i]);
+    }
+
+    solverFree(&solver);
+    if (failures == 0) printf("solver: all checks passed\n");
+    return failures == 0 ? 0 : 1;
+}
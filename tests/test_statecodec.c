@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include "statecodec.h"
+
+/**
+ * The perfect-hash codec: ranks and states map back to each other over the
+ * whole range, and the Zobrist hash kept up move by move always equals the
+ * hash of the state from scratch.
+ */
+
+#define STATE_SAMPLES 100000
+#define HASH_MOVES 100000
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    if (ok) return;
+    fprintf(stderr, "FAIL: %s\n", what);
+    failures++;
+}
+
+static uint64_t nextRandom(uint64_t* seed) {
+    uint64_t z = (*seed += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+// The rank must decode to a valid state that ranks back to it
+static bool rankRoundTrips(CubeRank rank) {
+    CubeState state;
+    return cubeStateUnrank(rank, &state) && cubeStateIsValid(&state) && cubeStateRank(&state) == rank;
+}
+
+static void testStates(uint64_t* seed) {
+    CubeState state;
+    cubeStateInit(&state);
+    check(cubeStateRank(&state) == 0, "the solved cube ranks 0");
+
+    bool ok = true;
+    for (int i = 0; i < STATE_SAMPLES && ok; i++) {
+        cubeStateApplyMove(&state, (Move)(nextRandom(seed) % MOVE_COUNT));
+        CubeRank rank = cubeStateRank(&state);
+        CubeState decoded;
+        ok = rank < CUBE_STATE_COUNT && cubeStateUnrank(rank, &decoded) && cubeStateEquals(&decoded, &state);
+    }
+    check(ok, "scrambled states round-trip through rank and unrank");
+}
+
+static void testRanks(uint64_t* seed) {
+    check(rankRoundTrips(0), "rank 0 round-trips");
+    check(rankRoundTrips(CUBE_STATE_COUNT - 1), "the last rank round-trips");
+    check(rankRoundTrips(CORNER_RANK_COUNT - 1) && rankRoundTrips(EDGE_RANK_COUNT - 1),
+          "the last corner and edge ranks round-trip");
+
+    CubeState state;
+    check(!cubeStateUnrank(CUBE_STATE_COUNT, &state), "a rank past the last is rejected");
+
+    bool ok = true;
+    for (int i = 0; i < STATE_SAMPLES && ok; i++) {
+        CubeRank rank = ((CubeRank)nextRandom(seed) << 64 | nextRandom(seed)) % CUBE_STATE_COUNT;
+        ok = rankRoundTrips(rank);
+    }
+    check(ok, "random ranks round-trip through unrank and rank");
+}
+
+static void testHash(uint64_t* seed) {
+    CubeState hashed, plain;
+    cubeStateInit(&hashed);
+    cubeStateInit(&plain);
+    uint64_t hash = cubeStateHash(&hashed);
+
+    bool ok = true;
+    for (int i = 0; i < HASH_MOVES && ok; i++) {
+        Move move = (Move)(nextRandom(seed) % MOVE_COUNT);
+        hash = cubeStateApplyMoveHashed(&hashed, hash, move);
+        cubeStateApplyMove(&plain, move);
+        ok = cubeStateEquals(&hashed, &plain) && hash == cubeStateHash(&hashed);
+    }
+    check(ok, "the incremental hash equals a full rehash after every move");
+}
+
+int main(void) {
+    uint64_t seed = 2024;
+    testStates(&seed);
+    testRanks(&seed);
+    testHash(&seed);
+
+    if (failures == 0) printf("statecodec: all checks passed\n");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,396 @@
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "batchjob.h"
+#include "workpool.h"
+
+/**
+ * Headless batch front end: one input line in, one result line out, in the
+ * same order, for millions of lines and no window.
+ *
+ *   rubik-batch apply|verify|solve|canonicalise [--input file] [--threads n]
+ *               [--batch lines] [--in-flight batches] [--tables file]
+ *               [--target-length n] [--time-limit seconds] [--antisymmetry]
+ *
+ * Lines come from stdin, or from --input, which is mapped rather than read.
+ * See batchjob.h for what a line may hold and what each command returns.
+ *
+ * The reader cuts the input into batches of lines in a fixed ring of
+ * --in-flight slots, the work pool processes batches in parallel, and a
+ * writer thread prints them strictly in input order. A slot only comes back
+ * to the reader once its output is written, so a slow consumer stalls the
+ * reader (and, through the pipe, the producer) instead of letting results
+ * pile up: memory stays at slots x batch size whatever the input size.
+ * Pages of a mapped input are dropped once their results are out.
+ *
+ * The exit status is 1 if any line failed (its result line says why).
+ */
+
+#define DEFAULT_BATCH_LINES 1024
+#define DEFAULT_IN_FLIGHT_PER_THREAD 4
+#define DEFAULT_TABLE_PATH "rubik-solver.tables"
+
+typedef enum {
+    SLOT_FREE,                          // The reader may fill it
+    SLOT_QUEUED,                        // Filled, with or being processed by a worker
+    SLOT_DONE,                          // Processed, waiting for the writer
+} SlotState;
+
+// A line as an offset from its slot's base, so a growing text buffer can move
+typedef struct {
+    size_t offset;
+    size_t length;
+} Line;
+
+typedef struct Pipeline Pipeline;
+
+typedef struct {
+    Pipeline* pipeline;
+    SlotState state;
+    Line* lines;
+    size_t lineCount;
+    const char* base;                   // text, or the mapped input
+    char* text;                         // Copies of the lines read from stdin
+    size_t textSize, textCapacity;
+    char* output;                       // Result lines, newline terminated
+    size_t outputSize;
+    size_t errors;
+    size_t mappedEnd;                   // Offset in a mapped input just past the batch's last line
+} Slot;
+
+struct Pipeline {
+    BatchOptions options;
+    WorkPool pool;
+    FILE* out;
+
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    Slot* slots;
+    size_t slotCount;
+    size_t batchLines;
+    size_t batchesRead;                 // Batches handed to the pool so far
+    bool inputDone;                     // batchesRead is final
+
+    const char* mapping;                // --input, mapped
+    size_t mappingSize;
+    size_t released;                    // Bytes of the mapping given back to the kernel
+
+    size_t lines, errors;               // Writer side totals
+    bool writeFailed;
+};
+
+static void processBatch(void* arg, int worker) {
+    (void)worker;
+    Slot* slot = arg;
+    Pipeline* pipeline = slot->pipeline;
+
+    slot->outputSize = 0;
+    slot->errors = 0;
+    for (size_t i = 0; i < slot->lineCount; i++) {
+        size_t length;
+        if (!batchProcessLine(&pipeline->options, slot->base + slot->lines[i].offset, slot->lines[i].length,
+                              slot->output + slot->outputSize, &length)) {
+            slot->errors++;
+        }
+        slot->outputSize += length;
+        slot->output[slot->outputSize++] = '\n';
+    }
+
+    pthread_mutex_lock(&pipeline->lock);
+    slot->state = SLOT_DONE;
+    pthread_cond_broadcast(&pipeline->changed);
+    pthread_mutex_unlock(&pipeline->lock);
+}
+
+// Write batches in order as they finish, handing each slot back to the reader
+static void* writerThread(void* arg) {
+    Pipeline* pipeline = arg;
+
+    for (size_t batch = 0;; batch++) {
+        Slot* slot = &pipeline->slots[batch % pipeline->slotCount];
+        pthread_mutex_lock(&pipeline->lock);
+        while (!(pipeline->inputDone && batch == pipeline->batchesRead) &&
+               !(batch < pipeline->batchesRead && slot->state == SLOT_DONE)) {
+            pthread_cond_wait(&pipeline->changed, &pipeline->lock);
+        }
+        bool finished = batch == pipeline->batchesRead;
+        pthread_mutex_unlock(&pipeline->lock);
+        if (finished) break;
+
+        if (fwrite(slot->output, 1, slot->outputSize, pipeline->out) != slot->outputSize) {
+            pipeline->writeFailed = true;
+        }
+        pipeline->lines += slot->lineCount;
+        pipeline->errors += slot->errors;
+
+        // Results are out, so the input pages behind them will not be read again
+        if (pipeline->mapping) {
+            size_t page = (size_t)sysconf(_SC_PAGESIZE);
+            size_t end = slot->mappedEnd / page * page;
+            if (end > pipeline->released) {
+                madvise((char*)pipeline->mapping + pipeline->released, end - pipeline->released, MADV_DONTNEED);
+                pipeline->released = end;
+            }
+        }
+
+        pthread_mutex_lock(&pipeline->lock);
+        slot->state = SLOT_FREE;
+        pthread_cond_broadcast(&pipeline->changed);
+        pthread_mutex_unlock(&pipeline->lock);
+    }
+
+    if (fflush(pipeline->out) != 0) pipeline->writeFailed = true;
+    return NULL;
+}
+
+// Wait for the reader's next slot to come back from the writer
+static Slot* takeSlot(Pipeline* pipeline) {
+    Slot* slot = &pipeline->slots[pipeline->batchesRead % pipeline->slotCount];
+    pthread_mutex_lock(&pipeline->lock);
+    while (slot->state != SLOT_FREE) pthread_cond_wait(&pipeline->changed, &pipeline->lock);
+    pthread_mutex_unlock(&pipeline->lock);
+
+    slot->lineCount = 0;
+    slot->textSize = 0;
+    return slot;
+}
+
+// A batch the pool cannot take is processed here, so the writer never waits on it forever
+static void submitSlot(Pipeline* pipeline, Slot* slot) {
+    pthread_mutex_lock(&pipeline->lock);
+    slot->state = SLOT_QUEUED;
+    pipeline->batchesRead++;
+    pthread_mutex_unlock(&pipeline->lock);
+    if (!workPoolSubmit(&pipeline->pool, processBatch, slot)) processBatch(slot, -1);
+}
+
+static void finishInput(Pipeline* pipeline) {
+    pthread_mutex_lock(&pipeline->lock);
+    pipeline->inputDone = true;
+    pthread_cond_broadcast(&pipeline->changed);
+    pthread_mutex_unlock(&pipeline->lock);
+}
+
+static bool appendText(Slot* slot, const char* text, size_t length) {
+    if (slot->textSize + length > slot->textCapacity) {
+        size_t capacity = slot->textCapacity ? slot->textCapacity : 4096;
+        while (capacity < slot->textSize + length) capacity *= 2;
+        char* grown = realloc(slot->text, capacity);
+        if (!grown) return false;
+        slot->text = grown;
+        slot->textCapacity = capacity;
+    }
+    memcpy(slot->text + slot->textSize, text, length);
+    slot->textSize += length;
+    return true;
+}
+
+// Lines of stdin, copied into each slot's own buffer
+static bool readStream(Pipeline* pipeline, FILE* in) {
+    char* line = NULL;
+    size_t capacity = 0;
+    ssize_t length;
+    Slot* slot = NULL;
+    bool ok = true;
+
+    while ((length = getline(&line, &capacity, in)) >= 0) {
+        if (length > 0 && line[length - 1] == '\n') length--;
+        if (!slot) slot = takeSlot(pipeline);
+
+        slot->lines[slot->lineCount].offset = slot->textSize;
+        slot->lines[slot->lineCount].length = (size_t)length;
+        if (!appendText(slot, line, (size_t)length)) {
+            fprintf(stderr, "Out of memory\n");
+            ok = false;
+            break;
+        }
+        if (++slot->lineCount == pipeline->batchLines) {
+            slot->base = slot->text;
+            submitSlot(pipeline, slot);
+            slot = NULL;
+        }
+    }
+    if (ok && slot && slot->lineCount > 0) {
+        slot->base = slot->text;
+        submitSlot(pipeline, slot);
+    }
+    free(line);
+    if (ferror(in)) {
+        fprintf(stderr, "Failed to read the input\n");
+        ok = false;
+    }
+    return ok;
+}
+
+// Lines of a mapped file, pointing straight into the mapping
+static void readMapping(Pipeline* pipeline) {
+    const char* data = pipeline->mapping;
+    size_t size = pipeline->mappingSize;
+    size_t offset = 0;
+
+    while (offset < size) {
+        Slot* slot = takeSlot(pipeline);
+        slot->base = data;
+        while (offset < size && slot->lineCount < pipeline->batchLines) {
+            const char* end = memchr(data + offset, '\n', size - offset);
+            size_t length = end ? (size_t)(end - (data + offset)) : size - offset;
+            slot->lines[slot->lineCount].offset = offset;
+            slot->lines[slot->lineCount].length = length;
+            slot->lineCount++;
+            offset += length + (end ? 1 : 0);
+        }
+        slot->mappedEnd = offset;
+        submitSlot(pipeline, slot);
+    }
+}
+
+static bool mapInput(Pipeline* pipeline, const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Could not open %s\n", path);
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        return false;
+    }
+    pipeline->mappingSize = (size_t)info.st_size;
+    if (pipeline->mappingSize == 0) {
+        close(fd);
+        return true;
+    }
+
+    void* mapping = mmap(NULL, pipeline->mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        fprintf(stderr, "Could not map %s\n", path);
+        return false;
+    }
+    madvise(mapping, pipeline->mappingSize, MADV_SEQUENTIAL);
+    pipeline->mapping = mapping;
+    return true;
+}
+
+static void usage(void) {
+    fprintf(stderr, "Usage: rubik-batch apply|verify|solve|canonicalise [--input file] [--threads n] "
+                    "[--batch lines] [--in-flight batches] [--tables file] [--target-length n] "
+                    "[--time-limit seconds] [--antisymmetry]\n");
+}
+
+int main(int argc, char* argv[]) {
+    Pipeline pipeline;
+    memset(&pipeline, 0, sizeof(pipeline));
+    pipeline.options.targetLength = SOLVER_DEFAULT_TARGET_LENGTH;
+    pipeline.options.timeLimit = SOLVER_DEFAULT_TIME_LIMIT;
+    pipeline.batchLines = DEFAULT_BATCH_LINES;
+
+    const char* inputPath = NULL;
+    const char* tablePath = DEFAULT_TABLE_PATH;
+    int threads = 0;
+    if (argc < 2 || !batchCommandFromName(argv[1], &pipeline.options.command)) {
+        usage();
+        return 1;
+    }
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--input") == 0 && i + 1 < argc) {
+            inputPath = argv[++i];
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            pipeline.batchLines = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--in-flight") == 0 && i + 1 < argc) {
+            pipeline.slotCount = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--tables") == 0 && i + 1 < argc) {
+            tablePath = argv[++i];
+        } else if (strcmp(argv[i], "--target-length") == 0 && i + 1 < argc) {
+            pipeline.options.targetLength = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--time-limit") == 0 && i + 1 < argc) {
+            pipeline.options.timeLimit = strtod(argv[++i], NULL);
+        } else if (strcmp(argv[i], "--antisymmetry") == 0) {
+            pipeline.options.antisymmetry = true;
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (pipeline.batchLines == 0) {
+        usage();
+        return 1;
+    }
+
+    Solver solver;
+    if (pipeline.options.command == BATCH_SOLVE) {
+        if (!solverInitCached(&solver, tablePath, threads)) {
+            fprintf(stderr, "Failed to build the solver tables\n");
+            return 1;
+        }
+        pipeline.options.solver = &solver;
+    }
+    if (inputPath && !mapInput(&pipeline, inputPath)) return 1;
+    if (!workPoolInit(&pipeline.pool, threads)) {
+        fprintf(stderr, "Could not start the worker threads\n");
+        return 1;
+    }
+    if (pipeline.slotCount == 0) pipeline.slotCount = (size_t)pipeline.pool.threads * DEFAULT_IN_FLIGHT_PER_THREAD;
+
+    pipeline.slots = calloc(pipeline.slotCount, sizeof(Slot));
+    bool ok = pipeline.slots != NULL;
+    for (size_t i = 0; ok && i < pipeline.slotCount; i++) {
+        Slot* slot = &pipeline.slots[i];
+        slot->pipeline = &pipeline;
+        slot->lines = malloc(sizeof(Line) * pipeline.batchLines);
+        slot->output = malloc((BATCH_MAX_OUTPUT + 1) * pipeline.batchLines);
+        ok = slot->lines && slot->output;
+    }
+    if (!ok) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    // Results leave in big writes; the writer thread is the only one touching stdout
+    pipeline.out = stdout;
+    setvbuf(stdout, NULL, _IOFBF, 1 << 20);
+    pthread_mutex_init(&pipeline.lock, NULL);
+    pthread_cond_init(&pipeline.changed, NULL);
+    pthread_t writer;
+    if (pthread_create(&writer, NULL, writerThread, &pipeline) != 0) {
+        fprintf(stderr, "Could not start the writer thread\n");
+        return 1;
+    }
+
+    if (pipeline.mapping) {
+        readMapping(&pipeline);
+    } else if (!inputPath) {
+        ok = readStream(&pipeline, stdin);
+    }
+    finishInput(&pipeline);
+    pthread_join(writer, NULL);
+    workPoolWait(&pipeline.pool);
+    workPoolDestroy(&pipeline.pool);
+
+    if (pipeline.writeFailed) {
+        fprintf(stderr, "Failed to write the output\n");
+        ok = false;
+    }
+    if (pipeline.errors > 0) {
+        fprintf(stderr, "%zu of %zu lines failed\n", pipeline.errors, pipeline.lines);
+    }
+
+    for (size_t i = 0; i < pipeline.slotCount; i++) {
+        free(pipeline.slots[i].lines);
+        free(pipeline.slots[i].text);
+        free(pipeline.slots[i].output);
+    }
+    free(pipeline.slots);
+    if (pipeline.mapping) munmap((void*)pipeline.mapping, pipeline.mappingSize);
+    if (pipeline.options.solver) solverFree(&solver);
+    pthread_mutex_destroy(&pipeline.lock);
+    pthread_cond_destroy(&pipeline.changed);
+    return ok && pipeline.errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,821 @@
+#define _GNU_SOURCE                     // accept4
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+#include "solveproto.h"
+#include "workpool.h"
+#include "clock.h"
+
+/**
+ * Long-running solver service, so a solve costs a round trip on a Unix
+ * socket rather than a process start and a table load.
+ *
+ *   rubik-daemon serve [--socket path] [--tables file] [--threads n]
+ *                      [--target-length n] [--time-limit seconds]
+ *   rubik-daemon load  [--socket path] [--op solve|apply|verify|canonicalise]
+ *                      [--clients n] [--requests n] [--depth n] [--scramble n]
+ *
+ * serve loads the pruning tables once and answers solveproto.h frames. One
+ * thread owns every socket through a level-triggered epoll loop; requests
+ * are never run there. All frames parsed in one epoll round form a batch,
+ * sorted by op and cut into one chunk per worker, so each worker runs a
+ * stretch of like requests back to back over the same tables while they
+ * are warm in its cache. Finished chunks come back through an eventfd and
+ * their responses are queued on their connections, in completion order:
+ * clients match responses to requests by id.
+ *
+ * A connection stops being read while it has SERVE_MAX_IN_FLIGHT requests
+ * running or SERVE_MAX_OUTPUT bytes unsent, so a client that pipelines
+ * without reading cannot grow the server. SIGINT or SIGTERM stops reading,
+ * lets running requests finish, answers frames already received with
+ * SOLVE_STATUS_BUSY and removes the socket.
+ *
+ * load is the matching load generator: --clients connections, each keeping
+ * --depth requests pipelined until it has sent --requests, every request a
+ * random --scramble move sequence from the solved state. Solutions are
+ * checked, and latency percentiles and throughput are printed at the end.
+ */
+
+#define DEFAULT_SOCKET_PATH "rubik-solver.sock"
+#define DEFAULT_TABLE_PATH "rubik-solver.tables"
+#define SERVE_MAX_EVENTS 64
+#define SERVE_INPUT_SIZE (64 * 1024)
+#define SERVE_MAX_IN_FLIGHT 64
+#define SERVE_MAX_OUTPUT (64 * 1024)
+#define SERVE_MAX_CHUNK 64
+#define LOAD_DEFAULT_SCRAMBLE 25
+
+typedef struct Connection {
+    int fd;
+    bool closed;                        // fd is gone; freed by the end-of-round sweep once inFlight is 0
+    bool draining;                      // Sent something unreadable: close once the output is out
+    uint32_t events;                    // What epoll is currently told to watch
+    int inFlight;
+    uint8_t* input;                     // SERVE_INPUT_SIZE bytes
+    size_t inputSize;
+    uint8_t* output;
+    size_t outputStart, outputSize, outputCapacity;
+    struct Connection *previous, *next;
+} Connection;
+
+typedef struct {
+    Connection* connection;
+    SolveFrameHeader header;
+    uint8_t payload[SOLVE_PROTO_MAX_PAYLOAD];
+    uint8_t response[SOLVE_PROTO_MAX_RESPONSE];
+    size_t responseSize;
+} Request;
+
+typedef struct Server Server;
+
+typedef struct Chunk {
+    Server* server;
+    Request** requests;
+    size_t count;
+    struct Chunk* next;
+} Chunk;
+
+struct Server {
+    SolveService service;
+    WorkPool pool;
+    int epoll, listener, signals, completions;
+    bool stopping;
+    Connection* connections;
+    Connection* closedConnections;      // Waiting for the sweep: this round's events may still name them
+
+    Request** batch;                    // Parsed this round, not yet dispatched
+    size_t batchSize, batchCapacity;
+
+    pthread_mutex_t lock;               // Guards finished only
+    Chunk* finished;
+
+    uint64_t served;
+};
+
+// Worker side: run a chunk of requests back to back and hand it back to the loop
+static void runChunk(void* arg, int worker) {
+    (void)worker;
+    Chunk* chunk = arg;
+    Server* server = chunk->server;
+
+    for (size_t i = 0; i < chunk->count; i++) {
+        Request* request = chunk->requests[i];
+        request->responseSize = solveProtoExecute(&server->service, &request->header, request->payload,
+                                                  request->response);
+    }
+
+    pthread_mutex_lock(&server->lock);
+    chunk->next = server->finished;
+    server->finished = chunk;
+    pthread_mutex_unlock(&server->lock);
+    uint64_t one = 1;
+    if (write(server->completions, &one, sizeof(one)) != sizeof(one)) perror("eventfd");
+}
+
+// Tell epoll what the connection can take right now
+static void updateInterest(Server* server, Connection* connection) {
+    if (connection->closed) return;
+
+    uint32_t events = 0;
+    bool throttled = connection->inFlight >= SERVE_MAX_IN_FLIGHT || connection->outputSize >= SERVE_MAX_OUTPUT;
+    if (!server->stopping && !connection->draining && !throttled) events |= EPOLLIN;
+    if (connection->outputSize > 0) events |= EPOLLOUT;
+    if (events == connection->events) return;
+
+    struct epoll_event event = {.events = events, .data.ptr = connection};
+    epoll_ctl(server->epoll, EPOLL_CTL_MOD, connection->fd, &event);
+    connection->events = events;
+}
+
+static void freeConnection(Connection* connection) {
+    free(connection->input);
+    free(connection->output);
+    free(connection);
+}
+
+// Drop the socket; the Connection itself lives on while workers still hold its requests
+static void closeConnection(Server* server, Connection* connection) {
+    if (connection->closed) return;
+
+    epoll_ctl(server->epoll, EPOLL_CTL_DEL, connection->fd, NULL);
+    close(connection->fd);
+    connection->closed = true;
+    if (connection->previous) {
+        connection->previous->next = connection->next;
+    } else {
+        server->connections = connection->next;
+    }
+    if (connection->next) connection->next->previous = connection->previous;
+    connection->previous = NULL;
+    connection->next = server->closedConnections;
+    server->closedConnections = connection;
+}
+
+// Free the closed connections no request refers to any more
+static void sweepConnections(Server* server) {
+    Connection** link = &server->closedConnections;
+    while (*link) {
+        Connection* connection = *link;
+        if (connection->inFlight == 0) {
+            *link = connection->next;
+            freeConnection(connection);
+        } else {
+            link = &connection->next;
+        }
+    }
+}
+
+static bool queueOutput(Connection* connection, const void* data, size_t size) {
+    if (connection->outputStart > 0 && connection->outputStart + connection->outputSize + size > connection->outputCapacity) {
+        memmove(connection->output, connection->output + connection->outputStart, connection->outputSize);
+        connection->outputStart = 0;
+    }
+    if (connection->outputSize + size > connection->outputCapacity) {
+        size_t capacity = connection->outputCapacity ? connection->outputCapacity : 4096;
+        while (capacity < connection->outputSize + size) capacity *= 2;
+        uint8_t* grown = realloc(connection->output, capacity);
+        if (!grown) return false;
+        connection->output = grown;
+        connection->outputCapacity = capacity;
+    }
+    memcpy(connection->output + connection->outputStart + connection->outputSize, data, size);
+    connection->outputSize += size;
+    return true;
+}
+
+// Write as much queued output as the socket takes; false if the connection was closed
+static bool flushOutput(Server* server, Connection* connection) {
+    while (connection->outputSize > 0) {
+        ssize_t sent = send(connection->fd, connection->output + connection->outputStart, connection->outputSize,
+                            MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            closeConnection(server, connection);
+            return false;
+        }
+        connection->outputStart += (size_t)sent;
+        connection->outputSize -= (size_t)sent;
+    }
+    if (connection->outputSize == 0) {
+        connection->outputStart = 0;
+        if (connection->draining) {
+            closeConnection(server, connection);
+            return false;
+        }
+    }
+    updateInterest(server, connection);
+    return true;
+}
+
+static void respondDirectly(Connection* connection, const SolveFrameHeader* request, SolveStatus status) {
+    SolveFrameHeader response = {0, request->id, request->op, (uint8_t)status, SOLVE_PROTO_VERSION, 0};
+    queueOutput(connection, &response, sizeof(response));
+}
+
+static bool addToBatch(Server* server, Request* request) {
+    if (server->batchSize == server->batchCapacity) {
+        size_t capacity = server->batchCapacity ? server->batchCapacity * 2 : 256;
+        Request** grown = realloc(server->batch, capacity * sizeof(Request*));
+        if (!grown) return false;
+        server->batch = grown;
+        server->batchCapacity = capacity;
+    }
+    server->batch[server->batchSize++] = request;
+    return true;
+}
+
+/**
+ * Turn the complete frames buffered on a connection into requests for this
+ * round's batch, up to the connection's in-flight limit; while stopping they
+ * are answered busy instead. A header that cannot be trusted gets a bad
+ * request response and the connection is drained and closed, since the
+ * rest of the stream cannot be framed.
+ */
+static void parseFrames(Server* server, Connection* connection) {
+    size_t offset = 0;
+    while (!connection->draining && connection->inputSize - offset >= sizeof(SolveFrameHeader)) {
+        SolveFrameHeader header;
+        memcpy(&header, connection->input + offset, sizeof(header));
+        if (!solveProtoRequestValid(&header)) {
+            respondDirectly(connection, &header, SOLVE_STATUS_BAD_REQUEST);
+            connection->draining = true;
+            break;
+        }
+        size_t frameSize = sizeof(header) + header.length;
+        if (connection->inputSize - offset < frameSize) break;
+        if (server->stopping) {
+            respondDirectly(connection, &header, SOLVE_STATUS_BUSY);
+            offset += frameSize;
+            continue;
+        }
+        if (connection->inFlight >= SERVE_MAX_IN_FLIGHT) break;
+
+        Request* request = malloc(sizeof(Request));
+        if (!request || !addToBatch(server, request)) {
+            free(request);
+            break;
+        }
+        request->connection = connection;
+        request->header = header;
+        memcpy(request->payload, connection->input + offset + sizeof(header), header.length);
+        connection->inFlight++;
+        offset += frameSize;
+    }
+
+    connection->inputSize -= offset;
+    if (offset > 0 && connection->inputSize > 0) {
+        memmove(connection->input, connection->input + offset, connection->inputSize);
+    }
+}
+
+// One read per readiness event, so a busy client cannot starve the others in a round
+static void readConnection(Server* server, Connection* connection) {
+    if (connection->inputSize == SERVE_INPUT_SIZE) {
+        parseFrames(server, connection);
+        updateInterest(server, connection);
+        return;
+    }
+    ssize_t received = recv(connection->fd, connection->input + connection->inputSize,
+                            SERVE_INPUT_SIZE - connection->inputSize, 0);
+    if (received == 0 || (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+        closeConnection(server, connection);
+        return;
+    }
+    if (received > 0) connection->inputSize += (size_t)received;
+    parseFrames(server, connection);
+    if (connection->outputSize > 0) {
+        flushOutput(server, connection);
+    } else {
+        updateInterest(server, connection);
+    }
+}
+
+static void acceptConnections(Server* server) {
+    for (;;) {
+        int fd = accept4(server->listener, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) perror("accept");
+            return;
+        }
+
+        Connection* connection = calloc(1, sizeof(Connection));
+        if (connection) connection->input = malloc(SERVE_INPUT_SIZE);
+        if (!connection || !connection->input) {
+            fprintf(stderr, "Out of memory, refusing a connection\n");
+            free(connection);
+            close(fd);
+            continue;
+        }
+        connection->fd = fd;
+        connection->events = EPOLLIN;
+        struct epoll_event event = {.events = EPOLLIN, .data.ptr = connection};
+        if (epoll_ctl(server->epoll, EPOLL_CTL_ADD, fd, &event) != 0) {
+            freeConnection(connection);
+            close(fd);
+            continue;
+        }
+        connection->next = server->connections;
+        if (server->connections) server->connections->previous = connection;
+        server->connections = connection;
+    }
+}
+
+static int compareRequests(const void* a, const void* b) {
+    const Request* first = *(Request* const*)a;
+    const Request* second = *(Request* const*)b;
+    if (first->header.op != second->header.op) return first->header.op < second->header.op ? -1 : 1;
+    return 0;
+}
+
+static void finishRequest(Server* server, Request* request) {
+    Connection* connection = request->connection;
+    connection->inFlight--;
+    server->served++;
+    if (!connection->closed) queueOutput(connection, request->response, request->responseSize);
+    free(request);
+}
+
+// Answer requests on this thread: slow, but every client still gets its answers
+static void runInline(Server* server, Request** requests, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        Request* request = requests[i];
+        Connection* connection = request->connection;
+        request->responseSize = solveProtoExecute(&server->service, &request->header, request->payload,
+                                                  request->response);
+        finishRequest(server, request);
+        if (!connection->closed) flushOutput(server, connection);
+    }
+}
+
+/**
+ * Sort the round's batch by op and deal it out as one contiguous chunk per
+ * worker. Chunks go through the pool's inbox, oldest first, so earlier
+ * rounds are never starved by later ones.
+ */
+static void dispatchBatch(Server* server) {
+    size_t count = server->batchSize;
+    if (count == 0) return;
+
+    qsort(server->batch, count, sizeof(Request*), compareRequests);
+    size_t chunkSize = (count + (size_t)server->pool.threads - 1) / (size_t)server->pool.threads;
+    if (chunkSize > SERVE_MAX_CHUNK) chunkSize = SERVE_MAX_CHUNK;
+
+    for (size_t start = 0; start < count; start += chunkSize) {
+        size_t size = count - start < chunkSize ? count - start : chunkSize;
+        Chunk* chunk = malloc(sizeof(Chunk) + size * sizeof(Request*));
+        if (!chunk) {
+            runInline(server, server->batch + start, size);
+            continue;
+        }
+        chunk->server = server;
+        chunk->requests = (Request**)(chunk + 1);
+        chunk->count = size;
+        memcpy(chunk->requests, server->batch + start, size * sizeof(Request*));
+        if (!workPoolSubmit(&server->pool, runChunk, chunk)) {
+            free(chunk);
+            runInline(server, server->batch + start, size);
+        }
+    }
+    server->batchSize = 0;
+}
+
+// Queue the responses of every finished chunk on their connections and send what the sockets take
+static void collectCompletions(Server* server) {
+    uint64_t counter;
+    if (read(server->completions, &counter, sizeof(counter)) < 0 && errno != EAGAIN) perror("eventfd");
+
+    pthread_mutex_lock(&server->lock);
+    Chunk* chunk = server->finished;
+    server->finished = NULL;
+    pthread_mutex_unlock(&server->lock);
+
+    while (chunk) {
+        Chunk* next = chunk->next;
+        for (size_t i = 0; i < chunk->count; i++) finishRequest(server, chunk->requests[i]);
+        free(chunk);
+        chunk = next;
+    }
+
+    // Flush after queueing everything, so a connection with many answers gets one big send
+    Connection* connection = server->connections;
+    while (connection) {
+        Connection* next = connection->next;
+        if (connection->outputSize > 0 || connection->inputSize > 0) {
+            parseFrames(server, connection);
+            flushOutput(server, connection);
+        } else {
+            updateInterest(server, connection);
+        }
+        connection = next;
+    }
+}
+
+static int listenOn(const char* path) {
+    struct sockaddr_un address = {.sun_family = AF_UNIX};
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "Socket path too long: %s\n", path);
+        return -1;
+    }
+    strcpy(address.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+
+    // A socket file nobody answers on is left over from a crash; one that answers is a running server
+    int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (probe >= 0 && connect(probe, (struct sockaddr*)&address, sizeof(address)) == 0) {
+        fprintf(stderr, "A server is already listening on %s\n", path);
+        close(probe);
+        close(fd);
+        return -1;
+    }
+    if (probe >= 0) close(probe);
+    unlink(path);
+
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        fprintf(stderr, "Could not listen on %s: %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool watch(int epoll, int fd, void* tag) {
+    struct epoll_event event = {.events = EPOLLIN, .data.ptr = tag};
+    return epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event) == 0;
+}
+
+static int serve(int argc, char* argv[]) {
+    const char* socketPath = DEFAULT_SOCKET_PATH;
+    const char* tablePath = DEFAULT_TABLE_PATH;
+    int threads = 0;
+    Server server;
+    memset(&server, 0, sizeof(server));
+    server.service.targetLength = SOLVER_DEFAULT_TARGET_LENGTH;
+    server.service.timeLimit = SOLVER_DEFAULT_TIME_LIMIT;
+
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            socketPath = argv[++i];
+        } else if (strcmp(argv[i], "--tables") == 0 && i + 1 < argc) {
+            tablePath = argv[++i];
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--target-length") == 0 && i + 1 < argc) {
+            server.service.targetLength = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--time-limit") == 0 && i + 1 < argc) {
+            server.service.timeLimit = strtod(argv[++i], NULL);
+        } else {
+            return -1;
+        }
+    }
+
+    // Blocked before any thread exists, so only the signalfd ever sees them
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &mask, NULL);
+
+    // Listen first: clients that connect while the tables load just wait in the backlog
+    server.listener = listenOn(socketPath);
+    if (server.listener < 0) return 1;
+
+    Solver solver;
+    double start = clockSeconds();
+    if (!solverInitCached(&solver, tablePath, threads)) {
+        fprintf(stderr, "Failed to build the solver tables\n");
+        unlink(socketPath);
+        return 1;
+    }
+    server.service.solver = &solver;
+    fprintf(stderr, "Tables ready in %.2f s\n", clockSeconds() - start);
+    server.epoll = epoll_create1(EPOLL_CLOEXEC);
+    server.signals = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    server.completions = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (server.epoll < 0 || server.signals < 0 || server.completions < 0 ||
+        !watch(server.epoll, server.listener, &server.listener) || !watch(server.epoll, server.signals, &server.signals) ||
+        !watch(server.epoll, server.completions, &server.completions)) {
+        perror("epoll");
+        unlink(socketPath);
+        return 1;
+    }
+    if (!workPoolInit(&server.pool, threads)) {
+        fprintf(stderr, "Could not start the worker threads\n");
+        unlink(socketPath);
+        return 1;
+    }
+    pthread_mutex_init(&server.lock, NULL);
+    fprintf(stderr, "Listening on %s with %d workers\n", socketPath, server.pool.threads);
+
+    struct epoll_event events[SERVE_MAX_EVENTS];
+    while (!server.stopping) {
+        int count = epoll_wait(server.epoll, events, SERVE_MAX_EVENTS, -1);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            break;
+        }
+
+        for (int i = 0; i < count; i++) {
+            void* tag = events[i].data.ptr;
+            if (tag == &server.listener) {
+                acceptConnections(&server);
+            } else if (tag == &server.signals) {
+                server.stopping = true;
+            } else if (tag == &server.completions) {
+                collectCompletions(&server);
+            } else {
+                Connection* connection = tag;
+                if (connection->closed) continue;
+                if ((events[i].events & (EPOLLERR | EPOLLHUP)) && !(events[i].events & EPOLLIN)) {
+                    closeConnection(&server, connection);
+                    continue;
+                }
+                if ((events[i].events & EPOLLOUT) && !flushOutput(&server, connection)) continue;
+                if (events[i].events & EPOLLIN) readConnection(&server, connection);
+            }
+        }
+        dispatchBatch(&server);
+        sweepConnections(&server);
+    }
+
+    // Stop taking work, let what is running finish, and answer what is left busy
+    close(server.listener);
+    unlink(socketPath);
+    workPoolWait(&server.pool);
+    collectCompletions(&server);
+    fprintf(stderr, "Stopped after %llu requests\n", (unsigned long long)server.served);
+
+    while (server.connections) closeConnection(&server, server.connections);
+    sweepConnections(&server);
+    workPoolDestroy(&server.pool);
+    pthread_mutex_destroy(&server.lock);
+    free(server.batch);
+    close(server.completions);
+    close(server.signals);
+    close(server.epoll);
+    solverFree(&solver);
+    return 0;
+}
+
+typedef struct {
+    const char* socketPath;
+    SolveOp op;
+    int requests, depth, scramble;
+    unsigned seed;
+
+    double* latencies;                  // Seconds, one per response
+    int received;
+    int failures;                       // Error statuses and wrong answers
+    bool broken;                        // The connection failed
+} LoadClient;
+
+static bool sendAll(int fd, const uint8_t* data, size_t size) {
+    while (size > 0) {
+        ssize_t sent = send(fd, data, size, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) return false;
+        data += sent;
+        size -= (size_t)sent;
+    }
+    return true;
+}
+
+static bool receiveAll(int fd, uint8_t* data, size_t size) {
+    while (size > 0) {
+        ssize_t received = recv(fd, data, size, 0);
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) return false;
+        data += received;
+        size -= (size_t)received;
+    }
+    return true;
+}
+
+// Whether a response is the right answer to the scramble it was sent with
+static bool checkResponse(SolveOp op, const SolveFrameHeader* header, const uint8_t* payload,
+                          const uint8_t* scramble, int scrambleLength) {
+    if (header->status != SOLVE_STATUS_OK) return false;
+
+    CubeState state;
+    cubeStateInit(&state);
+    cubeStateApplyMoves(&state, scramble, scrambleLength);
+    switch (op) {
+        case SOLVE_OP_SOLVE:
+            for (uint32_t i = 0; i < header->length; i++) {
+                if (payload[i] >= MOVE_COUNT) return false;
+            }
+            cubeStateApplyMoves(&state, payload, (int)header->length);
+            return cubeStateIsSolved(&state);
+        case SOLVE_OP_APPLY:
+            return header->length == (uint32_t)SOLVE_PROTO_STATE_SIZE && memcmp(payload, &state, sizeof(state)) == 0;
+        case SOLVE_OP_VERIFY:
+            return header->length == 1 && payload[0] == cubeStateIsSolved(&state);
+        case SOLVE_OP_CANONICALISE:
+            return header->length == (uint32_t)SOLVE_PROTO_STATE_SIZE;
+    }
+    return false;
+}
+
+static void* loadClientThread(void* arg) {
+    LoadClient* client = arg;
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    struct sockaddr_un address = {.sun_family = AF_UNIX};
+    strncpy(address.sun_path, client->socketPath, sizeof(address.sun_path) - 1);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        fprintf(stderr, "Could not connect to %s: %s\n", client->socketPath, strerror(errno));
+        if (fd >= 0) close(fd);
+        client->broken = true;
+        return NULL;
+    }
+
+    // Requests are numbered from 0, so the id indexes the scramble and the send time
+    uint8_t* scrambles = malloc((size_t)client->requests * (size_t)client->scramble);
+    double* sent = malloc((size_t)client->requests * sizeof(double));
+    if (!scrambles || !sent) {
+        free(scrambles);
+        free(sent);
+        close(fd);
+        client->broken = true;
+        return NULL;
+    }
+
+    CubeState solved;
+    cubeStateInit(&solved);
+    uint8_t frame[sizeof(SolveFrameHeader) + SOLVE_PROTO_MAX_PAYLOAD];
+    uint8_t payload[SOLVE_PROTO_MAX_RESPONSE];
+    int next = 0;
+    while (client->received < client->requests) {
+        while (next < client->requests && next - client->received < client->depth) {
+            uint8_t* scramble = scrambles + (size_t)next * (size_t)client->scramble;
+            for (int i = 0; i < client->scramble; i++) {
+                Move move;
+                do {
+                    move = (Move)(rand_r(&client->seed) % MOVE_COUNT);
+                } while (i > 0 && moveIsRedundant((Move)scramble[i - 1], move));
+                scramble[i] = (uint8_t)move;
+            }
+            size_t size = solveProtoEncodeRequest(client->op, (uint32_t)next, 0, &solved, scramble,
+                                                  client->scramble, frame);
+            sent[next] = clockSeconds();
+            if (!sendAll(fd, frame, size)) break;
+            next++;
+        }
+
+        SolveFrameHeader header;
+        if (!receiveAll(fd, (uint8_t*)&header, sizeof(header)) || header.length > sizeof(payload) ||
+            !receiveAll(fd, payload, header.length)) {
+            client->broken = true;
+            break;
+        }
+        if (header.id >= (uint32_t)next) {
+            client->broken = true;
+            break;
+        }
+        client->latencies[client->received++] = clockSeconds() - sent[header.id];
+        if (!checkResponse(client->op, &header, payload, scrambles + (size_t)header.id * (size_t)client->scramble,
+                           client->scramble)) {
+            client->failures++;
+        }
+    }
+
+    free(scrambles);
+    free(sent);
+    close(fd);
+    return NULL;
+}
+
+static int compareLatencies(const void* a, const void* b) {
+    double first = *(const double*)a;
+    double second = *(const double*)b;
+    return (first > second) - (first < second);
+}
+
+static bool opFromName(const char* name, SolveOp* op) {
+    static const char* names[] = {"solve", "apply", "verify", "canonicalise"};
+    for (int i = 0; i < 4; i++) {
+        if (strcmp(name, names[i]) == 0) {
+            *op = (SolveOp)(SOLVE_OP_SOLVE + i);
+            return true;
+        }
+    }
+    return false;
+}
+
+static int load(int argc, char* argv[]) {
+    const char* socketPath = DEFAULT_SOCKET_PATH;
+    SolveOp op = SOLVE_OP_SOLVE;
+    int clients = 4, requests = 1000, depth = 8, scramble = LOAD_DEFAULT_SCRAMBLE;
+
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            socketPath = argv[++i];
+        } else if (strcmp(argv[i], "--op") == 0 && i + 1 < argc) {
+            if (!opFromName(argv[++i], &op)) return -1;
+        } else if (strcmp(argv[i], "--clients") == 0 && i + 1 < argc) {
+            clients = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--requests") == 0 && i + 1 < argc) {
+            requests = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--depth") == 0 && i + 1 < argc) {
+            depth = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--scramble") == 0 && i + 1 < argc) {
+            scramble = atoi(argv[++i]);
+        } else {
+            return -1;
+        }
+    }
+    if (clients <= 0 || requests <= 0 || depth <= 0 || scramble < 0 || scramble > SOLVE_PROTO_MAX_MOVES) return -1;
+
+    LoadClient* loadClients = calloc((size_t)clients, sizeof(LoadClient));
+    double* latencies = malloc((size_t)clients * (size_t)requests * sizeof(double));
+    pthread_t* threads = malloc((size_t)clients * sizeof(pthread_t));
+    if (!loadClients || !latencies || !threads) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    double start = clockSeconds();
+    int started = 0;
+    for (int i = 0; i < clients; i++) {
+        LoadClient* client = &loadClients[i];
+        client->socketPath = socketPath;
+        client->op = op;
+        client->requests = requests;
+        client->depth = depth;
+        client->scramble = scramble;
+        client->seed = (unsigned)i * 2654435761u + (unsigned)time(NULL);
+        client->latencies = latencies + (size_t)i * (size_t)requests;
+        if (pthread_create(&threads[i], NULL, loadClientThread, client) != 0) break;
+        started++;
+    }
+    for (int i = 0; i < started; i++) pthread_join(threads[i], NULL);
+    double elapsed = clockSeconds() - start;
+
+    // Gather every latency into one sorted run for exact percentiles
+    size_t total = 0;
+    int failures = 0, broken = clients - started;
+    for (int i = 0; i < started; i++) {
+        memmove(latencies + total, loadClients[i].latencies, (size_t)loadClients[i].received * sizeof(double));
+        total += (size_t)loadClients[i].received;
+        failures += loadClients[i].failures;
+        broken += loadClients[i].broken;
+    }
+    qsort(latencies, total, sizeof(double), compareLatencies);
+
+    printf("%zu responses from %d clients (depth %d) in %.3f s: %.0f requests/s\n",
+           total, clients, depth, elapsed, elapsed > 0.0 ? (double)total / elapsed : 0.0);
+    if (total > 0) {
+        static const double ranks[] = {50.0, 95.0, 99.0};
+        printf("latency ms:");
+        for (int i = 0; i < 3; i++) {
+            size_t index = (size_t)(ranks[i] / 100.0 * (double)total + 0.999999);
+            printf(" p%.0f %.3f", ranks[i], latencies[(index > 0 ? index : 1) - 1] * 1000.0);
+        }
+        printf(" max %.3f\n", latencies[total - 1] * 1000.0);
+    }
+    if (failures > 0) printf("%d responses were errors or wrong\n", failures);
+    if (broken > 0) printf("%d clients lost their connection\n", broken);
+
+    free(loadClients);
+    free(latencies);
+    free(threads);
+    return failures == 0 && broken == 0 ? 0 : 1;
+}
+
+static void usage(void) {
+    fprintf(stderr, "Usage: rubik-daemon serve [--socket path] [--tables file] [--threads n] "
+                    "[--target-length n] [--time-limit seconds]\n"
+                    "       rubik-daemon load [--socket path] [--op solve|apply|verify|canonicalise] "
+                    "[--clients n] [--requests n] [--depth n] [--scramble n]\n");
+}
+
+int main(int argc, char* argv[]) {
+    int status = -1;
+    if (argc >= 2 && strcmp(argv[1], "serve") == 0) {
+        status = serve(argc - 2, argv + 2);
+    } else if (argc >= 2 && strcmp(argv[1], "load") == 0) {
+        status = load(argc - 2, argv + 2);
+    }
+    if (status < 0) {
+        usage();
+        return 1;
+    }
+    return status;
+}